@@ -0,0 +1,200 @@
+/*!
+ *  @file SlipAdaptive.h
+ *
+ *  Per-stream kernel selection from the sampled special-character density.
+ *
+ *  Host-only. Not included by SlipInPlace.h.
+ */
+
+#pragma once
+
+#ifndef __SLIPADAPTIVE_H__
+    #define __SLIPADAPTIVE_H__
+
+    #include "SlipKernels.h"
+    #include <algorithm>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Adaptive selection policy and counters
+     **************************************************************************************/
+
+    /** Tuning knobs for adaptive_encoder and adaptive_decoder. */
+    struct adaptive_params {
+        size_t sample_size     = 256;   ///< bytes sampled at the start of each frame
+        size_t min_vector_size = 64;    ///< frames shorter than this always use the scalar kernel
+        double smoothing       = 0.25;  ///< weight of the newest sample in the running density
+        double sparse_density  = 0.003; ///< run-skipping below this density, expand/compress above
+        double scalar_density  = 0.05;  ///< without expand/compress: run-skipping below, scalar above
+    };
+
+    /** Decisions made by an adaptive codec since construction or reset(). */
+    struct adaptive_counters {
+        uint64_t frames  = 0; ///< frames encoded or decoded
+        uint64_t bytes   = 0; ///< source bytes encoded or decoded
+        uint64_t sampled = 0; ///< source bytes inspected while sampling
+        uint64_t chosen[static_cast<int>(kernel_id::num_kernels)] = {}; ///< frames handed to each kernel
+        double density = 0;   ///< running special-character density
+    };
+
+    /**
+     * @brief Shared sampling and selection logic for the adaptive codecs.
+     *
+     * Keeps a running estimate of the special-character density, updated from the
+     * first block of every frame. It maps the estimate onto the fastest kernel of the
+     * matching class supported by this host:
+     *  - short frames: scalar
+     *  - sparse: run-skipping (avx2, then sse2)
+     *  - dense: expand/compress (avx512vbmi2)
+     *
+     * Expand/compress beats run-skipping once specials are more frequent than
+     * about one in 300 bytes. Without it, run-skipping beats scalar code up to
+     * about one special in 20 bytes.
+     */
+    class adaptive_selector {
+     public:
+        adaptive_selector(const adaptive_params& params = adaptive_params()) noexcept
+            : _params(params), _run_skip(kernel_id::scalar), _dense(kernel_id::scalar) {
+            if (kernel_supported(kernel_id::sse2)) _run_skip = kernel_id::sse2;
+            if (kernel_supported(kernel_id::avx2)) _run_skip = kernel_id::avx2;
+            if (kernel_supported(kernel_id::avx512vbmi2)) _dense = kernel_id::avx512vbmi2;
+        }
+
+        const adaptive_params& params() const noexcept { return _params; }
+        const adaptive_counters& counters() const noexcept { return _counters; }
+
+        /** Forget the running density and clear all counters. */
+        void reset() noexcept {
+            _counters = adaptive_counters();
+            _primed   = false;
+        }
+
+     protected:
+        /**
+         * Choose the kernel for a frame of srcsize bytes from the running density,
+         * without sampling or counting anything.
+         */
+        kernel_id pick(size_t srcsize) const noexcept {
+            if (srcsize < _params.min_vector_size) return kernel_id::scalar;
+            if (_dense != kernel_id::scalar) return (_counters.density < _params.sparse_density) ? _run_skip : _dense;
+            return (_counters.density < _params.scalar_density) ? _run_skip : kernel_id::scalar;
+        }
+
+        /**
+         * Update the running density with nspecial specials found in nsampled
+         * bytes and choose the kernel for a frame of srcsize bytes.
+         */
+        kernel_id choose(size_t srcsize, size_t nspecial, size_t nsampled) noexcept {
+            if (nsampled > 0) {
+                double sample = double(nspecial) / double(nsampled);
+                _counters.density = _primed ? _counters.density + _params.smoothing * (sample - _counters.density) : sample;
+                _primed           = true;
+            }
+            kernel_id k = pick(srcsize);
+            _counters.frames++;
+            _counters.bytes += srcsize;
+            _counters.sampled += nsampled;
+            _counters.chosen[static_cast<int>(k)]++;
+            return k;
+        }
+
+        adaptive_params _params;
+        adaptive_counters _counters;
+        kernel_id _run_skip, _dense;
+        bool _primed = false;
+    };
+
+    /**************************************************************************************
+     * Adaptive encoder
+     **************************************************************************************/
+
+    /**
+     * @brief Stream encoder that picks its kernel frame by frame.
+     *
+     * Unlike encoder_base, this is an object: the density estimate and counters
+     * belong to one stream or link.
+     *
+     * @tparam ENCODER  the encoder_base type to accelerate
+     */
+    template <class ENCODER>
+    class adaptive_encoder : public adaptive_selector {
+     public:
+        using char_type = typename ENCODER::char_type;
+        using adaptive_selector::adaptive_selector;
+
+        /** @copydoc encoder_base::encoded_size */
+        size_t encoded_size(const char_type* src, size_t srcsize) const noexcept {
+            return size_fn(pick(srcsize))(src, srcsize); // sizing a frame does not count it
+        }
+
+        /** @copydoc encoder_base::encode */
+        size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            if (!src) return ENCODER::encode(dest, destsize, src, srcsize);
+            return code_fn(select(src, srcsize))(dest, destsize, src, srcsize);
+        }
+
+     protected:
+        kernel_id select(const char_type* src, size_t srcsize) noexcept {
+            size_t n = std::min(srcsize, _params.sample_size);
+            return choose(srcsize, kernel_base<ENCODER>::count_specials(src, src + n), n);
+        }
+        static typename kernels<ENCODER>::code_fn code_fn(kernel_id k) noexcept {
+            auto fn = kernels<ENCODER>::encode(k);
+            return fn ? fn : static_cast<typename kernels<ENCODER>::code_fn>(&ENCODER::encode);
+        }
+        static typename kernels<ENCODER>::size_fn size_fn(kernel_id k) noexcept {
+            auto fn = kernels<ENCODER>::encoded_size(k);
+            return fn ? fn : static_cast<typename kernels<ENCODER>::size_fn>(&ENCODER::encoded_size);
+        }
+    };
+
+    /**************************************************************************************
+     * Adaptive decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Stream decoder that picks its kernel frame by frame.
+     *
+     * The density is that of ESC codes in the encoded stream.
+     *
+     * @tparam DECODER  the decoder_base type to accelerate
+     */
+    template <class DECODER>
+    class adaptive_decoder : public adaptive_selector {
+     public:
+        using char_type = typename DECODER::char_type;
+        using adaptive_selector::adaptive_selector;
+
+        /** @copydoc decoder_base::decoded_size */
+        size_t decoded_size(const char_type* src, size_t srcsize) const noexcept {
+            return size_fn(pick(srcsize))(src, srcsize); // sizing a frame does not count it
+        }
+
+        /** @copydoc decoder_base::decode */
+        size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            if (!src) return DECODER::decode(dest, destsize, src, srcsize);
+            return code_fn(select(src, srcsize))(dest, destsize, src, srcsize);
+        }
+
+     protected:
+        kernel_id select(const char_type* src, size_t srcsize) noexcept {
+            size_t n = std::min(srcsize, _params.sample_size), nesc = 0;
+            for (size_t i = 0; i < n; i++) {
+                if (src[i] == DECODER::esc_code()) nesc++;
+            }
+            return choose(srcsize, nesc, n);
+        }
+        static typename kernels<DECODER>::code_fn code_fn(kernel_id k) noexcept {
+            auto fn = kernels<DECODER>::decode(k);
+            return fn ? fn : static_cast<typename kernels<DECODER>::code_fn>(&DECODER::decode);
+        }
+        static typename kernels<DECODER>::size_fn size_fn(kernel_id k) noexcept {
+            auto fn = kernels<DECODER>::decoded_size(k);
+            return fn ? fn : static_cast<typename kernels<DECODER>::size_fn>(&DECODER::decoded_size);
+        }
+    };
+
+}
+
+#endif // __SLIPADAPTIVE_H__
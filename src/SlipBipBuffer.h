@@ -0,0 +1,217 @@
+/*!
+ *  @file SlipBipBuffer.h
+ *
+ *  Receive buffer that keeps every SLIP frame contiguous, so frames decode in
+ *  place without compacting the buffer after each read.
+ */
+
+#pragma once
+
+#ifndef __SLIPBIPBUFFER_H__
+    #define __SLIPBIPBUFFER_H__
+
+    #include "SlipInPlace.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * Bip-buffer receive manager
+     **************************************************************************************/
+
+    /**
+     * @brief Two-region circular receive buffer with in-place frame decoding.
+     *
+     * The driver asks reserve() for contiguous room, reads or DMAs into it and
+     * reports the byte count with commit(). next() finds each END and decodes the
+     * frame in place with DECODER::decode(dest == src), so the returned frame is
+     * one contiguous span in the buffer. Frames stay valid until release(), which
+     * must follow the order next() returned them. Released space is reused without
+     * moving any held frame.
+     *
+     * Like any bip-buffer, writing continues after the newest data (region A) until
+     * there is more free room at the front of the buffer. Then writing moves to the
+     * front (region B). Only the one partly received frame at the end of A is copied
+     * to the front at that point. That is one copy of at most one frame per trip
+     * around the buffer, instead of a compaction after every read.
+     *
+     * Empty frames are skipped. Frames with bad escapes, and frames that cannot fit
+     * in the buffer, are dropped and counted in errors(). Not thread-safe: for
+     * interrupt handoff use spsc_ring.
+     *
+     * @tparam N        buffer size in characters
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <size_t N, class DECODER = decoder>
+    class bip_receiver {
+        static_assert(N >= 2, "receive buffer too small");
+
+     public:
+        using char_type = typename DECODER::char_type;
+
+        /** A decoded frame held in the buffer until release(). */
+        struct frame {
+            char_type* data  = nullptr; ///< decoded frame
+            size_t size      = 0;       ///< decoded size
+            size_t end_index = 0;       ///< buffer index just past the frame's END, used by release()
+        };
+
+        static constexpr size_t capacity = N;
+
+        /**
+         * @brief Contiguous free room for the next read.
+         *
+         * @param room      set to the number of characters that may be written
+         * @return char_type*   where to write them
+         */
+        char_type* reserve(size_t& room) noexcept {
+            if (!_b_active && _a_start > N - _a_end) wrap();
+            room = _b_active ? _a_start - _b_end : N - _a_end;
+            if (room == 0 && _held_a + _held_b == 0 && !unparsed_end()) {
+                drop_partial();
+                room = N;
+            }
+            return _buf + (_b_active ? _b_end : _a_end);
+        }
+
+        /** Mark n characters written at the last reserve() as received. */
+        void commit(size_t n) noexcept {
+            if (_b_active)
+                _b_end += n;
+            else
+                _a_end += n;
+        }
+
+        /**
+         * @brief Copy received characters in through reserve() and commit().
+         * @return size_t   characters accepted. Fewer than n if held frames fill the buffer.
+         */
+        size_t write(const char_type* src, size_t n) noexcept {
+            size_t done = 0;
+            while (done < n) {
+                size_t room;
+                char_type* at = reserve(room);
+                if (room == 0) break;
+                size_t k = (n - done < room) ? n - done : room;
+                memcpy(at, src + done, k * sizeof(char_type));
+                commit(k);
+                done += k;
+            }
+            return done;
+        }
+
+        /**
+         * @brief Decode the next complete frame in place.
+         *
+         * @param f         set to the frame when one is complete
+         * @return true     if f holds a new frame, false if more input is needed
+         */
+        bool next(frame& f) noexcept {
+            for (;;) {
+                size_t end = _in_b ? _b_end : _a_end;
+                const void* e = (_scan < end) ? memchr(_buf + _scan, static_cast<uint8_t>(DECODER::end_code()), end - _scan) : nullptr;
+                if (!e) {
+                    _scan = end;
+                    if (_in_b || !_b_active) return false;
+                    // region A is parsed up to the frame moved to the front
+                    _in_b  = true;
+                    _scan  = 0;
+                    _frame_start = 0;
+                    settle();
+                    continue;
+                }
+                size_t at = static_cast<const char_type*>(e) - _buf, start = _frame_start, rawsize = at - start;
+                bool drop    = _discard;
+                _scan        = at + 1;
+                _frame_start = at + 1;
+                _discard     = false;
+                size_t size  = (rawsize && !drop) ? DECODER::decode(_buf + start, rawsize, _buf + start, rawsize) : 0;
+                if (size == 0) {
+                    if (rawsize || drop) _errors++;
+                    settle();
+                    continue;
+                }
+                f.data      = _buf + start;
+                f.size      = size;
+                f.end_index = at + 1;
+                (_in_b ? _held_b : _held_a)++;
+                _frames++;
+                return true;
+            }
+        }
+
+        /** Hand the oldest frame returned by next() back to the buffer. */
+        void release(const frame& f) noexcept {
+            if (_held_a == 0) return;
+            _held_a--;
+            _a_start = f.end_index;
+            settle();
+        }
+
+        size_t frames() const noexcept { return _frames; } ///< frames returned by next()
+        size_t errors() const noexcept { return _errors; } ///< frames dropped as bad or too long
+        size_t moved() const noexcept { return _moved; }   ///< characters copied to the front when wrapping
+
+     protected:
+        /** Move the partly received frame at the end of A to the front and start region B. */
+        void wrap() noexcept {
+            size_t p = _frame_start;
+            for (size_t i = _a_end; i > _scan; i--) {
+                if (_buf[i - 1] == DECODER::end_code()) {
+                    p = i;
+                    break;
+                }
+            }
+            size_t len = _a_end - p;
+            if (len >= _a_start || _a_start - len <= N - _a_end) return; // no gain
+            memcpy(_buf, _buf + p, len * sizeof(char_type));
+            _moved += len;
+            if (_scan >= p) {
+                _in_b        = true;
+                _scan       -= p;
+                _frame_start = 0;
+            }
+            _a_end    = p;
+            _b_end    = len;
+            _b_active = true;
+            settle();
+        }
+
+        /** Is there an END that next() has not reached yet? */
+        bool unparsed_end() const noexcept {
+            const int end = static_cast<uint8_t>(DECODER::end_code());
+            if (!_in_b && _scan < _a_end && memchr(_buf + _scan, end, _a_end - _scan)) return true;
+            size_t from = _in_b ? _scan : 0;
+            return _b_active && from < _b_end && memchr(_buf + from, end, _b_end - from);
+        }
+
+        /** The partly received frame fills the buffer: forget it and skip to its END. */
+        void drop_partial() noexcept {
+            _a_start = _a_end = _b_end = _scan = _frame_start = 0;
+            _b_active = _in_b = false;
+            _discard          = true;
+        }
+
+        /** Free whatever no held frame needs, and let B take over once A is empty. */
+        void settle() noexcept {
+            if (_held_a == 0 && _in_b) {
+                _a_start  = 0;
+                _a_end    = _b_end;
+                _b_active = _in_b = false;
+                _held_a           = _held_b;
+                _held_b           = 0;
+            }
+            if (_held_a == 0) _a_start = _frame_start;
+            if (_a_start == _a_end && !_b_active) _a_start = _a_end = _scan = _frame_start = 0;
+        }
+
+        char_type _buf[N];
+        size_t _a_start = 0, _a_end = 0, _b_end = 0; // region A [_a_start, _a_end), region B [0, _b_end)
+        size_t _scan = 0, _frame_start = 0;          // parse position, in B coordinates when _in_b
+        size_t _held_a = 0, _held_b = 0;             // frames returned and not yet released
+        size_t _frames = 0, _errors = 0, _moved = 0;
+        bool _b_active = false, _in_b = false, _discard = false;
+    };
+
+}
+
+#endif // __SLIPBIPBUFFER_H__
@@ -0,0 +1,368 @@
+/*!
+ *  @file SlipCapture.h
+ *
+ *  Capture files with random frame access: the raw encoded SLIP stream, as
+ *  received or sent, plus a sidecar index of where each frame starts.
+ *
+ *  Host only: needs POSIX files and mmap.
+ */
+
+#pragma once
+
+#ifndef __SLIPCAPTURE_H__
+    #define __SLIPCAPTURE_H__
+
+    #include "SlipInPlace.h"
+    #include <fcntl.h>
+    #include <stdio.h>
+    #include <string>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <vector>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Frame scanner
+     **************************************************************************************/
+
+    /**
+     * @brief Finds where frames start in an encoded stream that arrives in pieces.
+     *
+     * Only END matters for frame boundaries, since an escaped END is not an END
+     * character, so the scan is one memchr() per frame. Empty frames (END after
+     * END) are skipped.
+     *
+     * @tparam DECODER  the decoder_base type whose END code to use
+     */
+    template <class DECODER = decoder>
+    class frame_scanner {
+     public:
+        using char_type = typename DECODER::char_type;
+
+        /**
+         * @brief Scan the next n characters of the stream.
+         * @param found     called with the stream offset of each frame start, once its END is seen
+         */
+        template <typename _Fn>
+        void scan(const char_type* data, size_t n, _Fn found) {
+            for (const char_type *p = data, *end = data + n; p < end;) {
+                const char_type* e = find_end(p, end - p);
+                if (!e) break;
+                uint64_t at = _pos + (e - data);
+                if (at > _start) found(_start);
+                _start = at + 1;
+                p      = e + 1;
+            }
+            _pos += n;
+        }
+
+        /**
+         * @brief End of the stream.
+         * @param found     called with the start of a last frame that has no END
+         */
+        template <typename _Fn>
+        void finish(_Fn found) {
+            if (_pos > _start) found(_start);
+            _start = _pos;
+        }
+
+        uint64_t position() const noexcept { return _pos; } ///< characters scanned
+
+     private:
+        static const char_type* find_end(const char_type* p, size_t n) noexcept {
+            if (sizeof(char_type) == 1)
+                return static_cast<const char_type*>(memchr(p, static_cast<uint8_t>(DECODER::end_code()), n));
+            for (const char_type* e = p + n; p < e; p++)
+                if (*p == DECODER::end_code()) return p;
+            return nullptr;
+        }
+
+        uint64_t _pos   = 0; // stream offset of the next character
+        uint64_t _start = 0; // stream offset of the current frame
+    };
+
+    /**************************************************************************************
+     * Index files
+     **************************************************************************************/
+
+    /**
+     * @brief The sidecar index of a capture, `<capture>.idx`.
+     *
+     * An 8-character magic, the capture size, the frame count n, then n + 1
+     * frame start offsets, the last being the capture size. Sizes and offsets
+     * are in bytes, and all fields are little-endian 64-bit. Frame i is decoded
+     * from its start up to its END, which is before the start of frame i + 1.
+     */
+    struct capture_index {
+        static constexpr size_t header_size = 24;
+
+        static const char* magic() noexcept { return "SLIPIDX1"; }
+
+        static std::string path_for(const std::string& capture) { return capture + ".idx"; }
+
+        static void put(uint8_t* p, uint64_t v) noexcept {
+            for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+        }
+        static uint64_t get(const uint8_t* p) noexcept {
+            uint64_t v = 0;
+            for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+            return v;
+        }
+
+        /**
+         * @brief Write an index of starts for a capture of capture_size bytes.
+         * @return false on I/O errors
+         */
+        static bool write(const std::string& path, const std::vector<uint64_t>& starts, uint64_t capture_size) {
+            FILE* f = fopen(path.c_str(), "wb");
+            if (!f) return false;
+            uint8_t h[header_size];
+            memcpy(h, magic(), 8);
+            put(h + 8, capture_size);
+            put(h + 16, starts.size());
+            bool ok = fwrite(h, 1, sizeof(h), f) == sizeof(h);
+            std::vector<uint8_t> body(8 * (starts.size() + 1));
+            for (size_t i = 0; i < starts.size(); i++) put(&body[8 * i], starts[i]);
+            put(&body[8 * starts.size()], capture_size);
+            ok = fwrite(body.data(), 1, body.size(), f) == body.size() && ok;
+            return fclose(f) == 0 && ok;
+        }
+
+        /** Frame start offsets of an encoded stream of size characters, by scanning it. */
+        template <class DECODER = decoder>
+        static std::vector<uint64_t> build(const typename DECODER::char_type* data, size_t size) {
+            std::vector<uint64_t> starts;
+            frame_scanner<DECODER> scanner;
+            auto add = [&starts](uint64_t at) { starts.push_back(at * sizeof(typename DECODER::char_type)); };
+            scanner.scan(data, size, add);
+            scanner.finish(add);
+            return starts;
+        }
+    };
+
+    /**************************************************************************************
+     * Capture writer
+     **************************************************************************************/
+
+    /**
+     * @brief Writes a capture and builds its index as it goes.
+     *
+     * write() takes raw stream data in any pieces, for example as read from a
+     * serial port. write_frame() encodes a payload first. close() writes the
+     * index next to the capture.
+     *
+     * @tparam ENCODER  the encoder_base type to use
+     * @tparam DECODER  the decoder_base type with the same codes
+     */
+    template <class ENCODER = encoder, class DECODER = decoder>
+    class capture_writer {
+     public:
+        using char_type = typename ENCODER::char_type;
+
+        explicit capture_writer(const std::string& path) : _path(path), _file(fopen(path.c_str(), "wb")) {}
+        ~capture_writer() { close(); }
+
+        capture_writer(const capture_writer&)            = delete;
+        capture_writer& operator=(const capture_writer&) = delete;
+
+        bool is_open() const noexcept { return _file != nullptr; }
+
+        /** Append raw encoded stream data. @return false on I/O errors */
+        bool write(const char_type* data, size_t n) {
+            if (!_file) return false;
+            _scanner.scan(data, n, [this](uint64_t at) { _starts.push_back(at * sizeof(char_type)); });
+            return fwrite(data, sizeof(char_type), n, _file) == n;
+        }
+
+        /** Encode and append one frame. @return false if it could not be encoded or written */
+        bool write_frame(const char_type* payload, size_t size) {
+            _frame.resize(2 * size + 1);
+            size_t esize = ENCODER::encode(_frame.data(), _frame.size(), payload, size);
+            return esize && write(_frame.data(), esize);
+        }
+
+        /** Frames indexed so far. */
+        size_t frames() const noexcept { return _starts.size(); }
+
+        /** Close the capture and write its index. @return false on I/O errors */
+        bool close() {
+            if (!_file) return false;
+            _scanner.finish([this](uint64_t at) { _starts.push_back(at * sizeof(char_type)); });
+            bool ok = fclose(_file) == 0;
+            _file   = nullptr;
+            return capture_index::write(capture_index::path_for(_path), _starts, _scanner.position() * sizeof(char_type)) && ok;
+        }
+
+     private:
+        std::string _path;
+        FILE* _file;
+        frame_scanner<DECODER> _scanner;
+        std::vector<uint64_t> _starts;
+        std::vector<char_type> _frame;
+    };
+
+    /**************************************************************************************
+     * Capture reader
+     **************************************************************************************/
+
+    /** @brief A whole file mapped read-only. */
+    class mapped_file {
+     public:
+        mapped_file() = default;
+        explicit mapped_file(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat st;
+            if (fstat(fd, &st) == 0) {
+                _size = static_cast<size_t>(st.st_size);
+                _ok   = true;
+                if (_size) {
+                    void* p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    _ok     = p != MAP_FAILED;
+                    _data   = _ok ? static_cast<const uint8_t*>(p) : nullptr;
+                    if (!_ok) _size = 0;
+                }
+            }
+            ::close(fd);
+        }
+        ~mapped_file() {
+            if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+        }
+        mapped_file(mapped_file&& other) noexcept { *this = static_cast<mapped_file&&>(other); }
+        mapped_file& operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+                if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+                _data = other._data, _size = other._size, _ok = other._ok;
+                other._data = nullptr, other._size = 0, other._ok = false;
+            }
+            return *this;
+        }
+
+        bool ok() const noexcept { return _ok; }
+        const uint8_t* data() const noexcept { return _data; }
+        size_t size() const noexcept { return _size; }
+
+     private:
+        const uint8_t* _data = nullptr;
+        size_t _size         = 0;
+        bool _ok             = false;
+    };
+
+    /**
+     * @brief Random access to the frames of a capture.
+     *
+     * Maps the capture and its index. Finding frame i is one lookup in the
+     * index, and decoding it touches only that frame's pages. With no usable
+     * index (missing, or for a capture of a different size) the capture is
+     * scanned once on open instead.
+     *
+     * ```c++
+     * slip::capture_reader<> cap("link.slip");
+     * size_t n = cap.decode(1000, buf, sizeof(buf));
+     * ```
+     *
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <class DECODER = decoder>
+    class capture_reader {
+     public:
+        using char_type = typename DECODER::char_type;
+
+        explicit capture_reader(const std::string& path)
+            : _capture(path), _index(capture_index::path_for(path)) {
+            if (!_capture.ok()) return;
+            const uint64_t size = _capture.size() / sizeof(char_type);
+            if (_index.ok() && _index.size() >= capture_index::header_size &&
+                memcmp(_index.data(), capture_index::magic(), 8) == 0 &&
+                capture_index::get(_index.data() + 8) == _capture.size()) {
+                uint64_t n = capture_index::get(_index.data() + 16), entries = (_index.size() - capture_index::header_size) / 8;
+                if (n < entries && _index.size() == capture_index::header_size + 8 * (n + 1)) {
+                    _count   = static_cast<size_t>(n);
+                    _indexed = true;
+                    return;
+                }
+            }
+            _scanned = capture_index::build<DECODER>(stream(), size);
+            _scanned.push_back(size * sizeof(char_type));
+            _count = _scanned.size() - 1;
+        }
+
+        bool is_open() const noexcept { return _capture.ok(); }
+
+        /** Was the sidecar index used, rather than a scan on open? */
+        bool indexed() const noexcept { return _indexed; }
+
+        size_t size() const noexcept { return _count; } ///< number of frames
+
+        /**
+         * @brief Encoded frame i, from its first character up to the start of frame i + 1.
+         *
+         * That includes its END and any empty frames that follow it, so
+         * decoded_size() may be a few characters more than decode() returns.
+         * nullptr if i is out of range or the index points outside the capture.
+         */
+        const char_type* frame(size_t i, size_t& encoded_size) const noexcept {
+            encoded_size = 0;
+            if (i >= _count) return nullptr;
+            uint64_t from = start(i), to = start(i + 1);
+            if (from >= to || to > _capture.size() / sizeof(char_type)) return nullptr;
+            encoded_size  = static_cast<size_t>(to - from);
+            return stream() + from;
+        }
+
+        /** @copydoc decoder_base::decoded_size */
+        size_t decoded_size(size_t i) const noexcept {
+            size_t n;
+            const char_type* f = frame(i, n);
+            return f ? DECODER::decoded_size(f, n) : 0;
+        }
+
+        /**
+         * @brief Decode frame i.
+         * @return size_t   decoded size, or 0 if i is out of range or decoding fails
+         */
+        size_t decode(size_t i, char_type* dest, size_t destsize) const noexcept {
+            size_t n;
+            const char_type* f = frame(i, n);
+            return f ? DECODER::decode(dest, destsize, f, n) : 0;
+        }
+
+        /**
+         * @brief Decode frames [first, last) with one buffer.
+         * @param fn    called as fn(i, data, size) for each frame. size is 0 if it failed to decode.
+         * @return size_t   frames decoded
+         */
+        template <typename _Fn>
+        size_t decode_range(size_t first, size_t last, _Fn fn) const {
+            size_t decoded = 0;
+            std::vector<char_type> buf;
+            for (size_t i = first; i < last && i < _count; i++) {
+                size_t n;
+                const char_type* f = frame(i, n);
+                if (buf.size() < n) buf.resize(n);
+                size_t size = DECODER::decode(buf.data(), buf.size(), f, n);
+                if (size) decoded++;
+                fn(i, static_cast<const char_type*>(buf.data()), size);
+            }
+            return decoded;
+        }
+
+     private:
+        const char_type* stream() const noexcept { return reinterpret_cast<const char_type*>(_capture.data()); }
+
+        uint64_t start(size_t i) const noexcept {
+            uint64_t at = _indexed ? capture_index::get(_index.data() + capture_index::header_size + 8 * i) : _scanned[i];
+            return at / sizeof(char_type);
+        }
+
+        mapped_file _capture, _index;
+        std::vector<uint64_t> _scanned;
+        size_t _count = 0;
+        bool _indexed = false;
+    };
+
+}
+
+#endif // __SLIPCAPTURE_H__
@@ -0,0 +1,446 @@
+/*!
+ *  @file SlipCompress.h
+ *
+ *  Van Jacobson TCP/IP header compression for SLIP links (CSLIP, RFC 1144).
+ */
+
+#pragma once
+
+#ifndef __SLIPCOMPRESS_H__
+    #define __SLIPCOMPRESS_H__
+
+    #include "SlipInPlace.h"
+    #include "SlipPacket.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * CSLIP codes
+     **************************************************************************************/
+
+    /* Packet types, carried in the top bits of the first character, and change mask bits. */
+    struct cslip {
+        static constexpr uint8_t TYPE_IP               = 0x40;
+        static constexpr uint8_t TYPE_UNCOMPRESSED_TCP = 0x70;
+        static constexpr uint8_t TYPE_COMPRESSED_TCP   = 0x80;
+        static constexpr uint8_t TYPE_ERROR            = 0x00;
+
+        static constexpr uint8_t NEW_C         = 0x40; ///< connection number follows
+        static constexpr uint8_t NEW_I         = 0x20; ///< IP id delta follows
+        static constexpr uint8_t TCP_PUSH_BIT  = 0x10; ///< PSH flag
+        static constexpr uint8_t NEW_S         = 0x08; ///< sequence delta follows
+        static constexpr uint8_t NEW_A         = 0x04; ///< ack delta follows
+        static constexpr uint8_t NEW_W         = 0x02; ///< window delta follows
+        static constexpr uint8_t NEW_U         = 0x01; ///< urgent pointer follows
+        static constexpr uint8_t SPECIAL_I     = NEW_S | NEW_W | NEW_U;         ///< echoed interactive traffic
+        static constexpr uint8_t SPECIAL_D     = NEW_S | NEW_A | NEW_W | NEW_U; ///< unidirectional data
+        static constexpr uint8_t SPECIALS_MASK = 0x0f;
+
+        static constexpr size_t MAX_HEADER = 128; ///< largest IP + TCP header kept per connection
+
+     protected:
+        static constexpr uint8_t TH_FIN = 0x01;
+        static constexpr uint8_t TH_SYN = 0x02;
+        static constexpr uint8_t TH_RST = 0x04;
+        static constexpr uint8_t TH_PSH = 0x08;
+        static constexpr uint8_t TH_ACK = 0x10;
+        static constexpr uint8_t TH_URG = 0x20;
+
+        /* Header fields are big-endian and may be unaligned. */
+        static uint16_t get16(const uint8_t* p) noexcept { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+        static uint32_t get32(const uint8_t* p) noexcept {
+            return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        }
+        static void put16(uint8_t* p, uint16_t v) noexcept {
+            p[0] = static_cast<uint8_t>(v >> 8);
+            p[1] = static_cast<uint8_t>(v);
+        }
+        static void put32(uint8_t* p, uint32_t v) noexcept {
+            put16(p, static_cast<uint16_t>(v >> 16));
+            put16(p + 2, static_cast<uint16_t>(v));
+        }
+
+        /** IPv4 header checksum of hlen characters, with the checksum field taken as zero. */
+        static uint16_t ip_checksum(const uint8_t* ip, size_t hlen) noexcept {
+            uint32_t sum = 0;
+            for (size_t i = 0; i < hlen; i += 2) {
+                if (i != 10) sum += get16(ip + i);
+            }
+            while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+            return static_cast<uint16_t>(~sum);
+        }
+
+        /** Delta as one character, or 0 and two characters if it is over 255, or 0 where zero_ok allows a 0. */
+        static uint8_t* put_delta(uint8_t* cp, uint32_t n, bool zero_ok = false) noexcept {
+            if (n >= 256 || (n == 0 && zero_ok)) {
+                *(cp++) = 0;
+                put16(cp, static_cast<uint16_t>(n));
+                return cp + 2;
+            }
+            *(cp++) = static_cast<uint8_t>(n);
+            return cp;
+        }
+
+        /** Read a delta written by put_delta(). @return nullptr if it runs past end */
+        static const uint8_t* get_delta(const uint8_t* cp, const uint8_t* end, uint32_t& n) noexcept {
+            if (cp >= end) return nullptr;
+            if (*cp != 0) {
+                n = *cp;
+                return cp + 1;
+            }
+            if (end - cp < 3) return nullptr;
+            n = get16(cp + 1);
+            return cp + 3;
+        }
+    };
+
+    /**************************************************************************************
+     * Compressor
+     **************************************************************************************/
+
+    /**
+     * @brief Transmit side of RFC 1144 header compression.
+     *
+     * compress() takes one IPv4 packet and rewrites it in place. A TCP packet on
+     * a known connection has its 40-character header replaced by a 3 to 16
+     * character delta. This only moves the start of the packet forward, so the
+     * payload is never copied. Other TCP packets go out with their header intact
+     * and the IP protocol field set to the slot number. Everything else passes
+     * through as TYPE_IP. The type is also carried in the first character, so
+     * the link needs no extra framing.
+     *
+     * Connections are kept in Slots slots and the least recently used slot is
+     * taken for a new connection.
+     *
+     * @tparam Slots    number of connection slots (RFC 1144 uses 16)
+     */
+    template <size_t Slots = 16>
+    class cslip_compressor : public cslip {
+        static_assert(Slots >= 1 && Slots <= 256, "slot number must fit in one character");
+
+     public:
+        /** @param compress_cid  drop the slot number when it repeats (both ends must agree) */
+        explicit cslip_compressor(bool compress_cid = true) noexcept : _compress_cid(compress_cid) {
+            for (size_t i = 0; i < Slots; i++) _lru[i] = static_cast<uint8_t>(i);
+        }
+
+        /**
+         * @brief Compress the IPv4 packet in pkt in place.
+         *
+         * @return uint8_t  TYPE_IP, TYPE_UNCOMPRESSED_TCP or TYPE_COMPRESSED_TCP
+         */
+        uint8_t compress(packet_buffer<uint8_t>& pkt) noexcept {
+            uint8_t* ip = pkt.data();
+            size_t len  = pkt.size();
+            if (len < 40 || (ip[0] >> 4) != 4 || ip[9] != 6) return TYPE_IP;
+            if (get16(ip + 6) & 0x3fff) return TYPE_IP; // fragment
+            size_t iphl = (ip[0] & 0x0f) * 4;
+            if (iphl < 20 || len < iphl + 20) return TYPE_IP;
+            uint8_t* th = ip + iphl;
+            size_t hlen = iphl + (th[12] >> 4) * 4;
+            if ((th[12] >> 4) < 5 || hlen > len || hlen > MAX_HEADER) return TYPE_IP;
+            if ((th[13] & (TH_SYN | TH_FIN | TH_RST | TH_ACK)) != TH_ACK) return TYPE_IP;
+
+            // find the connection, moving it to the front of the LRU order
+            size_t i = 0;
+            for (; i < Slots; i++) {
+                const slot& s = _slots[_lru[i]];
+                if (s.hlen && !memcmp(s.hdr + 12, ip + 12, 8) && !memcmp(s.hdr + s.iphl(), th, 4)) break;
+            }
+            bool found = i < Slots;
+            if (!found) i = Slots - 1;
+            uint8_t id = _lru[i];
+            memmove(_lru + 1, _lru, i);
+            _lru[0] = id;
+            slot& cs = _slots[id];
+            if (!found) return uncompressed(pkt, cs, id, hlen);
+
+            // fields that must not change
+            const uint8_t* oip = cs.hdr;
+            const uint8_t* oth = oip + iphl;
+            if (cs.hlen != hlen || memcmp(ip, oip, 2) || memcmp(ip + 6, oip + 6, 4) || th[12] != oth[12]
+                || memcmp(ip + 20, oip + 20, iphl - 20) || memcmp(th + 20, oth + 20, hlen - iphl - 20)) {
+                return uncompressed(pkt, cs, id, hlen);
+            }
+
+            uint8_t deltas[16];
+            uint8_t* cp     = deltas;
+            uint8_t changes = 0;
+            if (th[13] & TH_URG) {
+                cp = put_delta(cp, get16(th + 18), true);
+                changes |= NEW_U;
+            } else if (get16(th + 18) != get16(oth + 18)) {
+                return uncompressed(pkt, cs, id, hlen);
+            }
+            uint16_t dwin = static_cast<uint16_t>(get16(th + 14) - get16(oth + 14));
+            if (dwin) {
+                cp = put_delta(cp, dwin);
+                changes |= NEW_W;
+            }
+            uint32_t dack = get32(th + 8) - get32(oth + 8);
+            if (dack) {
+                if (dack > 0xffff) return uncompressed(pkt, cs, id, hlen);
+                cp = put_delta(cp, dack);
+                changes |= NEW_A;
+            }
+            uint32_t dseq = get32(th + 4) - get32(oth + 4);
+            if (dseq) {
+                if (dseq > 0xffff) return uncompressed(pkt, cs, id, hlen);
+                cp = put_delta(cp, dseq);
+                changes |= NEW_S;
+            }
+
+            size_t olddata = get16(oip + 2) - hlen; // payload of the previous packet
+            switch (changes) {
+            case 0:
+                // a data packet after a pure ack; anything else is a retransmission
+                if (get16(ip + 2) != get16(oip + 2) && get16(oip + 2) == hlen) break;
+                return uncompressed(pkt, cs, id, hlen);
+            case SPECIAL_I:
+            case SPECIAL_D:
+                // the real changes would read as a special case
+                return uncompressed(pkt, cs, id, hlen);
+            case NEW_S | NEW_A:
+                if (dseq == dack && dseq == olddata) {
+                    changes = SPECIAL_I;
+                    cp      = deltas;
+                }
+                break;
+            case NEW_S:
+                if (dseq == olddata) {
+                    changes = SPECIAL_D;
+                    cp      = deltas;
+                }
+                break;
+            }
+
+            uint16_t did = static_cast<uint16_t>(get16(ip + 4) - get16(oip + 4));
+            if (did != 1) {
+                cp = put_delta(cp, did, true);
+                changes |= NEW_I;
+            }
+            if (th[13] & TH_PSH) changes |= TCP_PUSH_BIT;
+            uint16_t sum = get16(th + 16);
+            memcpy(cs.hdr, ip, hlen);
+
+            // replace the header with the delta: the packet start moves forward
+            bool cid     = !_compress_cid || _last != id;
+            size_t ndelt = cp - deltas;
+            size_t csize = 1 + (cid ? 1 : 0) + 2 + ndelt;
+            pkt.pull(hlen);
+            uint8_t* out = pkt.push(csize);
+            *(out++)     = static_cast<uint8_t>(changes | (cid ? NEW_C : 0) | TYPE_COMPRESSED_TCP);
+            if (cid) *(out++) = id;
+            put16(out, sum);
+            memcpy(out + 2, deltas, ndelt);
+            _last = id;
+            return TYPE_COMPRESSED_TCP;
+        }
+
+        /**
+         * @brief Compress then SLIP-encode pkt in place.
+         *
+         * @tparam ENCODER  the encoder_base type to use
+         * @return size_t   encoded size, or 0 if pkt has too little room
+         */
+        template <class ENCODER = encoder>
+        size_t encode(packet_buffer<uint8_t>& pkt) noexcept {
+            compress(pkt);
+            return pkt.template encode<ENCODER>();
+        }
+
+     protected:
+        struct slot {
+            uint8_t hdr[MAX_HEADER];
+            size_t hlen = 0;
+            size_t iphl() const noexcept { return (hdr[0] & 0x0f) * 4; }
+        };
+
+        /** Keep the header for next time and mark the packet with its slot. */
+        uint8_t uncompressed(packet_buffer<uint8_t>& pkt, slot& cs, uint8_t id, size_t hlen) noexcept {
+            uint8_t* ip = pkt.data();
+            memcpy(cs.hdr, ip, hlen);
+            cs.hlen = hlen;
+            ip[9]   = id;
+            ip[0]   = static_cast<uint8_t>((ip[0] & 0x0f) | TYPE_UNCOMPRESSED_TCP);
+            _last   = id;
+            return TYPE_UNCOMPRESSED_TCP;
+        }
+
+        slot _slots[Slots];
+        uint8_t _lru[Slots]; ///< slot numbers, most recently used first
+        int _last = -1;      ///< slot of the last packet sent
+        bool _compress_cid;
+    };
+
+    /**************************************************************************************
+     * Decompressor
+     **************************************************************************************/
+
+    /**
+     * @brief Receive side of RFC 1144 header compression.
+     *
+     * decompress() rebuilds the full header of a compressed packet in the
+     * headroom in front of it, so a packet_buffer with MAX_HEADER characters of
+     * headroom never moves the payload. With less, the payload is moved back
+     * into the tailroom.
+     *
+     * Call error() when a frame is lost or fails to decode. Compressed packets
+     * are then dropped until one names its slot or an uncompressed packet
+     * arrives, as the connection state can no longer be trusted.
+     *
+     * @tparam Slots    number of connection slots, matching the compressor
+     */
+    template <size_t Slots = 16>
+    class cslip_decompressor : public cslip {
+        static_assert(Slots >= 1 && Slots <= 256, "slot number must fit in one character");
+
+     public:
+        /** Signal a lost or damaged frame (RFC 1144 TYPE_ERROR). */
+        void error() noexcept { _toss = true; }
+
+        /** Compressed packets dropped since construction. */
+        size_t tossed() const noexcept { return _tossed; }
+
+        /**
+         * @brief Restore the IPv4 packet in pkt, in place.
+         *
+         * @return size_t   packet size, or 0 if the packet is dropped
+         */
+        size_t decompress(packet_buffer<uint8_t>& pkt) noexcept {
+            if (pkt.size() == 0) return 0;
+            uint8_t* buf = pkt.data();
+            if (buf[0] & TYPE_COMPRESSED_TCP) return compressed(pkt);
+            if (buf[0] >= TYPE_UNCOMPRESSED_TCP) return uncompressed(pkt);
+            return pkt.size();
+        }
+
+        /**
+         * @brief SLIP-decode then decompress pkt in place.
+         *
+         * A frame that fails to decode counts as an error().
+         *
+         * @tparam DECODER  the decoder_base type to use
+         * @return size_t   packet size, or 0 if the packet is dropped
+         */
+        template <class DECODER = decoder>
+        size_t decode(packet_buffer<uint8_t>& pkt) noexcept {
+            if (!pkt.template decode<DECODER>()) {
+                error();
+                return 0;
+            }
+            return decompress(pkt);
+        }
+
+     protected:
+        struct slot {
+            uint8_t hdr[MAX_HEADER];
+            size_t hlen = 0;
+        };
+
+        size_t toss() noexcept {
+            _toss = true;
+            _tossed++;
+            return 0;
+        }
+
+        size_t uncompressed(packet_buffer<uint8_t>& pkt) noexcept {
+            uint8_t* ip = pkt.data();
+            size_t len  = pkt.size();
+            if (len < 40 || ip[9] >= Slots) return toss();
+            size_t iphl = (ip[0] & 0x0f) * 4;
+            if (iphl < 20 || len < iphl + 20) return toss();
+            size_t hlen = iphl + (ip[iphl + 12] >> 4) * 4;
+            if (hlen > len || hlen > MAX_HEADER) return toss();
+            slot& cs = _slots[ip[9]];
+            _last    = ip[9];
+            _toss    = false;
+            ip[0]    = static_cast<uint8_t>((ip[0] & 0x0f) | 0x40);
+            ip[9]    = 6;
+            memcpy(cs.hdr, ip, hlen);
+            cs.hlen = hlen;
+            return len;
+        }
+
+        size_t compressed(packet_buffer<uint8_t>& pkt) noexcept {
+            const uint8_t* cp  = pkt.data();
+            const uint8_t* end = cp + pkt.size();
+            uint8_t changes    = *(cp++);
+            if (changes & NEW_C) {
+                if (cp >= end || *cp >= Slots) return toss();
+                _last = *(cp++);
+                _toss = false;
+            } else if (_toss || _last < 0) {
+                return toss();
+            }
+            slot& cs = _slots[_last];
+            if (!cs.hlen || end - cp < 2) return toss();
+
+            // work on a copy so a damaged packet leaves the slot intact
+            uint8_t hdr[MAX_HEADER];
+            memcpy(hdr, cs.hdr, cs.hlen);
+            uint8_t* th   = hdr + (hdr[0] & 0x0f) * 4;
+            size_t odata  = get16(hdr + 2) - cs.hlen;
+            uint32_t n    = 0;
+            memcpy(th + 16, cp, 2); // checksum
+            cp += 2;
+            th[13] = (changes & TCP_PUSH_BIT) ? (th[13] | TH_PSH) : (th[13] & ~TH_PSH);
+
+            switch (changes & SPECIALS_MASK) {
+            case SPECIAL_I:
+                put32(th + 8, get32(th + 8) + odata);
+                put32(th + 4, get32(th + 4) + odata);
+                break;
+            case SPECIAL_D:
+                put32(th + 4, get32(th + 4) + odata);
+                break;
+            default:
+                if (changes & NEW_U) {
+                    th[13] |= TH_URG;
+                    if (!(cp = get_delta(cp, end, n))) return toss();
+                    put16(th + 18, static_cast<uint16_t>(n));
+                } else {
+                    th[13] &= ~TH_URG;
+                }
+                if (changes & NEW_W) {
+                    if (!(cp = get_delta(cp, end, n))) return toss();
+                    put16(th + 14, static_cast<uint16_t>(get16(th + 14) + n));
+                }
+                if (changes & NEW_A) {
+                    if (!(cp = get_delta(cp, end, n))) return toss();
+                    put32(th + 8, get32(th + 8) + n);
+                }
+                if (changes & NEW_S) {
+                    if (!(cp = get_delta(cp, end, n))) return toss();
+                    put32(th + 4, get32(th + 4) + n);
+                }
+            }
+            if (changes & NEW_I) {
+                if (!(cp = get_delta(cp, end, n))) return toss();
+            } else {
+                n = 1;
+            }
+            put16(hdr + 4, static_cast<uint16_t>(get16(hdr + 4) + n));
+
+            // header in front of the payload
+            size_t hlen = cs.hlen;
+            size_t data = end - cp;
+            if (hlen + data > 0xffff) return toss();
+            pkt.pull(cp - pkt.data());
+            if (!pkt.reserve_headroom(hlen)) return toss();
+            put16(hdr + 2, static_cast<uint16_t>(hlen + data));
+            put16(hdr + 10, ip_checksum(hdr, (hdr[0] & 0x0f) * 4));
+            memcpy(cs.hdr, hdr, hlen);
+            memcpy(pkt.push(hlen), hdr, hlen);
+            return pkt.size();
+        }
+
+        slot _slots[Slots];
+        int _last      = -1; ///< slot of the last packet received
+        bool _toss     = false;
+        size_t _tossed = 0;
+    };
+
+}
+
+#endif // __SLIPCOMPRESS_H__
@@ -0,0 +1,230 @@
+/*!
+ *  @file SlipDispatch.h
+ *
+ *  Runtime CPU dispatch of SLIP encode/decode kernels.
+ *
+ *  Host-only. Define SLIP_RUNTIME_DISPATCH=1 before including SlipInPlace.h
+ *  to route slip::encoder, slip::decoder, slip::null_encoder and
+ *  slip::null_decoder through the dispatch layer.
+ */
+
+#pragma once
+
+#ifndef __SLIPDISPATCH_H__
+    #define __SLIPDISPATCH_H__
+
+    #include "SlipKernels.h"
+    #include <atomic>
+    #include <stdlib.h> // for getenv
+    #include <string.h> // for strcmp
+
+namespace slip {
+
+    /**
+     * @brief Kernel chosen for the whole process.
+     *
+     * The SLIP_KERNEL environment variable (scalar, sse2, avx2, ...) overrides the
+     * automatic choice when the named kernel is supported. Useful for benchmarking.
+     */
+    inline kernel_id selected_kernel() noexcept {
+        const char* name = getenv("SLIP_KERNEL");
+        if (name) {
+            for (int k = 0; k < static_cast<int>(kernel_id::num_kernels); k++) {
+                kernel_id kid = static_cast<kernel_id>(k);
+                if (strcmp(name, kernel_name(kid)) == 0 && kernel_supported(kid))
+                    return kid;
+            }
+        }
+        return best_kernel();
+    }
+
+    /**************************************************************************************
+     * Dispatched encoder
+     **************************************************************************************/
+
+    /**
+     * @brief Encoder that forwards to the best kernel for this host.
+     *
+     * The kernel is resolved on the first call, which overwrites the function
+     * pointers with the chosen kernel. Every later call is a single indirect call
+     * with no branching on CPU features.
+     *
+     * @tparam ENCODER  the encoder_base type to accelerate
+     */
+    template <class ENCODER>
+    struct dispatched_encoder : public ENCODER {
+        using char_type = typename ENCODER::char_type;
+        using code_fn   = typename kernels<ENCODER>::code_fn;
+        using size_fn   = typename kernels<ENCODER>::size_fn;
+
+        /** @copydoc encoder_base::encoded_size */
+        static inline size_t encoded_size(const char_type* src, size_t srcsize) noexcept {
+            return s_encoded_size.load(std::memory_order_relaxed)(src, srcsize);
+        }
+
+        /** @copydoc encoder_base::encode */
+        static inline size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return s_encode.load(std::memory_order_relaxed)(dest, destsize, src, srcsize);
+        }
+
+        /**
+         * @copydoc encoded_size
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encoded_size(const _FromT* src, size_t srcsize) noexcept {
+            return encoded_size(reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+        /**
+         * @copydoc encode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return encode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+        /**
+         * @brief Manually select a kernel, for example while benchmarking.
+         * @return false (and no change) if the kernel is not supported on this host
+         */
+        static bool use(kernel_id k) noexcept {
+            if (!kernel_supported(k)) return false;
+            code_fn enc  = kernels<ENCODER>::encode(k);
+            size_fn size = kernels<ENCODER>::encoded_size(k);
+            if (!enc || !size) {
+                k    = kernel_id::scalar;
+                enc  = static_cast<code_fn>(&ENCODER::encode);
+                size = static_cast<size_fn>(&ENCODER::encoded_size);
+            }
+            s_kernel.store(k, std::memory_order_relaxed);
+            s_encoded_size.store(size, std::memory_order_relaxed);
+            s_encode.store(enc, std::memory_order_relaxed);
+            return true;
+        }
+
+        /** Kernel currently in use. Resolves the kernel if no call was made yet. */
+        static kernel_id active() noexcept {
+            if (s_encode.load(std::memory_order_relaxed) == &resolve_encode) use(selected_kernel());
+            return s_kernel.load(std::memory_order_relaxed);
+        }
+
+     protected:
+        static size_t resolve_encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            use(selected_kernel());
+            return encode(dest, destsize, src, srcsize);
+        }
+        static size_t resolve_encoded_size(const char_type* src, size_t srcsize) noexcept {
+            use(selected_kernel());
+            return encoded_size(src, srcsize);
+        }
+
+        static std::atomic<code_fn> s_encode;
+        static std::atomic<size_fn> s_encoded_size;
+        static std::atomic<kernel_id> s_kernel;
+    };
+
+    template <class ENCODER>
+    std::atomic<typename dispatched_encoder<ENCODER>::code_fn> dispatched_encoder<ENCODER>::s_encode{&dispatched_encoder<ENCODER>::resolve_encode};
+    template <class ENCODER>
+    std::atomic<typename dispatched_encoder<ENCODER>::size_fn> dispatched_encoder<ENCODER>::s_encoded_size{&dispatched_encoder<ENCODER>::resolve_encoded_size};
+    template <class ENCODER>
+    std::atomic<kernel_id> dispatched_encoder<ENCODER>::s_kernel{kernel_id::scalar};
+
+    /**************************************************************************************
+     * Dispatched decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Decoder that forwards to the best kernel for this host.
+     *
+     * Same resolution scheme as dispatched_encoder.
+     *
+     * @tparam DECODER  the decoder_base type to accelerate
+     */
+    template <class DECODER>
+    struct dispatched_decoder : public DECODER {
+        using char_type = typename DECODER::char_type;
+        using code_fn   = typename kernels<DECODER>::code_fn;
+        using size_fn   = typename kernels<DECODER>::size_fn;
+
+        /** @copydoc decoder_base::decoded_size */
+        static inline size_t decoded_size(const char_type* src, size_t srcsize) noexcept {
+            return s_decoded_size.load(std::memory_order_relaxed)(src, srcsize);
+        }
+
+        /** @copydoc decoder_base::decode */
+        static inline size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return s_decode.load(std::memory_order_relaxed)(dest, destsize, src, srcsize);
+        }
+
+        /**
+         * @copydoc decoded_size
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t decoded_size(const _FromT* src, size_t srcsize) noexcept {
+            return decoded_size(reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+        /**
+         * @copydoc decode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t decode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return decode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+        /** @copydoc dispatched_encoder::use */
+        static bool use(kernel_id k) noexcept {
+            if (!kernel_supported(k)) return false;
+            code_fn dec  = kernels<DECODER>::decode(k);
+            size_fn size = kernels<DECODER>::decoded_size(k);
+            if (!dec || !size) {
+                k    = kernel_id::scalar;
+                dec  = static_cast<code_fn>(&DECODER::decode);
+                size = static_cast<size_fn>(&DECODER::decoded_size);
+            }
+            s_kernel.store(k, std::memory_order_relaxed);
+            s_decoded_size.store(size, std::memory_order_relaxed);
+            s_decode.store(dec, std::memory_order_relaxed);
+            return true;
+        }
+
+        /** @copydoc dispatched_encoder::active */
+        static kernel_id active() noexcept {
+            if (s_decode.load(std::memory_order_relaxed) == &resolve_decode) use(selected_kernel());
+            return s_kernel.load(std::memory_order_relaxed);
+        }
+
+     protected:
+        static size_t resolve_decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            use(selected_kernel());
+            return decode(dest, destsize, src, srcsize);
+        }
+        static size_t resolve_decoded_size(const char_type* src, size_t srcsize) noexcept {
+            use(selected_kernel());
+            return decoded_size(src, srcsize);
+        }
+
+        static std::atomic<code_fn> s_decode;
+        static std::atomic<size_fn> s_decoded_size;
+        static std::atomic<kernel_id> s_kernel;
+    };
+
+    template <class DECODER>
+    std::atomic<typename dispatched_decoder<DECODER>::code_fn> dispatched_decoder<DECODER>::s_decode{&dispatched_decoder<DECODER>::resolve_decode};
+    template <class DECODER>
+    std::atomic<typename dispatched_decoder<DECODER>::size_fn> dispatched_decoder<DECODER>::s_decoded_size{&dispatched_decoder<DECODER>::resolve_decoded_size};
+    template <class DECODER>
+    std::atomic<kernel_id> dispatched_decoder<DECODER>::s_kernel{kernel_id::scalar};
+
+}
+
+#endif // __SLIPDISPATCH_H__
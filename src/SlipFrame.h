@@ -0,0 +1,175 @@
+/*!
+ *  @file SlipFrame.h
+ *
+ *  Owning frame buffer with inline storage for short packets.
+ */
+
+#pragma once
+
+#ifndef __SLIPFRAME_H__
+    #define __SLIPFRAME_H__
+
+    #include "SlipInPlace.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * Owning frame with small-buffer optimisation
+     **************************************************************************************/
+
+    /**
+     * @brief Owning, movable frame buffer.
+     *
+     * Frames of up to N characters live inside the object. Larger frames spill
+     * to one heap block, sized exactly. encode_into() and decode_from() size the
+     * frame once with encoded_size() / decoded_size() and code straight into it.
+     *
+     * ```c++
+     * slip::frame<128> request;
+     * request.encode_into(payload, psize);    // no heap use up to 128 encoded bytes
+     * write(fd, request.data(), request.size());
+     * ```
+     *
+     * @tparam N        inline capacity in characters
+     * @tparam _CharT   character type
+     */
+    template <size_t N = 64, typename _CharT = uint8_t>
+    class frame {
+        static_assert(N > 0, "inline capacity must not be zero");
+
+     public:
+        using value_type = _CharT;
+
+        static constexpr size_t inline_capacity = N;
+
+        frame() noexcept : _data(_inline) {}
+        frame(const _CharT* src, size_t size) : frame() { assign(src, size); }
+        frame(const frame& other) : frame() { assign(other.data(), other.size()); }
+        frame(frame&& other) noexcept : frame() { take(other); }
+        ~frame() { release(); }
+
+        frame& operator=(const frame& other) {
+            if (this != &other) assign(other.data(), other.size());
+            return *this;
+        }
+        frame& operator=(frame&& other) noexcept {
+            if (this != &other) {
+                release();
+                take(other);
+            }
+            return *this;
+        }
+
+        _CharT* data() noexcept { return _data; }
+        const _CharT* data() const noexcept { return _data; }
+        size_t size() const noexcept { return _size; }
+        size_t capacity() const noexcept { return _capacity; }
+        bool empty() const noexcept { return _size == 0; }
+        /** Is the frame held in the inline buffer? */
+        bool is_inline() const noexcept { return _data == _inline; }
+
+        _CharT* begin() noexcept { return _data; }
+        _CharT* end() noexcept { return _data + _size; }
+        const _CharT* begin() const noexcept { return _data; }
+        const _CharT* end() const noexcept { return _data + _size; }
+        _CharT& operator[](size_t i) noexcept { return _data[i]; }
+        const _CharT& operator[](size_t i) const noexcept { return _data[i]; }
+
+        /** Make room for n characters, keeping the contents. */
+        void reserve(size_t n) {
+            if (n <= _capacity) return;
+            _CharT* heap = new _CharT[n];
+            memcpy(heap, _data, _size * sizeof(_CharT));
+            release();
+            _data     = heap;
+            _capacity = n;
+        }
+
+        /** Resize to n characters, keeping the contents. New characters are undefined. */
+        void resize(size_t n) {
+            reserve(n);
+            _size = n;
+        }
+
+        /** Empty the frame. Keeps any heap block for reuse. */
+        void clear() noexcept { _size = 0; }
+
+        /** Drop any heap block and go back to the empty inline buffer. */
+        void shrink() noexcept {
+            release();
+            _size = 0;
+        }
+
+        /** Replace the contents with a copy of [src, src + size). */
+        void assign(const _CharT* src, size_t size) {
+            _size = 0;
+            resize(size);
+            if (size) memmove(_data, src, size * sizeof(_CharT));
+        }
+
+        /**
+         * @brief Replace the contents with src SLIP-encoded.
+         *
+         * src may be the frame's own contents, which are then encoded in place.
+         *
+         * @tparam ENCODER  the encoder_base type to use
+         * @return size_t   encoded size, or 0 on error (frame left empty)
+         */
+        template <class ENCODER = encoder>
+        size_t encode_into(const _CharT* src, size_t srcsize) {
+            size_t esize = ENCODER::encoded_size(src, srcsize);
+            bool own     = src >= _data && src < _data + _capacity;
+            size_t at    = own ? src - _data : 0;
+            _size        = own ? at + srcsize : 0; // keep an in-place source across reserve()
+            reserve(esize);
+            if (own) src = _data + at;
+            _size = ENCODER::encode(_data, esize, src, srcsize);
+            return _size;
+        }
+
+        /**
+         * @brief Replace the contents with the SLIP frame in src decoded.
+         *
+         * @tparam DECODER  the decoder_base type to use
+         * @return size_t   decoded size, or 0 on error (frame left empty)
+         */
+        template <class DECODER = decoder>
+        size_t decode_from(const _CharT* src, size_t srcsize) {
+            size_t dsize = DECODER::decoded_size(src, srcsize);
+            _size        = 0;
+            if (dsize == 0) return 0;
+            reserve(dsize);
+            _size = DECODER::decode(_data, dsize, src, srcsize);
+            return _size;
+        }
+
+     protected:
+        void release() noexcept {
+            if (_data != _inline) delete[] _data;
+            _data     = _inline;
+            _capacity = N;
+        }
+
+        /** Steal other's heap block or copy its inline contents, leaving other empty. */
+        void take(frame& other) noexcept {
+            if (other.is_inline()) {
+                memcpy(_inline, other._inline, other._size * sizeof(_CharT));
+            } else {
+                _data     = other._data;
+                _capacity = other._capacity;
+            }
+            _size           = other._size;
+            other._data     = other._inline;
+            other._capacity = N;
+            other._size     = 0;
+        }
+
+        _CharT* _data;
+        size_t _size     = 0;
+        size_t _capacity = N;
+        _CharT _inline[N];
+    };
+
+}
+
+#endif // __SLIPFRAME_H__
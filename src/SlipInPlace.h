@@ -39,6 +39,17 @@
         #define SLIP_UNROLL_LOOPS 1
     #endif
 
+    /**
+     * @brief Route the final encoders and decoders through runtime CPU dispatch.
+     *
+     * Defaults to false (0), keeping the header-only scalar code. Host builds can
+     * set this macro to true (1) before including the library header to pick the
+     * fastest kernel in SlipKernels.h once at startup.
+     */
+    #ifndef SLIP_RUNTIME_DISPATCH
+        #define SLIP_RUNTIME_DISPATCH 0
+    #endif
+
     #include <stdint.h> // for uint8_t
     #include <string.h> // for memmove
 
@@ -79,6 +90,27 @@ namespace slip {
         static constexpr uint8_t SLIPX_ESCNULL = 0336; ///< 0xDE (nonstandard)
     };
 
+    /**************************************************************************************
+     * Statistics policy
+     **************************************************************************************/
+
+    /**
+     * @brief Default statistics policy for encoder_base and decoder_base: does nothing.
+     *
+     * Both hooks are empty inline functions, so a codec built with no_stats
+     * compiles to the same code as one without hooks. See SlipStats.h for
+     * policies that count.
+     */
+    struct no_stats {
+        static constexpr bool enabled = false;
+        /** Called by encode with its arguments, before encoding. */
+        template <class CODEC, typename _CharT>
+        static __ALWAYS_INLINE__ void encoding(const _CharT*, size_t, size_t) noexcept {}
+        /** Called by decode with its arguments, before decoding. */
+        template <class CODEC, typename _CharT>
+        static __ALWAYS_INLINE__ void decoding(const _CharT*, size_t, size_t) noexcept {}
+    };
+
     /**************************************************************************************
      * Base for both encoders and decoders
      **************************************************************************************/
@@ -135,7 +167,7 @@ namespace slip {
             return escapes;
         }
 
-    #ifdef SLIP_UNROLL_LOOPS
+    #if SLIP_UNROLL_LOOPS
         static __ALWAYS_INLINE__ int test_codes(const _CharT c, const _CharT* codes) {
             static_assert(max_specials == 3, "too many codecs to unroll. Recompile with -DSLIP_UNROLL_LOOPS=0");
             // a good compiler will notice the short-circuit constexpr evaluation
@@ -175,11 +207,13 @@ namespace slip {
      * @tparam _EscEscC     escaped escape character code \334
      * @tparam _NullC       NULL character code \000
      * @tparam _EscNullC    escaped NULL character code \335 (non-standard)
+     * @tparam _Stats       statistics policy, no_stats by default
      */
     template <typename _CharT, uint8_t _EndC, uint8_t _EscEndC, uint8_t _EscC, uint8_t _EscEscC,
-              uint8_t _NullC = 0, uint8_t _EscNullC = 0>
+              uint8_t _NullC = 0, uint8_t _EscNullC = 0, class _Stats = no_stats>
     struct encoder_base : public slip_base<_CharT, _EndC, _EscEndC, _EscC, _EscEscC, _NullC, _EscNullC> {
         using BASE = slip_base<_CharT, _EndC, _EscEndC, _EscC, _EscEscC, _NullC, _EscNullC>;
+        using stats = _Stats;
         using BASE::end_code;
         using BASE::escend_code;
         using BASE::esc_code;
@@ -237,6 +271,7 @@ namespace slip {
             const _CharT* send                 = src + srcsize;
             _CharT* dstart                     = dest;
             _CharT* dend                       = dest + destsize;
+            _Stats::template encoding<encoder_base>(src, srcsize, dest ? destsize : 0);
             if (!dest || !src || destsize < srcsize + 1)
                 return BAD_DECODE;
             if (dest <= src && src <= dend) { // sbuf somewhere in dbuf. So in-place
@@ -267,6 +302,84 @@ namespace slip {
             return dest - dstart;
         }
 
+        /**
+         * @brief Encode in place while keeping room before and after the frame.
+         *
+         * For protocol layering, like sk_buff headroom and tailroom: the payload
+         * buf[offset, offset + srcsize) is encoded in place so that at least
+         * headroom characters stay free in front of the frame and tailroom
+         * characters stay free after it. Outer layers can then write a header and
+         * trailer around the frame without moving it.
+         *
+         * The frame starts at the payload whenever the room allows. It is encoded
+         * back-to-front, so no payload characters are moved first. Otherwise it
+         * starts as close to the payload as the room allows. Only when that is
+         * within the escape count before the payload is the payload moved once.
+         *
+         * @param buf       whole buffer
+         * @param bufsize   size of buf
+         * @param offset    in: payload start. out: encoded frame start
+         * @param srcsize   payload size
+         * @param headroom  characters to keep free before the frame
+         * @param tailroom  characters to keep free after the frame
+         * @return size_t   final encoded size or 0 if it does not fit
+         */
+        static inline size_t encode_with_room(_CharT* buf, size_t bufsize, size_t& offset, size_t srcsize,
+                                              size_t headroom = 0, size_t tailroom = 0) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            static const _CharT* specials      = special_codes();
+            static const _CharT* escapes       = escaped_codes();
+            if (!buf || offset > bufsize || srcsize > bufsize - offset) return BAD_DECODE;
+            size_t esize = encoded_size(buf + offset, srcsize);
+            bool room    = headroom <= bufsize && tailroom <= bufsize - headroom;
+            _Stats::template encoding<encoder_base>(buf + offset, srcsize, room ? bufsize - headroom - tailroom : 0);
+            if (!room || esize > bufsize - headroom - tailroom)
+                return BAD_DECODE;
+            size_t last  = bufsize - tailroom - esize; // last frame start that keeps the tailroom
+            size_t at    = (offset < headroom) ? headroom : (offset > last ? last : offset);
+            size_t nesc  = esize - srcsize - 1;
+            int isp;
+
+            if (at >= offset) {
+                // back-to-front: every write lands at or after the character just read
+                _CharT* dest      = buf + at + esize;
+                const _CharT* src = buf + offset + srcsize;
+                *(--dest)         = end_code();
+                while (src > buf + offset) {
+                    _CharT c = *(--src);
+                    isp      = BASE::test_codes(c, specials);
+                    if (isp < 0) {
+                        *(--dest) = c;
+                    } else {
+                        *(--dest) = escapes[isp];
+                        *(--dest) = esc_code();
+                    }
+                }
+            } else {
+                // front-to-back needs the payload at least nesc characters after the frame
+                if (offset < at + nesc) {
+                    memmove(buf + at + nesc, buf + offset, srcsize * sizeof(_CharT));
+                    offset = at + nesc;
+                }
+                _CharT* dest      = buf + at;
+                const _CharT* src = buf + offset;
+                const _CharT* send = src + srcsize;
+                while (src < send) {
+                    _CharT c = *(src++);
+                    isp      = BASE::test_codes(c, specials);
+                    if (isp < 0) {
+                        *(dest++) = c;
+                    } else {
+                        *(dest++) = esc_code();
+                        *(dest++) = escapes[isp];
+                    }
+                }
+                *dest = end_code();
+            }
+            offset = at;
+            return esize;
+        }
+
         /**
          * @copydoc encoded_size
          * @tparam _FromT must have same element size as _CharT
@@ -286,6 +399,17 @@ namespace slip {
         static inline size_t encode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
             return encode(reinterpret_cast<_CharT*>(dest), destsize, reinterpret_cast<const _CharT*>(src), srcsize);
         }
+
+        /**
+         * @copydoc encode_with_room
+         * @tparam _FromT must have same element size as _CharT
+         */
+        template <typename _FromT,
+            typename std::enable_if<sizeof(_FromT)==sizeof(_CharT),bool>::type = true>
+        static inline size_t encode_with_room(_FromT* buf, size_t bufsize, size_t& offset, size_t srcsize,
+                                              size_t headroom = 0, size_t tailroom = 0) noexcept {
+            return encode_with_room(reinterpret_cast<_CharT*>(buf), bufsize, offset, srcsize, headroom, tailroom);
+        }
     };
 
     /**************************************************************************************
@@ -304,11 +428,13 @@ namespace slip {
      * @tparam _EscEscC     escaped escape character code \334
      * @tparam _NullC       NULL character code \000
      * @tparam _EscNullC    escaped NULL character code \335 (non-standard)
+     * @tparam _Stats       statistics policy, no_stats by default
      */
     template <typename _CharT, uint8_t _EndC, uint8_t _EscEndC, uint8_t _EscC, uint8_t _EscEscC,
-              uint8_t _NullC = 0, uint8_t _EscNullC = 0>
+              uint8_t _NullC = 0, uint8_t _EscNullC = 0, class _Stats = no_stats>
     struct decoder_base : public slip_base<_CharT,  _EndC, _EscEndC, _EscC, _EscEscC, _NullC, _EscNullC> {
         using BASE = slip_base<_CharT, _EndC, _EscEndC, _EscC, _EscEscC, _NullC, _EscNullC>;
+        using stats = _Stats;
         using BASE::end_code;
         using BASE::escend_code;
         using BASE::esc_code;
@@ -368,6 +494,7 @@ namespace slip {
             const _CharT* send                 = src + srcsize;
             _CharT* dstart                     = dest;
             _CharT* dend                       = dest + destsize;
+            _Stats::template decoding<decoder_base>(src, srcsize, dest ? destsize : 0);
             if (!dest || !src || srcsize < 1 || destsize < 1) return BAD_DECODE;
             int isp;
 
@@ -415,22 +542,40 @@ namespace slip {
      **************************************************************************************/
 
     /** standard SLIP encoder template */
-    template <typename _CharT>
-    using slip_encoder_base = encoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC>;
+    template <typename _CharT, class _Stats = no_stats>
+    using slip_encoder_base = encoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC, 0, 0, _Stats>;
     /** standard SLIP decoder template */
-    template <typename _CharT>
-    using slip_decoder_base = decoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC>;
+    template <typename _CharT, class _Stats = no_stats>
+    using slip_decoder_base = decoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC, 0, 0, _Stats>;
     /** SLIP+NULL encoder template */
-    template <typename _CharT>
-    using slipnull_encoder_base = encoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC, stdcodes::SLIPX_NULL, stdcodes::SLIPX_ESCNULL>;
+    template <typename _CharT, class _Stats = no_stats>
+    using slipnull_encoder_base = encoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC, stdcodes::SLIPX_NULL, stdcodes::SLIPX_ESCNULL, _Stats>;
     /** SLIP+NULL decoder template */
-    template <typename _CharT>
-    using slipnull_decoder_base = decoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC, stdcodes::SLIPX_NULL, stdcodes::SLIPX_ESCNULL>;
+    template <typename _CharT, class _Stats = no_stats>
+    using slipnull_decoder_base = decoder_base<_CharT, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESC, stdcodes::SLIP_ESCESC, stdcodes::SLIPX_NULL, stdcodes::SLIPX_ESCNULL, _Stats>;
+
+}
+
+    #if SLIP_RUNTIME_DISPATCH
+        #include "SlipDispatch.h"
+    #endif
+
+namespace slip {
 
     /**************************************************************************************
      * Final byte-oriented (uint8_t) standard encoder and decoder
      **************************************************************************************/
 
+    #if SLIP_RUNTIME_DISPATCH
+    /** byte-oriented standard SLIP encoder */
+    using encoder = dispatched_encoder<slip_encoder_base<uint8_t>>;
+    /** byte-oriented standard SLIP decoder */
+    using decoder = dispatched_decoder<slip_decoder_base<uint8_t>>;
+    /** byte-oriented SLIP+NULL encoder */
+    using null_encoder = dispatched_encoder<slipnull_encoder_base<uint8_t>>;
+    /** byte-oriented SLIP+NULL decoder */
+    using null_decoder = dispatched_decoder<slipnull_decoder_base<uint8_t>>;
+    #else
     /** byte-oriented standard SLIP encoder */
     using encoder = slip_encoder_base<uint8_t>;
     /** byte-oriented standard SLIP decoder */
@@ -439,6 +584,7 @@ namespace slip {
     using null_encoder = slipnull_encoder_base<uint8_t>;
     /** byte-oriented SLIP+NULL decoder */
     using null_decoder = slipnull_decoder_base<uint8_t>;
+    #endif
 
 }
 
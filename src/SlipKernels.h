@@ -0,0 +1,628 @@
+/*!
+ *  @file SlipKernels.h
+ *
+ *  Vectorized SLIP encode/decode kernels for x86 hosts.
+ *
+ *  Every kernel gives exactly the same results, errors and buffer writes as
+ *  the scalar encoder_base/decoder_base functions. Host-only. Not included by
+ *  SlipInPlace.h unless SLIP_RUNTIME_DISPATCH is set.
+ */
+
+#pragma once
+
+#ifndef __SLIPKERNELS_H__
+    #define __SLIPKERNELS_H__
+
+    #include "SlipInPlace.h"
+
+    #if !defined(SLIP_X86_KERNELS)
+        #if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+            #define SLIP_X86_KERNELS 1
+        #else
+            #define SLIP_X86_KERNELS 0
+        #endif
+    #endif
+
+    #if SLIP_X86_KERNELS
+        #include <immintrin.h>
+    #endif
+
+namespace slip {
+
+    /**************************************************************************************
+     * Kernel identifiers
+     **************************************************************************************/
+
+    /** Available encode/decode kernels, from slowest to fastest. */
+    enum class kernel_id : uint8_t {
+        scalar,      ///< header-only encoder_base/decoder_base code
+        sse2,        ///< 16-byte run-skipping
+        avx2,        ///< 32-byte run-skipping
+        avx512vbmi2, ///< 32/64-byte expand/compress for dense payloads
+        num_kernels
+    };
+
+    /** Short name of a kernel, as accepted by the SLIP_KERNEL environment variable. */
+    inline const char* kernel_name(kernel_id k) noexcept {
+        switch (k) {
+            case kernel_id::scalar: return "scalar";
+            case kernel_id::sse2: return "sse2";
+            case kernel_id::avx2: return "avx2";
+            case kernel_id::avx512vbmi2: return "avx512vbmi2";
+            default: return "unknown";
+        }
+    }
+
+    /** Can this host run kernel k? */
+    inline bool kernel_supported(kernel_id k) noexcept {
+        switch (k) {
+            case kernel_id::scalar: return true;
+    #if SLIP_X86_KERNELS
+            case kernel_id::sse2: __builtin_cpu_init(); return __builtin_cpu_supports("sse2");
+            case kernel_id::avx2: __builtin_cpu_init(); return __builtin_cpu_supports("avx2");
+            case kernel_id::avx512vbmi2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+                       __builtin_cpu_supports("avx512vbmi2") && __builtin_cpu_supports("bmi2");
+    #endif
+            default: return false;
+        }
+    }
+
+    /** Fastest kernel this host can run. */
+    inline kernel_id best_kernel() noexcept {
+        int k = static_cast<int>(kernel_id::num_kernels);
+        while (--k > 0) {
+            if (kernel_supported(static_cast<kernel_id>(k)))
+                break;
+        }
+        return static_cast<kernel_id>(k);
+    }
+
+    /**************************************************************************************
+     * Scalar building blocks shared by all kernels
+     **************************************************************************************/
+
+    /**
+     * @brief Scalar pieces of the SLIP codec that vector kernels fall back on.
+     *
+     * The frame functions replicate the argument checks and in-place handling
+     * of encoder_base::encode and decoder_base::decode, and hand the body of the
+     * frame to RUN::encode_run or RUN::decode_run.
+     *
+     * @tparam CODEC    any encoder_base or decoder_base type
+     */
+    template <class CODEC>
+    struct kernel_base {
+        using char_type = typename CODEC::char_type;
+
+        /** index of c in CODEC::special_codes() or -1 */
+        static __ALWAYS_INLINE__ int special_index(const char_type c) noexcept {
+            if (CODEC::num_specials > 2 && c == CODEC::null_code()) return 2;
+            if (c == CODEC::esc_code()) return 1;
+            if (c == CODEC::end_code()) return 0;
+            return -1;
+        }
+
+        /** index of c in CODEC::escaped_codes() or -1 */
+        static __ALWAYS_INLINE__ int escaped_index(const char_type c) noexcept {
+            if (CODEC::num_specials > 2 && c == CODEC::escnull_code()) return 2;
+            if (c == CODEC::escesc_code()) return 1;
+            if (c == CODEC::escend_code()) return 0;
+            return -1;
+        }
+
+        /** Count the special characters in [src, send) */
+        static inline size_t count_specials(const char_type* src, const char_type* send) noexcept {
+            size_t nspecial = 0;
+            for (; src < send; src++) {
+                if (special_index(src[0]) >= 0) nspecial++;
+            }
+            return nspecial;
+        }
+
+        /** decoder_base::decoded_size starting at src[i] with nescapes already counted */
+        static inline size_t decoded_size_from(const char_type* src, size_t srcsize, size_t i, size_t nescapes) noexcept {
+            for (; i < srcsize; i++) {
+                if (src[i] == CODEC::esc_code()) {
+                    nescapes++;
+                    i++;
+                } else if (src[i] == CODEC::end_code()) {
+                    return srcsize - 1 - nescapes;
+                }
+            }
+            return srcsize - nescapes;
+        }
+
+        /** Encode one special character. Returns the new dest or nullptr if out of room. */
+        static __ALWAYS_INLINE__ char_type* encode_special(char_type* dest, const char_type* dend, const char_type c) noexcept {
+            if (dest + 1 >= dend) return nullptr;
+            *(dest++) = CODEC::esc_code();
+            *(dest++) = CODEC::escaped_codes()[special_index(c)];
+            return dest;
+        }
+
+        /** Scalar encode of [src, send). Returns the new dest or nullptr on error. */
+        static inline char_type* encode_scalar(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            while (src < send) {
+                if (special_index(src[0]) < 0) { // regular character
+                    if (dest >= dend) return nullptr;
+                    *(dest++) = *(src++);
+                } else {
+                    dest = encode_special(dest, dend, *(src++));
+                    if (!dest) return nullptr;
+                }
+            }
+            return dest;
+        }
+
+        /**
+         * Scalar decode of [src, send), stopping at END.
+         * Returns the new dest or nullptr on error.
+         */
+        static inline char_type* decode_scalar(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            int isp;
+            while (src < send) {
+                if (src[0] == CODEC::end_code()) return dest;
+                if (src[0] != CODEC::esc_code()) { // regular character
+                    if (dest >= dend) return nullptr;
+                    *(dest++) = *(src++);
+                } else {
+                    src++;
+                    if (src >= send || dest >= dend) return nullptr;
+                    isp = escaped_index(src[0]);
+                    if (isp < 0) return nullptr; // invalid escape code
+                    *(dest++) = CODEC::special_codes()[isp];
+                    src++;
+                }
+            }
+            return dest;
+        }
+
+        /** Copy n bytes forward. Safe for in-place use where dest <= src. */
+        static __ALWAYS_INLINE__ void copy_forward(char_type* dest, const char_type* src, size_t n) noexcept {
+            while (n--) *(dest++) = *(src++);
+        }
+
+        /** encoder_base::encode with the frame body handled by RUN::encode_run */
+        template <class RUN>
+        static inline size_t encode_frame(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            const char_type* send              = src + srcsize;
+            char_type* dstart                  = dest;
+            char_type* dend                    = dest + destsize;
+            CODEC::stats::template encoding<CODEC>(src, srcsize, dest ? destsize : 0);
+            if (!dest || !src || destsize < srcsize + 1)
+                return BAD_DECODE;
+            if (dest <= src && src <= dend) { // in-place
+                src  = (char_type*)memmove(dest + destsize - srcsize, src, srcsize);
+                send = src + srcsize;
+            }
+            dest = RUN::encode_run(dest, dend, src, send);
+            if (!dest || dest >= dend)
+                return BAD_DECODE;
+            *(dest++) = CODEC::end_code();
+            return dest - dstart;
+        }
+
+        /** decoder_base::decode with the frame body handled by RUN::decode_run */
+        template <class RUN>
+        static inline size_t decode_frame(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            char_type* dstart                  = dest;
+            CODEC::stats::template decoding<CODEC>(src, srcsize, dest ? destsize : 0);
+            if (!dest || !src || srcsize < 1 || destsize < 1) return BAD_DECODE;
+            dest = RUN::decode_run(dest, dest + destsize, src, src + srcsize);
+            return dest ? dest - dstart : BAD_DECODE;
+        }
+    };
+
+    #if SLIP_X86_KERNELS
+
+    /**************************************************************************************
+     * SSE2 run-skipping kernel
+     **************************************************************************************/
+
+    /**
+     * @brief 16-byte run-skipping kernel.
+     *
+     * Copies whole 16-byte blocks that hold no special characters and falls back
+     * to the scalar code for each special. Fastest on sparse payloads.
+     */
+    template <class CODEC>
+    struct sse2_kernel : public kernel_base<CODEC> {
+        using BASE      = kernel_base<CODEC>;
+        using char_type = typename CODEC::char_type;
+        static constexpr size_t block = 16;
+
+        static __ALWAYS_INLINE__ __m128i splat(const char_type c) noexcept { return _mm_set1_epi8(static_cast<char>(c)); }
+
+        /** bit mask of the bytes that need escaping */
+        static __ALWAYS_INLINE__ unsigned special_mask(const __m128i v) noexcept {
+            __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, splat(CODEC::end_code())), _mm_cmpeq_epi8(v, splat(CODEC::esc_code())));
+            if (CODEC::is_null_encoded) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, splat(CODEC::null_code())));
+            return static_cast<unsigned>(_mm_movemask_epi8(m));
+        }
+
+        /** bit mask of the END and ESC bytes */
+        static __ALWAYS_INLINE__ unsigned frame_mask(const __m128i v) noexcept {
+            __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, splat(CODEC::end_code())), _mm_cmpeq_epi8(v, splat(CODEC::esc_code())));
+            return static_cast<unsigned>(_mm_movemask_epi8(m));
+        }
+
+        static inline char_type* encode_run(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            while (send - src >= (ptrdiff_t)block && dend - dest >= (ptrdiff_t)block) {
+                __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                unsigned m = special_mask(v);
+                if (m == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), v);
+                    dest += block;
+                    src += block;
+                    continue;
+                }
+                unsigned n = __builtin_ctz(m);
+                BASE::copy_forward(dest, src, n);
+                dest = BASE::encode_special(dest + n, dend, src[n]);
+                if (!dest) return nullptr;
+                src += n + 1;
+            }
+            return BASE::encode_scalar(dest, dend, src, send);
+        }
+
+        static inline char_type* decode_run(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            int isp;
+            while (send - src >= (ptrdiff_t)block && dend - dest >= (ptrdiff_t)block) {
+                __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                unsigned m = frame_mask(v);
+                if (m == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), v);
+                    dest += block;
+                    src += block;
+                    continue;
+                }
+                unsigned n = __builtin_ctz(m);
+                BASE::copy_forward(dest, src, n);
+                dest += n;
+                src += n;
+                if (src[0] == CODEC::end_code()) return dest;
+                if (src + 1 >= send) return nullptr; // ESC at the very end
+                isp = BASE::escaped_index(src[1]);
+                if (isp < 0) return nullptr;
+                *(dest++) = CODEC::special_codes()[isp];
+                src += 2;
+            }
+            return BASE::decode_scalar(dest, dend, src, send);
+        }
+
+        /** @copydoc encoder_base::encoded_size */
+        static inline size_t encoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t nspecial = 0, i = 0;
+            for (; i + block <= srcsize; i += block)
+                nspecial += __builtin_popcount(special_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+            return srcsize + nspecial + BASE::count_specials(src + i, src + srcsize) + 1;
+        }
+
+        /** @copydoc encoder_base::encode */
+        static inline size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return BASE::template encode_frame<sse2_kernel>(dest, destsize, src, srcsize);
+        }
+
+        /** @copydoc decoder_base::decoded_size */
+        static inline size_t decoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t nescapes = 0, i = 0;
+            while (i + block <= srcsize) {
+                unsigned m = frame_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+                if (m == 0) {
+                    i += block;
+                    continue;
+                }
+                i += __builtin_ctz(m);
+                if (src[i] == CODEC::end_code()) return srcsize - 1 - nescapes;
+                nescapes++;
+                i += 2;
+            }
+            return BASE::decoded_size_from(src, srcsize, i, nescapes);
+        }
+
+        /** @copydoc decoder_base::decode */
+        static inline size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return BASE::template decode_frame<sse2_kernel>(dest, destsize, src, srcsize);
+        }
+    };
+
+    /**************************************************************************************
+     * AVX2 run-skipping kernel
+     **************************************************************************************/
+
+        #define __SLIP_AVX2__ __attribute__((__target__("avx2,bmi,popcnt")))
+
+    /**
+     * @brief 32-byte run-skipping kernel. Same algorithm as sse2_kernel.
+     */
+    template <class CODEC>
+    struct avx2_kernel : public kernel_base<CODEC> {
+        using BASE      = kernel_base<CODEC>;
+        using char_type = typename CODEC::char_type;
+        static constexpr size_t block = 32;
+
+        static __SLIP_AVX2__ __ALWAYS_INLINE__ __m256i splat(const char_type c) noexcept { return _mm256_set1_epi8(static_cast<char>(c)); }
+
+        static __SLIP_AVX2__ __ALWAYS_INLINE__ uint32_t special_mask(const __m256i v) noexcept {
+            __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, splat(CODEC::end_code())), _mm256_cmpeq_epi8(v, splat(CODEC::esc_code())));
+            if (CODEC::is_null_encoded) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, splat(CODEC::null_code())));
+            return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+        }
+
+        static __SLIP_AVX2__ __ALWAYS_INLINE__ uint32_t frame_mask(const __m256i v) noexcept {
+            __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, splat(CODEC::end_code())), _mm256_cmpeq_epi8(v, splat(CODEC::esc_code())));
+            return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+        }
+
+        static __SLIP_AVX2__ char_type* encode_run(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            while (send - src >= (ptrdiff_t)block && dend - dest >= (ptrdiff_t)block) {
+                __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+                uint32_t m = special_mask(v);
+                if (m == 0) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), v);
+                    dest += block;
+                    src += block;
+                    continue;
+                }
+                unsigned n = __builtin_ctz(m);
+                BASE::copy_forward(dest, src, n);
+                dest = BASE::encode_special(dest + n, dend, src[n]);
+                if (!dest) return nullptr;
+                src += n + 1;
+            }
+            return BASE::encode_scalar(dest, dend, src, send);
+        }
+
+        static __SLIP_AVX2__ char_type* decode_run(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            int isp;
+            while (send - src >= (ptrdiff_t)block && dend - dest >= (ptrdiff_t)block) {
+                __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+                uint32_t m = frame_mask(v);
+                if (m == 0) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), v);
+                    dest += block;
+                    src += block;
+                    continue;
+                }
+                unsigned n = __builtin_ctz(m);
+                BASE::copy_forward(dest, src, n);
+                dest += n;
+                src += n;
+                if (src[0] == CODEC::end_code()) return dest;
+                if (src + 1 >= send) return nullptr; // ESC at the very end
+                isp = BASE::escaped_index(src[1]);
+                if (isp < 0) return nullptr;
+                *(dest++) = CODEC::special_codes()[isp];
+                src += 2;
+            }
+            return BASE::decode_scalar(dest, dend, src, send);
+        }
+
+        /** @copydoc encoder_base::encoded_size */
+        static __SLIP_AVX2__ size_t encoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t nspecial = 0, i = 0;
+            for (; i + block <= srcsize; i += block)
+                nspecial += __builtin_popcount(special_mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+            return srcsize + nspecial + BASE::count_specials(src + i, src + srcsize) + 1;
+        }
+
+        /** @copydoc encoder_base::encode */
+        static __SLIP_AVX2__ size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return BASE::template encode_frame<avx2_kernel>(dest, destsize, src, srcsize);
+        }
+
+        /** @copydoc decoder_base::decoded_size */
+        static __SLIP_AVX2__ size_t decoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t nescapes = 0, i = 0;
+            while (i + block <= srcsize) {
+                uint32_t m = frame_mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+                if (m == 0) {
+                    i += block;
+                    continue;
+                }
+                i += __builtin_ctz(m);
+                if (src[i] == CODEC::end_code()) return srcsize - 1 - nescapes;
+                nescapes++;
+                i += 2;
+            }
+            return BASE::decoded_size_from(src, srcsize, i, nescapes);
+        }
+
+        /** @copydoc decoder_base::decode */
+        static __SLIP_AVX2__ size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return BASE::template decode_frame<avx2_kernel>(dest, destsize, src, srcsize);
+        }
+    };
+
+    /**************************************************************************************
+     * AVX-512 VBMI2 expand/compress kernel
+     **************************************************************************************/
+
+        #define __SLIP_AVX512VBMI2__ __attribute__((__target__("avx512f,avx512bw,avx512vl,avx512vbmi2,bmi,bmi2,popcnt")))
+
+    /**
+     * @brief Dense-payload kernel built on vpexpandb/vpcompressb.
+     *
+     * Encoding takes 32 source bytes at a time. It swaps every special for its escaped
+     * code, spreads the bytes into place with vpexpandb and fills the gaps with ESC.
+     * Decoding takes 64 source bytes at a time. It swaps each escaped code for its
+     * original and squeezes the ESC bytes out with vpcompressb. Blocks are never
+     * skipped, so throughput stays flat however dense the special characters are.
+     * Blocks that hold END, an invalid escape or too little room fall back to scalar code.
+     */
+    template <class CODEC>
+    struct avx512vbmi2_kernel : public kernel_base<CODEC> {
+        using BASE      = kernel_base<CODEC>;
+        using char_type = typename CODEC::char_type;
+        static constexpr size_t encode_block = 32;
+        static constexpr size_t decode_block = 64;
+        static constexpr uint64_t even_bits  = 0x5555555555555555ull;
+        static constexpr uint64_t odd_bits   = 0xAAAAAAAAAAAAAAAAull;
+
+        static __SLIP_AVX512VBMI2__ __ALWAYS_INLINE__ __m512i splat(const char_type c) noexcept { return _mm512_set1_epi8(static_cast<char>(c)); }
+
+        static __SLIP_AVX512VBMI2__ __ALWAYS_INLINE__ uint64_t eq(const __m512i v, const char_type c) noexcept {
+            return _mm512_cmpeq_epi8_mask(v, splat(c));
+        }
+
+        /** mask with the low n bits set, n <= 64 */
+        static __ALWAYS_INLINE__ uint64_t low_bits(size_t n) noexcept { return n >= 64 ? ~0ull : ((1ull << n) - 1); }
+
+        static __SLIP_AVX512VBMI2__ char_type* encode_run(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            const __m512i esc = splat(CODEC::esc_code());
+            while (send - src >= (ptrdiff_t)encode_block && dend - dest >= (ptrdiff_t)(2 * encode_block)) {
+                __m512i v      = _mm512_maskz_loadu_epi8(low_bits(encode_block), src);
+                uint64_t m_end = eq(v, CODEC::end_code()) & low_bits(encode_block);
+                uint64_t m_esc = eq(v, CODEC::esc_code()) & low_bits(encode_block);
+                uint64_t m_nul = CODEC::is_null_encoded ? eq(v, CODEC::null_code()) & low_bits(encode_block) : 0;
+                uint64_t m     = m_end | m_esc | m_nul;
+                // swap specials for their escaped codes
+                v = _mm512_mask_mov_epi8(v, m_end, splat(CODEC::escend_code()));
+                v = _mm512_mask_mov_epi8(v, m_esc, splat(CODEC::escesc_code()));
+                if (CODEC::is_null_encoded) v = _mm512_mask_mov_epi8(v, m_nul, splat(CODEC::escnull_code()));
+                // source byte i becomes two slots: bit 2i (ESC, specials only) and bit 2i+1 (data).
+                // pext drops the unused slots to give the output positions.
+                uint64_t gap_slots = _pdep_u64(m, even_bits);
+                uint64_t used      = gap_slots | odd_bits;
+                uint64_t data      = _pext_u64(odd_bits, used);
+                uint64_t gaps      = _pext_u64(gap_slots, used);
+                size_t nout        = encode_block + _mm_popcnt_u64(m);
+                __m512i out        = _mm512_maskz_expand_epi8(data, v);
+                out                = _mm512_mask_mov_epi8(out, gaps, esc);
+                _mm512_mask_storeu_epi8(dest, low_bits(nout), out);
+                dest += nout;
+                src += encode_block;
+            }
+            return BASE::encode_scalar(dest, dend, src, send);
+        }
+
+        static __SLIP_AVX512VBMI2__ char_type* decode_run(char_type* dest, const char_type* dend, const char_type* src, const char_type* send) noexcept {
+            while (send - src >= (ptrdiff_t)decode_block && dend - dest >= (ptrdiff_t)decode_block) {
+                __m512i v      = _mm512_loadu_si512(src);
+                uint64_t m_esc = eq(v, CODEC::esc_code());
+                if (eq(v, CODEC::end_code()) || (m_esc & (m_esc << 1))) break; // END or ESC ESC: let scalar code sort it out
+                // an ESC in the last byte escapes the next block. Leave it for the next pass
+                size_t len    = decode_block - (m_esc >> 63);
+                uint64_t keep = low_bits(len);
+                m_esc &= keep;
+                uint64_t payload  = m_esc << 1;
+                uint64_t p_escend = eq(v, CODEC::escend_code()) & payload;
+                uint64_t p_escesc = eq(v, CODEC::escesc_code()) & payload;
+                uint64_t p_escnul = CODEC::is_null_encoded ? eq(v, CODEC::escnull_code()) & payload : 0;
+                if ((p_escend | p_escesc | p_escnul) != payload) break; // invalid escape code
+                v = _mm512_mask_mov_epi8(v, p_escend, splat(CODEC::end_code()));
+                v = _mm512_mask_mov_epi8(v, p_escesc, splat(CODEC::esc_code()));
+                if (CODEC::is_null_encoded) v = _mm512_mask_mov_epi8(v, p_escnul, splat(CODEC::null_code()));
+                size_t nout = len - _mm_popcnt_u64(m_esc);
+                _mm512_mask_storeu_epi8(dest, low_bits(nout), _mm512_maskz_compress_epi8(keep & ~m_esc, v));
+                dest += nout;
+                src += len;
+            }
+            return BASE::decode_scalar(dest, dend, src, send);
+        }
+
+        /** @copydoc encoder_base::encoded_size */
+        static __SLIP_AVX512VBMI2__ size_t encoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t nspecial = 0, i = 0;
+            for (; i + decode_block <= srcsize; i += decode_block) {
+                __m512i v = _mm512_loadu_si512(src + i);
+                uint64_t m = eq(v, CODEC::end_code()) | eq(v, CODEC::esc_code());
+                if (CODEC::is_null_encoded) m |= eq(v, CODEC::null_code());
+                nspecial += _mm_popcnt_u64(m);
+            }
+            return srcsize + nspecial + BASE::count_specials(src + i, src + srcsize) + 1;
+        }
+
+        /** @copydoc encoder_base::encode */
+        static __SLIP_AVX512VBMI2__ size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return BASE::template encode_frame<avx512vbmi2_kernel>(dest, destsize, src, srcsize);
+        }
+
+        /** @copydoc decoder_base::decoded_size */
+        static __SLIP_AVX512VBMI2__ size_t decoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t nescapes = 0, i = 0;
+            while (i + decode_block <= srcsize) {
+                __m512i v      = _mm512_loadu_si512(src + i);
+                uint64_t m_esc = eq(v, CODEC::esc_code());
+                if (eq(v, CODEC::end_code()) || (m_esc & (m_esc << 1))) break;
+                nescapes += _mm_popcnt_u64(m_esc);
+                i += decode_block + (m_esc >> 63); // skip the payload of a trailing ESC
+            }
+            return BASE::decoded_size_from(src, srcsize, i, nescapes);
+        }
+
+        /** @copydoc decoder_base::decode */
+        static __SLIP_AVX512VBMI2__ size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            return BASE::template decode_frame<avx512vbmi2_kernel>(dest, destsize, src, srcsize);
+        }
+    };
+
+    #endif // SLIP_X86_KERNELS
+
+    /**************************************************************************************
+     * Kernel lookup
+     **************************************************************************************/
+
+    /**
+     * @brief Function pointers to every kernel for one codec.
+     *
+     * Lookups for kernels that are not compiled in return nullptr.
+     * The scalar kernel is the codec's own encode/decode function.
+     *
+     * @tparam CODEC    any encoder_base or decoder_base type
+     */
+    template <class CODEC>
+    struct kernels {
+        using char_type = typename CODEC::char_type;
+        using code_fn   = size_t (*)(char_type*, size_t, const char_type*, size_t); ///< encode or decode
+        using size_fn   = size_t (*)(const char_type*, size_t);                     ///< encoded_size or decoded_size
+
+        static code_fn encode(kernel_id k) noexcept {
+            switch (k) {
+    #if SLIP_X86_KERNELS
+                case kernel_id::sse2: return &sse2_kernel<CODEC>::encode;
+                case kernel_id::avx2: return &avx2_kernel<CODEC>::encode;
+                case kernel_id::avx512vbmi2: return &avx512vbmi2_kernel<CODEC>::encode;
+    #endif
+                default: return nullptr;
+            }
+        }
+        static size_fn encoded_size(kernel_id k) noexcept {
+            switch (k) {
+    #if SLIP_X86_KERNELS
+                case kernel_id::sse2: return &sse2_kernel<CODEC>::encoded_size;
+                case kernel_id::avx2: return &avx2_kernel<CODEC>::encoded_size;
+                case kernel_id::avx512vbmi2: return &avx512vbmi2_kernel<CODEC>::encoded_size;
+    #endif
+                default: return nullptr;
+            }
+        }
+        static code_fn decode(kernel_id k) noexcept {
+            switch (k) {
+    #if SLIP_X86_KERNELS
+                case kernel_id::sse2: return &sse2_kernel<CODEC>::decode;
+                case kernel_id::avx2: return &avx2_kernel<CODEC>::decode;
+                case kernel_id::avx512vbmi2: return &avx512vbmi2_kernel<CODEC>::decode;
+    #endif
+                default: return nullptr;
+            }
+        }
+        static size_fn decoded_size(kernel_id k) noexcept {
+            switch (k) {
+    #if SLIP_X86_KERNELS
+                case kernel_id::sse2: return &sse2_kernel<CODEC>::decoded_size;
+                case kernel_id::avx2: return &avx2_kernel<CODEC>::decoded_size;
+                case kernel_id::avx512vbmi2: return &avx512vbmi2_kernel<CODEC>::decoded_size;
+    #endif
+                default: return nullptr;
+            }
+        }
+    };
+
+}
+
+#endif // __SLIPKERNELS_H__
@@ -0,0 +1,417 @@
+/*!
+ *  @file SlipKiss.h
+ *
+ *  KISS TNC framing: SLIP frames with a leading port/command character, and a
+ *  stream decoder that hands each frame to its port in one pass.
+ */
+
+#pragma once
+
+#ifndef __SLIPKISS_H__
+    #define __SLIPKISS_H__
+
+    #include "SlipInPlace.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * KISS codes
+     **************************************************************************************/
+
+    /* The type character: port in the high nibble, command in the low nibble. */
+    struct kiss {
+        static constexpr uint8_t DATA        = 0x0; ///< data frame
+        static constexpr uint8_t TXDELAY     = 0x1; ///< keyup delay, 10 ms units
+        static constexpr uint8_t PERSIST     = 0x2; ///< persistence p, 0-255
+        static constexpr uint8_t SLOTTIME    = 0x3; ///< slot interval, 10 ms units
+        static constexpr uint8_t TXTAIL      = 0x4; ///< time to hold after the frame, 10 ms units
+        static constexpr uint8_t FULLDUPLEX  = 0x5; ///< 0 half duplex, nonzero full duplex
+        static constexpr uint8_t SETHARDWARE = 0x6; ///< TNC specific
+        static constexpr uint8_t RETURN      = 0xF; ///< leave KISS mode (type character 0xFF)
+
+        static constexpr uint8_t num_ports = 16;
+
+        static constexpr uint8_t type(uint8_t port, uint8_t command) noexcept {
+            return static_cast<uint8_t>((port << 4) | (command & 0x0f));
+        }
+        static constexpr uint8_t port(uint8_t type) noexcept { return type >> 4; }
+        static constexpr uint8_t command(uint8_t type) noexcept { return type & 0x0f; }
+    };
+
+    /** @brief Per-port channel parameters set by KISS command frames, with the KISS defaults. */
+    struct kiss_params {
+        uint8_t txdelay     = 50;
+        uint8_t persist     = 63;
+        uint8_t slottime    = 10;
+        uint8_t txtail      = 0;
+        uint8_t full_duplex = 0;
+    };
+
+    /**************************************************************************************
+     * KISS encoder and decoder
+     **************************************************************************************/
+
+    /**
+     * @brief KISS frame encoder: FEND, the type character, the escaped payload, FEND.
+     *
+     * @tparam ENCODER  the encoder_base type to use for the payload
+     */
+    template <class ENCODER = encoder>
+    struct kiss_encoder : public ENCODER {
+        using char_type = typename ENCODER::char_type;
+
+        /** @brief Size of the encoded frame, leading FEND and type character included. */
+        static inline size_t encoded_size(const char_type* src, size_t srcsize, uint8_t type = 0) noexcept {
+            return 1 + type_size(type) + ENCODER::encoded_size(src, srcsize);
+        }
+
+        /**
+         * @brief Encode src as a KISS frame for port.
+         *
+         * dest and src may overlap as for encoder_base::encode.
+         *
+         * @return size_t   encoded size, or 0 if dest is too small
+         */
+        static inline size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize,
+                                    uint8_t port = 0, uint8_t command = kiss::DATA) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            uint8_t type                       = kiss::type(port, command);
+            size_t k                           = 1 + type_size(type);
+            if (!dest || !src || destsize < k + srcsize + 1) return BAD_DECODE;
+            if (src < dest + destsize && dest < src + srcsize) { // overlapping: encode from the end, as in-place
+                src = (char_type*)memmove(dest + destsize - srcsize, src, srcsize * sizeof(char_type));
+            }
+            dest[0] = ENCODER::end_code();
+            if (k == 2) {
+                dest[1] = static_cast<char_type>(type);
+            } else {
+                dest[1] = ENCODER::esc_code();
+                dest[2] = escaped(type);
+            }
+            size_t esize = ENCODER::encode(dest + k, destsize - k, src, srcsize);
+            return esize ? k + esize : BAD_DECODE;
+        }
+
+        /**
+         * @brief Encode a one-character command frame such as TXDELAY or PERSIST.
+         * @return size_t   encoded size, or 0 if dest is too small
+         */
+        static inline size_t encode_command(char_type* dest, size_t destsize, uint8_t port, uint8_t command,
+                                            uint8_t value) noexcept {
+            char_type v = static_cast<char_type>(value);
+            return encode(dest, destsize, &v, 1, port, command);
+        }
+
+        /**
+         * @copydoc encoded_size
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encoded_size(const _FromT* src, size_t srcsize, uint8_t type = 0) noexcept {
+            return encoded_size(reinterpret_cast<const char_type*>(src), srcsize, type);
+        }
+
+        /**
+         * @copydoc encode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize,
+                                    uint8_t port = 0, uint8_t command = kiss::DATA) noexcept {
+            return encode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src),
+                          srcsize, port, command);
+        }
+
+        /**
+         * @copydoc encode_command
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encode_command(_FromT* dest, size_t destsize, uint8_t port, uint8_t command,
+                                            uint8_t value) noexcept {
+            return encode_command(reinterpret_cast<char_type*>(dest), destsize, port, command, value);
+        }
+
+     protected:
+        static size_t type_size(uint8_t type) noexcept { return escaped(type) ? 2 : 1; }
+
+        /** The escaped code for a special type character, or 0 if it needs no escape. */
+        static char_type escaped(uint8_t type) noexcept {
+            for (int i = 0; i < ENCODER::num_specials; i++) {
+                if (static_cast<char_type>(type) == ENCODER::special_codes()[i]) return ENCODER::escaped_codes()[i];
+            }
+            return 0;
+        }
+    };
+
+    /**
+     * @brief KISS frame decoder. Splits off the type character while decoding.
+     *
+     * @tparam DECODER  the decoder_base type to use for the payload
+     */
+    template <class DECODER = decoder>
+    struct kiss_decoder : public DECODER {
+        using char_type = typename DECODER::char_type;
+
+        /** @brief Decoded payload size, not counting the type character. */
+        static inline size_t decoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t skip = leading_ends(src, srcsize);
+            size_t size = DECODER::decoded_size(src + skip, srcsize - skip);
+            return size ? size - 1 : 0;
+        }
+
+        /**
+         * @brief Decode a KISS frame. Leading FENDs are skipped.
+         *
+         * dest may be src for in-place decoding.
+         *
+         * @param type      set to the type character, see kiss::port() and kiss::command()
+         * @return size_t   payload size, or 0 on error or an empty payload
+         */
+        static inline size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize,
+                                    uint8_t& type) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            if (!dest || !src) return BAD_DECODE;
+            size_t k = leading_ends(src, srcsize);
+            if (k >= srcsize) return BAD_DECODE;
+            if (src[k] != DECODER::esc_code()) {
+                type = static_cast<uint8_t>(src[k++]);
+            } else {
+                if (k + 1 >= srcsize) return BAD_DECODE;
+                int isp = -1;
+                for (int i = 0; i < DECODER::num_specials; i++) {
+                    if (src[k + 1] == DECODER::escaped_codes()[i]) isp = i;
+                }
+                if (isp < 0) return BAD_DECODE;
+                type = static_cast<uint8_t>(DECODER::special_codes()[isp]);
+                k += 2;
+            }
+            if (k >= srcsize || src[k] == DECODER::end_code()) return 0; // type only
+            return DECODER::decode(dest, destsize, src + k, srcsize - k);
+        }
+
+        /**
+         * @copydoc decoded_size
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t decoded_size(const _FromT* src, size_t srcsize) noexcept {
+            return decoded_size(reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+        /**
+         * @copydoc decode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t decode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize,
+                                    uint8_t& type) noexcept {
+            return decode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src),
+                          srcsize, type);
+        }
+
+     protected:
+        static size_t leading_ends(const char_type* src, size_t srcsize) noexcept {
+            size_t k = 0;
+            while (k < srcsize && src[k] == DECODER::end_code()) k++;
+            return k;
+        }
+    };
+
+    /**************************************************************************************
+     * Demultiplexing stream decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Decodes a KISS byte stream and routes each frame to its port, in one pass.
+     *
+     * Data frames go to the sink registered for their port. Command frames
+     * update that port's kiss_params. SETHARDWARE, RETURN and unknown commands
+     * go to the command sink. The type character is split off while decoding,
+     * so payloads are never shifted.
+     *
+     * A frame that arrives whole in one write() call with no escapes is handed
+     * to its sink straight from the caller's buffer. Otherwise it is decoded
+     * into an internal buffer of N characters.
+     *
+     * ```c++
+     * slip::kiss_demux<> tnc;
+     * tnc.set_sink(0, on_vhf);
+     * tnc.set_sink(1, on_uhf);
+     * tnc.write(buf, read(fd, buf, sizeof(buf)));
+     * ```
+     *
+     * @tparam N        longest payload in characters
+     * @tparam DECODER  the decoder_base type whose codes to use
+     */
+    template <size_t N = 512, class DECODER = decoder>
+    class kiss_demux {
+     public:
+        using char_type = typename DECODER::char_type;
+
+        /** Receives the payload of a data frame. */
+        typedef void (*sink_fn)(void* ctx, uint8_t port, const char_type* data, size_t size);
+        /** Receives a command frame not handled by kiss_params. */
+        typedef void (*command_fn)(void* ctx, uint8_t port, uint8_t command, const char_type* data, size_t size);
+
+        /** Route data frames for port to fn. Frames for ports without a sink are counted in unrouted(). */
+        void set_sink(uint8_t port, sink_fn fn, void* ctx = nullptr) noexcept {
+            if (port >= kiss::num_ports) return;
+            _sinks[port].fn  = fn;
+            _sinks[port].ctx = ctx;
+        }
+
+        void set_command_sink(command_fn fn, void* ctx = nullptr) noexcept {
+            _command     = fn;
+            _command_ctx = ctx;
+        }
+
+        /** Channel parameters last set by command frames for port. */
+        const kiss_params& params(uint8_t port) const noexcept { return _params[port & 0x0f]; }
+
+        /**
+         * @brief Decode and dispatch n received characters.
+         * @return size_t   frames dispatched
+         */
+        size_t write(const char_type* src, size_t n) noexcept {
+            size_t before         = _frames + _commands;
+            const char_type* send = src + n;
+            while (src < send) {
+                if (_typed && !_escaped && !_bad) {
+                    // plain run: find its end, and if the frame is whole and unescaped skip the copy
+                    const char_type* run = src;
+                    while (src < send && *src != DECODER::end_code() && *src != DECODER::esc_code()) src++;
+                    if (_size == 0 && src < send && *src == DECODER::end_code()) {
+                        dispatch(run, src - run);
+                        src++;
+                        continue;
+                    }
+                    append(run, src - run);
+                    if (src == send) break;
+                }
+                push(*(src++));
+            }
+            return _frames + _commands - before;
+        }
+
+        /**
+         * @brief Decode one received character.
+         * @return true     if it completed a frame that was dispatched
+         */
+        bool push(char_type c) noexcept {
+            if (_escaped) {
+                _escaped = false;
+                int isp  = escape_index(c);
+                if (isp < 0) {
+                    _bad = true;
+                } else {
+                    accept(DECODER::special_codes()[isp]);
+                }
+            } else if (c == DECODER::end_code()) {
+                return finish();
+            } else if (c == DECODER::esc_code()) {
+                _escaped = true;
+            } else {
+                accept(c);
+            }
+            return false;
+        }
+
+        size_t frames() const noexcept { return _frames; }     ///< data frames dispatched
+        size_t commands() const noexcept { return _commands; } ///< command frames handled
+        size_t unrouted() const noexcept { return _unrouted; } ///< data frames for ports without a sink
+        size_t errors() const noexcept { return _errors; }     ///< frames dropped as bad or too long
+
+     protected:
+        struct sink {
+            sink_fn fn = nullptr;
+            void* ctx  = nullptr;
+        };
+
+        static int escape_index(char_type c) noexcept {
+            for (int i = 0; i < DECODER::num_specials; i++) {
+                if (c == DECODER::escaped_codes()[i]) return i;
+            }
+            return -1;
+        }
+
+        void accept(char_type c) noexcept {
+            if (!_typed) {
+                _type  = static_cast<uint8_t>(c);
+                _typed = true;
+            } else if (!_bad) {
+                if (_size < N)
+                    _buf[_size++] = c;
+                else
+                    _bad = true;
+            }
+        }
+
+        void append(const char_type* src, size_t n) noexcept {
+            if (_bad || n == 0) return;
+            if (n > N - _size) {
+                _bad = true;
+                return;
+            }
+            memcpy(_buf + _size, src, n * sizeof(char_type));
+            _size += n;
+        }
+
+        bool finish() noexcept {
+            bool done = false;
+            if (_bad) {
+                _errors++;
+            } else if (_typed) {
+                dispatch(_buf, _size);
+                done = true;
+            } // else an empty frame between FENDs
+            _typed = _escaped = _bad = false;
+            _size                    = 0;
+            return done;
+        }
+
+        void dispatch(const char_type* data, size_t size) noexcept {
+            uint8_t port = kiss::port(_type), command = kiss::command(_type);
+            _typed       = false;
+            if (command == kiss::DATA) {
+                _frames++;
+                if (_sinks[port].fn)
+                    _sinks[port].fn(_sinks[port].ctx, port, data, size);
+                else
+                    _unrouted++;
+                return;
+            }
+            _commands++;
+            kiss_params& p = _params[port];
+            uint8_t value  = size ? static_cast<uint8_t>(data[0]) : 0;
+            if (!size && command < kiss::SETHARDWARE) return; // parameter missing
+            switch (command) {
+            case kiss::TXDELAY: p.txdelay = value; break;
+            case kiss::PERSIST: p.persist = value; break;
+            case kiss::SLOTTIME: p.slottime = value; break;
+            case kiss::TXTAIL: p.txtail = value; break;
+            case kiss::FULLDUPLEX: p.full_duplex = value; break;
+            default:
+                if (_command) _command(_command_ctx, port, command, data, size);
+            }
+        }
+
+        char_type _buf[N];
+        size_t _size = 0;
+        uint8_t _type = 0;
+        bool _typed = false, _escaped = false, _bad = false;
+        sink _sinks[kiss::num_ports];
+        kiss_params _params[kiss::num_ports];
+        command_fn _command = nullptr;
+        void* _command_ctx  = nullptr;
+        size_t _frames = 0, _commands = 0, _unrouted = 0, _errors = 0;
+    };
+
+}
+
+#endif // __SLIPKISS_H__
@@ -0,0 +1,257 @@
+/*!
+ *  @file SlipNonTemporal.h
+ *
+ *  Cache-friendly encoding and decoding of buffers much larger than the
+ *  last-level cache.
+ *
+ *  Host-only. Not included by SlipInPlace.h.
+ */
+
+#pragma once
+
+#ifndef __SLIPNONTEMPORAL_H__
+    #define __SLIPNONTEMPORAL_H__
+
+    #include "SlipDispatch.h"
+    #include <algorithm>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Non-temporal copy
+     **************************************************************************************/
+
+    /**
+     * @brief Large-buffer settings shared by nontemporal_encoder and nontemporal_decoder.
+     */
+    struct nontemporal {
+        /** Source bytes encoded or decoded into the staging buffer per step. */
+        static constexpr size_t piece_size = 8192;
+
+        /**
+         * @brief Out-of-place calls with at least this many source bytes use non-temporal stores.
+         * Defaults to 8 MiB, roughly the last-level cache share of one core.
+         */
+        static size_t threshold() noexcept { return setting(0).load(std::memory_order_relaxed); }
+        static void set_threshold(size_t bytes) noexcept { setting(0).store(bytes, std::memory_order_relaxed); }
+
+        /**
+         * @brief Distance the source is software-prefetched ahead of the piece being processed.
+         * 0 (the default) leaves the sequential source to the hardware prefetcher, which
+         * measured faster on the hosts we tried. Try 2 * piece_size on hosts without one.
+         */
+        static size_t prefetch_distance() noexcept { return setting(1).load(std::memory_order_relaxed); }
+        static void set_prefetch_distance(size_t bytes) noexcept { setting(1).store(bytes, std::memory_order_relaxed); }
+
+        /** Prefetch [src, src + size) into all cache levels. */
+        static inline void prefetch(const void* src, size_t size) noexcept {
+    #if SLIP_X86_KERNELS
+            const char* p = static_cast<const char*>(src);
+            for (size_t i = 0; i < size; i += 64)
+                _mm_prefetch(p + i, _MM_HINT_T0);
+    #else
+            (void)src;
+            (void)size;
+    #endif
+        }
+
+        /** Order the non-temporal stores before any later stores. */
+        static inline void fence() noexcept {
+    #if SLIP_X86_KERNELS
+            _mm_sfence();
+    #endif
+        }
+
+        /**
+         * @brief Per-thread staging buffer that drains into dest one aligned 64-byte line at a time.
+         *
+         * stage[k] mirrors the dest address line + k, where line is dest rounded
+         * down to 64 bytes. So every non-temporal store writes one whole aligned
+         * cache line. Partial lines at either end of dest use ordinary stores.
+         *
+         * @tparam _CharT   character type of dest
+         */
+        template <typename _CharT>
+        class stage_writer {
+         public:
+            static constexpr size_t line = 64;
+
+            stage_writer(_CharT* dest) noexcept
+                : _line(reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(dest) & ~uintptr_t(line - 1))),
+                  _start(reinterpret_cast<char*>(dest) - _line), _fill(_start) {}
+
+            /** Where the next staged bytes go. Room for at least 2 * piece_size + 1. */
+            _CharT* tail() noexcept { return reinterpret_cast<_CharT*>(stage() + _fill); }
+
+            /** Hand n freshly staged bytes over and drain every complete line. */
+            void commit(size_t n) noexcept {
+                _fill += n;
+                size_t full = _fill & ~(line - 1);
+                if (full == 0) return;
+                size_t k = 0;
+                if (_start > 0) { // first, partial line
+                    memcpy(_line + _start, stage() + _start, line - _start);
+                    k      = line;
+                    _start = 0;
+                }
+                for (; k < full; k += line)
+                    stream_line(_line + k, stage() + k);
+                _line += full;
+                _fill -= full;
+                memcpy(stage(), stage() + full, _fill);
+            }
+
+            /** Write the last partial line and fence. */
+            void finish() noexcept {
+                memcpy(_line + _start, stage() + _start, _fill - _start);
+                fence();
+            }
+
+         protected:
+            static char* stage() noexcept {
+                alignas(64) static thread_local char buffer[2 * piece_size + 2 * line];
+                return buffer;
+            }
+            static inline void stream_line(char* dest, const char* src) noexcept {
+    #if SLIP_X86_KERNELS
+                for (size_t i = 0; i < line; i += 16)
+                    _mm_stream_si128(reinterpret_cast<__m128i*>(dest + i), _mm_load_si128(reinterpret_cast<const __m128i*>(src + i)));
+    #else
+                memcpy(dest, src, line);
+    #endif
+            }
+
+            char* _line;
+            size_t _start, _fill;
+        };
+
+     protected:
+        static std::atomic<size_t>& setting(int i) noexcept {
+            static std::atomic<size_t> settings[2] = {{size_t(8) << 20}, {0}};
+            return settings[i];
+        }
+    };
+
+    /**************************************************************************************
+     * Large-buffer encoder
+     **************************************************************************************/
+
+    /**
+     * @brief Out-of-place encoder that keeps huge outputs out of the cache.
+     *
+     * Below nontemporal::threshold(), or when dest and src overlap, this is the
+     * dispatched encoder. Above it the source is encoded a piece at a time into a small per-thread staging buffer. Whole aligned cache lines are then
+     * written to dest with non-temporal stores.
+     *
+     * Results match encoder_base::encode. On error the contents of dest are undefined.
+     *
+     * @tparam ENCODER  the encoder_base type to use
+     */
+    template <class ENCODER>
+    struct nontemporal_encoder : public dispatched_encoder<ENCODER> {
+        using BASE      = dispatched_encoder<ENCODER>;
+        using char_type = typename ENCODER::char_type;
+        using BASE::encoded_size;
+
+        /** @copydoc encoder_base::encode */
+        static size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            if (!dest || !src || destsize < srcsize + 1) return BAD_DECODE;
+            bool overlap = dest < src + srcsize && src < dest + destsize;
+            if (overlap || srcsize < nontemporal::threshold())
+                return BASE::encode(dest, destsize, src, srcsize);
+
+            nontemporal::stage_writer<char_type> out(dest);
+            const size_t piece = nontemporal::piece_size, ahead = nontemporal::prefetch_distance();
+            size_t pos         = 0;
+            for (size_t i = 0; i < srcsize; i += piece) {
+                size_t n = std::min(piece, srcsize - i);
+                if (ahead && i + ahead < srcsize) nontemporal::prefetch(src + i + ahead, std::min(piece, srcsize - i - ahead));
+                // piece without its END
+                size_t staged = BASE::encode(out.tail(), 2 * piece + 1, src + i, n) - 1;
+                if (pos + staged >= destsize) return BAD_DECODE;
+                out.commit(staged);
+                pos += staged;
+            }
+            out.finish();
+            if (pos >= destsize) return BAD_DECODE;
+            dest[pos++] = ENCODER::end_code();
+            return pos;
+        }
+
+        /**
+         * @copydoc encode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static size_t encode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return encode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+    };
+
+    /**************************************************************************************
+     * Large-buffer decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Out-of-place decoder that keeps huge outputs out of the cache.
+     *
+     * Pieces are cut at the first END and never between an ESC and its escaped code.
+     * Otherwise works like nontemporal_encoder.
+     *
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <class DECODER>
+    struct nontemporal_decoder : public dispatched_decoder<DECODER> {
+        using BASE      = dispatched_decoder<DECODER>;
+        using char_type = typename DECODER::char_type;
+        using BASE::decoded_size;
+
+        /** @copydoc decoder_base::decode */
+        static size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            if (!dest || !src || srcsize < 1 || destsize < 1) return BAD_DECODE;
+            bool overlap = dest < src + srcsize && src < dest + destsize;
+            if (overlap || srcsize < nontemporal::threshold())
+                return BASE::decode(dest, destsize, src, srcsize);
+
+            nontemporal::stage_writer<char_type> out(dest);
+            const size_t piece = nontemporal::piece_size, ahead = nontemporal::prefetch_distance();
+            size_t pos = 0, i = 0;
+            bool last  = false;
+            while (i < srcsize && !last) {
+                size_t n = std::min(piece, srcsize - i);
+                if (ahead && i + ahead < srcsize) nontemporal::prefetch(src + i + ahead, std::min(piece, srcsize - i - ahead));
+                const void* end = memchr(src + i, static_cast<uint8_t>(DECODER::end_code()), n);
+                if (end) {
+                    n    = static_cast<const char_type*>(end) - (src + i);
+                    last = true;
+                } else if (src[i + n - 1] == DECODER::esc_code() && i + n < srcsize) {
+                    n++; // keep the escape pair together
+                }
+                if (n == 0) break;
+                size_t staged = BASE::decode(out.tail(), piece + 1, src + i, n);
+                if (staged == 0 || pos + staged > destsize) return BAD_DECODE;
+                out.commit(staged);
+                pos += staged;
+                i += n;
+            }
+            out.finish();
+            return pos;
+        }
+
+        /**
+         * @copydoc decode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static size_t decode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return decode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+    };
+
+}
+
+#endif // __SLIPNONTEMPORAL_H__
@@ -0,0 +1,140 @@
+/*!
+ *  @file SlipPacket.h
+ *
+ *  Packet buffer with headroom and tailroom for layering protocols around a
+ *  SLIP frame without moving it.
+ */
+
+#pragma once
+
+#ifndef __SLIPPACKET_H__
+    #define __SLIPPACKET_H__
+
+    #include "SlipInPlace.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * Packet buffer
+     **************************************************************************************/
+
+    /**
+     * @brief View of a caller-owned buffer as headroom, data and tailroom, like sk_buff.
+     *
+     * ```c++
+     * uint8_t buf[128];
+     * slip::packet_buffer<> pkt(buf, sizeof(buf), HDR);   // data starts after HDR
+     * memcpy(pkt.put(n), payload, n);                     // payload
+     * pkt.encode<slip::encoder>(HDR, CRC);                // keep room for both
+     * write_header(pkt.push(HDR));                        // header before the frame
+     * write_crc(pkt.put(CRC), pkt.data(), pkt.size() - CRC);
+     * ```
+     *
+     * @tparam _CharT   character type
+     */
+    template <typename _CharT = uint8_t>
+    class packet_buffer {
+     public:
+        /** Empty data region headroom characters into buf. */
+        packet_buffer(_CharT* buf, size_t bufsize, size_t headroom = 0) noexcept
+            : _buf(buf), _bufsize(bufsize), _offset(headroom < bufsize ? headroom : bufsize) {}
+
+        _CharT* data() const noexcept { return _buf + _offset; }
+        size_t size() const noexcept { return _size; }
+        size_t capacity() const noexcept { return _bufsize; }
+        size_t headroom() const noexcept { return _offset; }                   ///< free characters before data
+        size_t tailroom() const noexcept { return _bufsize - _offset - _size; } ///< free characters after data
+
+        /**
+         * @brief Extend data by n characters at the end.
+         * @return _CharT*  the new characters, or nullptr if the tailroom is too small
+         */
+        _CharT* put(size_t n) noexcept {
+            if (n > tailroom()) return nullptr;
+            _CharT* at = data() + _size;
+            _size += n;
+            return at;
+        }
+
+        /**
+         * @brief Extend data by n characters at the front.
+         * @return _CharT*  the new data start, or nullptr if the headroom is too small
+         */
+        _CharT* push(size_t n) noexcept {
+            if (n > _offset) return nullptr;
+            _offset -= n;
+            _size += n;
+            return data();
+        }
+
+        /**
+         * @brief Remove n characters from the front of data.
+         * @return _CharT*  the new data start, or nullptr if data is shorter than n
+         */
+        _CharT* pull(size_t n) noexcept {
+            if (n > _size) return nullptr;
+            _offset += n;
+            _size -= n;
+            return data();
+        }
+
+        /** Cut data down to n characters. */
+        void trim(size_t n) noexcept {
+            if (n < _size) _size = n;
+        }
+
+        /**
+         * @brief Make at least n characters of headroom, moving data towards the end if needed.
+         * @return bool  false if the tailroom is too small (data unchanged)
+         */
+        bool reserve_headroom(size_t n) noexcept {
+            if (n <= _offset) return true;
+            size_t shift = n - _offset;
+            if (shift > tailroom()) return false;
+            memmove(data() + shift, data(), _size * sizeof(_CharT));
+            _offset = n;
+            return true;
+        }
+
+        /**
+         * @brief SLIP-encode data in place, keeping at least headroom and tailroom free.
+         *
+         * See encoder_base::encode_with_room. On error data is unchanged.
+         *
+         * @tparam ENCODER  the encoder_base type to use
+         * @return size_t   encoded size, or 0 if it does not fit
+         */
+        template <class ENCODER>
+        size_t encode(size_t headroom = 0, size_t tailroom = 0) noexcept {
+            size_t at    = _offset;
+            size_t esize = ENCODER::encode_with_room(_buf, _bufsize, at, _size, headroom, tailroom);
+            if (esize) {
+                _offset = at;
+                _size   = esize;
+            }
+            return esize;
+        }
+
+        /**
+         * @brief SLIP-decode data in place. Data keeps its start and shrinks.
+         *
+         * @tparam DECODER  the decoder_base type to use
+         * @return size_t   decoded size, or 0 on error (data unchanged in size)
+         */
+        template <class DECODER>
+        size_t decode() noexcept {
+            size_t dsize = DECODER::decode(data(), _size, data(), _size);
+            if (dsize) _size = dsize;
+            return dsize;
+        }
+
+     protected:
+        _CharT* _buf;
+        size_t _bufsize;
+        size_t _offset;
+        size_t _size = 0;
+    };
+
+}
+
+#endif // __SLIPPACKET_H__
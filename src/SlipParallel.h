@@ -0,0 +1,158 @@
+/*!
+ *  @file SlipParallel.h
+ *
+ *  Multi-threaded decoding of a single very large SLIP frame.
+ *
+ *  Host-only (requires <thread>). Not included by SlipInPlace.h.
+ */
+
+#pragma once
+
+#ifndef __SLIPPARALLEL_H__
+    #define __SLIPPARALLEL_H__
+
+    #include "SlipInPlace.h"
+    #include <algorithm>
+    #include <thread>
+    #include <vector>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Parallel decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Parallel variant of decoder_base::decode for a single huge frame.
+     *
+     * The frame is processed in three parallel passes:
+     *  1. every thread searches its slice for the first END code; the frame is
+     *     truncated there exactly as the scalar decoder would stop.
+     *  2. split points are chosen and any split that falls directly after an ESC
+     *     code is pushed forward one byte so an escape pair never straddles two chunks.
+     *     Each chunk's decoded length is then counted in parallel.
+     *  3. an exclusive scan of the lengths gives every chunk's output offset, and the
+     *     chunks are decoded concurrently with DECODER::decode.
+     *
+     * A stream without two consecutive ESC codes has only one possible parse,
+     * so every chunk decodes exactly as in the scalar pass. A stream with two consecutive
+     * ESC codes is always a decoding error for the scalar decoder and is also caught
+     * by the chunk holding the first such pair. Results and errors therefore match
+     * decoder_base::decode.
+     *
+     * In-place decoding (src inside dest) first decodes every chunk in place at its own
+     * start, then compacts the chunks left to right.
+     *
+     * @tparam DECODER  one of the decoder_base types, for example slip::decoder
+     */
+    template <class DECODER>
+    struct parallel_decoder {
+        using char_type = typename DECODER::char_type;
+
+        /** Chunks smaller than this are not worth a thread of their own. */
+        static constexpr size_t default_min_chunk = 1 << 16;
+
+        /**
+         * @brief Decode a single SLIP frame using several threads.
+         *
+         * @param dest      destination buffer
+         * @param destsize  dest buffer size - must be sufficiently large
+         * @param src       source buffer
+         * @param srcsize   size of source to decode
+         * @param nthreads  number of threads to use. 0 uses std::thread::hardware_concurrency()
+         * @param min_chunk minimum number of source bytes handed to each thread
+         * @return size_t   final decoded size or 0 if there was an error while decoding
+         */
+        static size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize,
+                             unsigned nthreads = 0, size_t min_chunk = default_min_chunk) {
+            static constexpr size_t BAD_DECODE = 0;
+            if (!dest || !src || srcsize < 1 || destsize < 1) return BAD_DECODE;
+            if (nthreads == 0) nthreads = std::thread::hardware_concurrency();
+            if (min_chunk < 2) min_chunk = 2;
+            size_t nchunks = std::min<size_t>(nthreads, srcsize / min_chunk);
+
+            const char_type* dend = dest + destsize;
+            const char_type* send = src + srcsize;
+            bool overlap          = (dest < send && src < dend);
+            bool inplace          = overlap && dest <= src && send <= dend;
+            // An END that doubles as an escaped code would make the first END ambiguous.
+            bool end_is_escape = false;
+            for (int i = 0; i < DECODER::num_specials; i++)
+                end_is_escape |= (DECODER::escaped_codes()[i] == DECODER::end_code());
+            if (nchunks < 2 || (overlap && !inplace) || end_is_escape)
+                return DECODER::decode(dest, destsize, src, srcsize);
+
+            // pass 1: truncate at the first END
+            std::vector<size_t> found(nchunks, srcsize);
+            run(nchunks, [&](size_t k) {
+                size_t lo = k * srcsize / nchunks, hi = (k + 1) * srcsize / nchunks;
+                const void* p = memchr(src + lo, (uint8_t)DECODER::end_code(), hi - lo);
+                if (p) found[k] = static_cast<const char_type*>(p) - src;
+            });
+            size_t framesize = *std::min_element(found.begin(), found.end());
+            if (framesize == 0) return 0;
+            nchunks = std::max<size_t>(1, std::min<size_t>(nchunks, framesize / min_chunk));
+
+            // pass 2: split points, ESC-boundary repair and decoded chunk lengths
+            std::vector<size_t> bounds(nchunks + 1);
+            bounds[0]       = 0;
+            bounds[nchunks] = framesize;
+            for (size_t k = 1; k < nchunks; k++) {
+                size_t b = std::max(k * framesize / nchunks, bounds[k - 1]);
+                if (b > 0 && b < framesize && src[b - 1] == DECODER::esc_code()) b++;
+                bounds[k] = std::min(b, framesize);
+            }
+            std::vector<size_t> offsets(nchunks + 1, 0);
+            run(nchunks, [&](size_t k) {
+                offsets[k + 1] = DECODER::decoded_size(src + bounds[k], bounds[k + 1] - bounds[k]);
+            });
+            for (size_t k = 0; k < nchunks; k++) offsets[k + 1] += offsets[k];
+            if (offsets[nchunks] > destsize) return BAD_DECODE;
+
+            // pass 3: concurrent decode. In-place decodes each chunk onto itself first.
+            char_type* stage = inplace ? const_cast<char_type*>(src) : dest;
+            std::vector<char> failed(nchunks, 0);
+            run(nchunks, [&](size_t k) {
+                size_t ssize = bounds[k + 1] - bounds[k];
+                size_t dsize = offsets[k + 1] - offsets[k];
+                if (ssize == 0) return;
+                char_type* out = inplace ? stage + bounds[k] : stage + offsets[k];
+                if (dsize == 0 || DECODER::decode(out, dsize, src + bounds[k], ssize) != dsize)
+                    failed[k] = 1;
+            });
+            if (std::find(failed.begin(), failed.end(), 1) != failed.end()) return BAD_DECODE;
+            if (inplace) {
+                for (size_t k = 0; k < nchunks; k++)
+                    memmove(dest + offsets[k], stage + bounds[k], offsets[k + 1] - offsets[k]);
+            }
+            return offsets[nchunks];
+        }
+
+        /**
+         * @copydoc decode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static size_t decode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize,
+                             unsigned nthreads = 0, size_t min_chunk = default_min_chunk) {
+            return decode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize,
+                          nthreads, min_chunk);
+        }
+
+     protected:
+        /** Run fn(0)..fn(n-1), each on its own thread, the last on the calling thread. */
+        template <typename _Fn>
+        static void run(size_t n, _Fn fn) {
+            std::vector<std::thread> workers;
+            workers.reserve(n - 1);
+            for (size_t k = 0; k + 1 < n; k++)
+                workers.emplace_back(fn, k);
+            fn(n - 1);
+            for (auto& w : workers) w.join();
+        }
+    };
+
+}
+
+#endif // __SLIPPARALLEL_H__
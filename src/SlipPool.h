@@ -0,0 +1,268 @@
+/*!
+ *  @file SlipPool.h
+ *
+ *  Pre-allocated storage for decoded frames: a bump arena released in bulk and
+ *  a fixed-size block pool with reference-counted handles.
+ *
+ *  Neither touches the heap after construction. On C++17 hosts, arena_resource
+ *  lets std::pmr containers allocate from a frame_arena.
+ */
+
+#pragma once
+
+#ifndef __SLIPPOOL_H__
+    #define __SLIPPOOL_H__
+
+    #include "SlipInPlace.h"
+    #include <memory>  // for unique_ptr
+    #include <utility> // for swap
+
+    #if defined(__has_include) && __cplusplus >= 201703L
+    #  if __has_include(<memory_resource>)
+    #    include <memory_resource>
+    #    define SLIP_HAS_PMR 1
+    #  endif
+    #endif
+    #ifndef SLIP_HAS_PMR
+        #define SLIP_HAS_PMR 0
+    #endif
+
+namespace slip {
+
+    /** A decoded frame in caller-managed storage. Empty (nullptr) on error. */
+    template <typename _CharT>
+    struct frame_span {
+        _CharT* data = nullptr; ///< decoded frame
+        size_t size  = 0;       ///< decoded size
+        explicit operator bool() const noexcept { return data != nullptr; }
+    };
+
+    /**************************************************************************************
+     * Frame arena
+     **************************************************************************************/
+
+    /**
+     * @brief Bump allocator that decoded frames are released from all at once.
+     *
+     * Suited to batch decoding: decode every frame of a batch, process them, then
+     * reset(). Not thread-safe.
+     *
+     * @tparam _CharT   character type of the frames
+     */
+    template <typename _CharT = uint8_t>
+    class frame_arena {
+     public:
+        /** Use caller-provided storage, for example a static array on an MCU. */
+        frame_arena(_CharT* storage, size_t size) noexcept : _begin(storage), _end(storage + size), _next(storage) {}
+
+        /** Own size characters of storage, allocated once here. */
+        explicit frame_arena(size_t size) : _owned(new _CharT[size]) {
+            _begin = _next = _owned.get();
+            _end           = _begin + size;
+        }
+
+        frame_arena(const frame_arena&) = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+
+        /**
+         * @brief Carve n characters aligned to align bytes.
+         * @return _CharT*  nullptr if the arena is full
+         */
+        _CharT* allocate(size_t n, size_t align = alignof(_CharT)) noexcept {
+            uintptr_t at = (reinterpret_cast<uintptr_t>(_next) + (align - 1)) & ~uintptr_t(align - 1);
+            _CharT* p    = reinterpret_cast<_CharT*>(at);
+            if (p < _next || p > _end || size_t(_end - p) < n) return nullptr;
+            _next = p + n;
+            return p;
+        }
+
+        /**
+         * @brief Decode a frame into the arena.
+         *
+         * Takes exactly decoded_size() characters, minus what a short decode
+         * leaves unused. On error nothing is kept.
+         *
+         * @tparam DECODER  the decoder_base type to use
+         */
+        template <class DECODER>
+        frame_span<_CharT> decode(const _CharT* src, size_t srcsize) noexcept {
+            frame_span<_CharT> f;
+            size_t size = DECODER::decoded_size(src, srcsize);
+            _CharT* at  = size ? allocate(size) : nullptr;
+            if (!at) return f;
+            size_t n = DECODER::decode(at, size, src, srcsize);
+            if (n == 0) {
+                _next = at;
+                return f;
+            }
+            _next  = at + n;
+            f.data = at;
+            f.size = n;
+            _frames++;
+            return f;
+        }
+
+        /** Release every frame at once. */
+        void reset() noexcept {
+            _next   = _begin;
+            _frames = 0;
+        }
+
+        /** Is p inside this arena's storage? */
+        bool owns(const void* p) const noexcept { return p >= _begin && p < _end; }
+
+        size_t capacity() const noexcept { return _end - _begin; } ///< characters of storage
+        size_t used() const noexcept { return _next - _begin; }    ///< characters in use
+        size_t frames() const noexcept { return _frames; }         ///< frames decoded since reset()
+
+     protected:
+        std::unique_ptr<_CharT[]> _owned;
+        _CharT *_begin, *_end, *_next;
+        size_t _frames = 0;
+    };
+
+    #if SLIP_HAS_PMR
+    /**
+     * @brief std::pmr::memory_resource on top of a frame_arena.
+     *
+     * Individual deallocations are ignored; memory comes back with the arena's
+     * reset(). When the arena is full, allocation falls back to the upstream
+     * resource, which defaults to std::pmr::null_memory_resource() (throws).
+     */
+    class arena_resource : public std::pmr::memory_resource {
+     public:
+        explicit arena_resource(frame_arena<uint8_t>& arena,
+                                std::pmr::memory_resource* upstream = std::pmr::null_memory_resource()) noexcept
+            : _arena(arena), _upstream(upstream) {}
+
+     protected:
+        void* do_allocate(size_t bytes, size_t align) override {
+            void* p = _arena.allocate(bytes, align);
+            return p ? p : _upstream->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t align) override {
+            // arena memory comes back with reset(), only upstream memory is given back here
+            if (!_arena.owns(p)) _upstream->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        frame_arena<uint8_t>& _arena;
+        std::pmr::memory_resource* _upstream;
+    };
+    #endif
+
+    /**************************************************************************************
+     * Frame pool
+     **************************************************************************************/
+
+    /**
+     * @brief Fixed pool of Count blocks of BlockSize characters with reference-counted handles.
+     *
+     * Suited to frames with independent lifetimes. A block returns to the pool
+     * when its last handle goes away. The storage is part of the pool object, so
+     * a static or long-lived pool never allocates. Not thread-safe: keep handles
+     * on the pool's thread.
+     *
+     * @tparam BlockSize    characters per block, the largest decoded frame
+     * @tparam Count        number of blocks
+     * @tparam _CharT       character type of the frames
+     */
+    template <size_t BlockSize, size_t Count, typename _CharT = uint8_t>
+    class frame_pool {
+        static_assert(Count > 0 && Count < 0xFFFF, "pool block count out of range");
+
+     public:
+        /** Shared reference to a pooled frame. Empty when the pool was exhausted or decoding failed. */
+        class handle {
+         public:
+            handle() noexcept = default;
+            handle(const handle& h) noexcept : _pool(h._pool), _block(h._block), _size(h._size) { retain(); }
+            handle(handle&& h) noexcept : _pool(h._pool), _block(h._block), _size(h._size) { h._pool = nullptr; }
+            ~handle() { reset(); }
+            handle& operator=(handle h) noexcept {
+                std::swap(_pool, h._pool);
+                std::swap(_block, h._block);
+                std::swap(_size, h._size);
+                return *this;
+            }
+
+            _CharT* data() const noexcept { return _pool ? _pool->_blocks[_block] : nullptr; }
+            size_t size() const noexcept { return _pool ? _size : 0; }
+            /** Set the used size, up to BlockSize. */
+            void resize(size_t n) noexcept { _size = n < BlockSize ? n : BlockSize; }
+            explicit operator bool() const noexcept { return _pool != nullptr; }
+            /** Handles sharing this block, including this one. */
+            size_t use_count() const noexcept { return _pool ? _pool->_refs[_block] : 0; }
+
+            /** Drop this reference. */
+            void reset() noexcept {
+                if (_pool) _pool->unref(_block);
+                _pool = nullptr;
+            }
+
+         protected:
+            friend class frame_pool;
+            handle(frame_pool* pool, uint16_t block) noexcept : _pool(pool), _block(block) {}
+            void retain() noexcept {
+                if (_pool) _pool->_refs[_block]++;
+            }
+
+            frame_pool* _pool = nullptr;
+            uint16_t _block   = 0;
+            size_t _size      = 0;
+        };
+
+        static constexpr size_t block_size  = BlockSize;
+        static constexpr size_t block_count = Count;
+
+        frame_pool() noexcept {
+            for (size_t i = 0; i < Count; i++) {
+                _refs[i] = 0;
+                _free[i] = static_cast<uint16_t>(Count - 1 - i);
+            }
+            _nfree = Count;
+        }
+        frame_pool(const frame_pool&) = delete;
+        frame_pool& operator=(const frame_pool&) = delete;
+
+        /** Take an empty block, sized BlockSize. */
+        handle acquire() noexcept {
+            if (_nfree == 0) return handle();
+            uint16_t b = _free[--_nfree];
+            _refs[b]   = 1;
+            handle h(this, b);
+            h._size = BlockSize;
+            return h;
+        }
+
+        /**
+         * @brief Decode a frame into a block.
+         * @tparam DECODER  the decoder_base type to use
+         * @return handle   empty if no block is free, the frame is larger than BlockSize, or it is invalid
+         */
+        template <class DECODER>
+        handle decode(const _CharT* src, size_t srcsize) noexcept {
+            handle h = acquire();
+            if (!h) return h;
+            size_t n = DECODER::decode(h.data(), BlockSize, src, srcsize);
+            if (n == 0) return handle();
+            h._size = n;
+            return h;
+        }
+
+        size_t available() const noexcept { return _nfree; } ///< free blocks
+
+     protected:
+        void unref(uint16_t b) noexcept {
+            if (--_refs[b] == 0) _free[_nfree++] = b;
+        }
+
+        _CharT _blocks[Count][BlockSize];
+        size_t _refs[Count];
+        uint16_t _free[Count];
+        size_t _nfree;
+    };
+
+}
+
+#endif // __SLIPPOOL_H__
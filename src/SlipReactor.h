@@ -0,0 +1,355 @@
+/*!
+ *  @file SlipReactor.h
+ *
+ *  Event loop for many SLIP links on one thread: non-blocking reads from ttys,
+ *  ptys, pipes or sockets, a stream decoder per channel, frames dispatched to
+ *  handlers, and queued frames written out with writev().
+ *
+ *  Host only: needs POSIX. Uses epoll on Linux and poll() elsewhere.
+ */
+
+#pragma once
+
+#ifndef __SLIPREACTOR_H__
+    #define __SLIPREACTOR_H__
+
+    #include "SlipStream.h"
+    #include <deque>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <functional>
+    #include <memory>
+    #include <poll.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+    #include <vector>
+
+    #ifdef __linux__
+        #include <sys/epoll.h>
+    #endif
+
+namespace slip {
+
+    /** How the reactor waits for its file descriptors. */
+    enum class reactor_backend : uint8_t {
+        epoll, ///< Linux only, O(ready channels) per wait
+        poll   ///< portable, O(channels) per wait
+    };
+
+    /**************************************************************************************
+     * Reactor
+     **************************************************************************************/
+
+    /**
+     * @brief Reads, decodes and writes many SLIP channels from one thread.
+     *
+     * Each channel owns a stream_buffer. A readable channel is read until it
+     * would block, a few reads at most, and every complete frame goes to the
+     * channel's handler by pointer, valid during the call. Handlers may send()
+     * on any channel. Frames sent are encoded into a per-channel queue, and
+     * each run_once() ends by writing every queue with one writev() per channel.
+     * A channel whose fd would block is watched for writing until its queue
+     * drains.
+     *
+     * File descriptors are made non-blocking and are not closed by the
+     * reactor. A channel closes at end of file or on a read or write error,
+     * after its last frame without an END is dispatched. Ignore SIGPIPE when
+     * writing to pipes or sockets whose reader may go away.
+     *
+     * @tparam ENCODER  the encoder_base type for send()
+     * @tparam DECODER  the decoder_base type for received frames
+     */
+    template <class ENCODER = encoder, class DECODER = decoder>
+    class reactor {
+     public:
+        using char_type = typename DECODER::char_type;
+        using handler   = std::function<void(size_t channel, const char_type* frame, size_t size)>;
+
+        /** epoll where available */
+        static reactor_backend default_backend() noexcept {
+    #ifdef __linux__
+            return reactor_backend::epoll;
+    #else
+            return reactor_backend::poll;
+    #endif
+        }
+
+        /**
+         * @param buffer_size   receive buffer characters per channel, at least the largest decoded frame
+         * @param backend       how to wait. Falls back to poll where epoll is not available.
+         */
+        explicit reactor(size_t buffer_size = 4096, reactor_backend backend = default_backend())
+            : _buffer_size(buffer_size), _backend(backend) {
+    #ifdef __linux__
+            if (_backend == reactor_backend::epoll) _epfd = epoll_create1(EPOLL_CLOEXEC);
+            if (_epfd < 0) _backend = reactor_backend::poll;
+    #else
+            _backend = reactor_backend::poll;
+    #endif
+        }
+        ~reactor() {
+            if (_epfd >= 0) close(_epfd);
+        }
+
+        reactor(const reactor&)            = delete;
+        reactor& operator=(const reactor&) = delete;
+
+        reactor_backend backend() const noexcept { return _backend; }
+
+        /**
+         * @brief Watch fd, which is made non-blocking.
+         * @return channel number, or -1 on errors
+         */
+        int add(int fd, handler on_frame) {
+            int flags = fcntl(fd, F_GETFL);
+            if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) return -1;
+            size_t ch = _channels.size();
+            _channels.emplace_back(new channel(fd, _buffer_size, std::move(on_frame)));
+            if (!watch(ch, EPOLL_CTL_ADD)) {
+                _channels.pop_back();
+                return -1;
+            }
+            _open++;
+            return static_cast<int>(ch);
+        }
+
+        /** Stop watching channel ch. Queued frames are discarded and the fd is left open. */
+        void remove(size_t ch) { close_channel(*_channels[ch], 0); }
+
+        bool is_open(size_t ch) const noexcept { return _channels[ch]->open; } ///< not closed or removed
+        size_t open_channels() const noexcept { return _open; }                ///< channels open
+        int error(size_t ch) const noexcept { return _channels[ch]->error; }   ///< errno that closed ch, or 0
+
+        uint64_t frames(size_t ch) const noexcept { return _channels[ch]->stream.frames(); }       ///< frames received
+        uint64_t errors(size_t ch) const noexcept { return _channels[ch]->stream.errors(); }       ///< bad escapes
+        uint64_t oversized(size_t ch) const noexcept { return _channels[ch]->stream.oversized(); } ///< frames too large
+        size_t pending(size_t ch) const noexcept { return _channels[ch]->pending; }                ///< characters queued
+
+        /** Largest queue per channel, in encoded characters. send() refuses frames beyond it. */
+        void set_max_pending(size_t n) noexcept { _max_pending = n; }
+
+        /**
+         * @brief Encode a frame and queue it on channel ch.
+         *
+         * The queue is written at the end of run_once(), or by flush().
+         *
+         * @return false if ch is closed or its queue is full
+         */
+        bool send(size_t ch, const char_type* payload, size_t size) {
+            channel& c = *_channels[ch];
+            if (!c.open || c.pending + size + 1 > _max_pending) return false;
+            std::vector<char_type> f;
+            if (!c.spare.empty()) {
+                f = std::move(c.spare.back());
+                c.spare.pop_back();
+            }
+            f.resize(2 * size + 1);
+            size_t n = ENCODER::encode(f.data(), f.size(), payload, size);
+            if (!n || c.pending + n > _max_pending) {
+                c.spare.push_back(std::move(f));
+                return false;
+            }
+            f.resize(n);
+            c.pending += n;
+            c.out.push_back(std::move(f));
+            return true;
+        }
+
+        /**
+         * @copydoc send
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        bool send(size_t ch, const _FromT* payload, size_t size) {
+            return send(ch, reinterpret_cast<const char_type*>(payload), size);
+        }
+
+        /** Write every queued frame that the fds take now. */
+        void flush() {
+            for (size_t ch = 0; ch < _channels.size(); ch++) {
+                if (_channels[ch]->pending) write_queue(ch);
+            }
+        }
+
+        /**
+         * @brief Wait for channels to be ready, read and dispatch frames, then flush.
+         * @param timeout_ms    -1 waits until a channel is ready, 0 does not wait
+         * @return size_t       channels that were ready, 0 on a timeout or when none is open
+         */
+        size_t run_once(int timeout_ms = -1) {
+            flush(); // frames sent outside of handlers
+            size_t ready = 0;
+            if (_open) ready = (_backend == reactor_backend::epoll) ? wait_epoll(timeout_ms) : wait_poll(timeout_ms);
+            flush();
+            return ready;
+        }
+
+        /** Run until stop() is called from a handler, or no channel is open. */
+        void run() {
+            _stop = false;
+            while (!_stop && _open) run_once();
+        }
+
+        void stop() noexcept { _stop = true; } ///< make run() return after this iteration
+
+     private:
+        // the epoll operations also stand for what the poll backend watches
+    #ifndef __linux__
+        enum { EPOLL_CTL_ADD = 1, EPOLL_CTL_DEL = 2, EPOLL_CTL_MOD = 3 };
+    #endif
+        static constexpr int max_reads    = 4;  // reads per ready channel, for fairness
+        static constexpr int max_iov      = 64; // frames per writev
+        static constexpr size_t max_spare = 16; // frame vectors kept for reuse
+
+        struct channel {
+            channel(int fd, size_t size, handler h) : fd(fd), buf(size), stream(buf.data(), size), on_frame(std::move(h)) {}
+            int fd;
+            std::vector<char_type> buf;
+            stream_buffer<DECODER> stream;
+            handler on_frame;
+            std::deque<std::vector<char_type>> out;
+            std::vector<std::vector<char_type>> spare;
+            size_t sent     = 0; // characters of out.front() already written
+            size_t pending  = 0; // characters queued
+            bool open       = true;
+            bool want_write = false;
+            int error       = 0;
+        };
+
+        bool watch(size_t ch, int op) {
+    #ifdef __linux__
+            if (_backend != reactor_backend::epoll) return true;
+            channel& c = *_channels[ch];
+            struct epoll_event ev;
+            ev.events   = EPOLLIN | (c.want_write ? static_cast<uint32_t>(EPOLLOUT) : 0);
+            ev.data.u64 = ch;
+            return epoll_ctl(_epfd, op, c.fd, &ev) == 0;
+    #else
+            (void)ch;
+            (void)op;
+            return true;
+    #endif
+        }
+
+        size_t wait_epoll(int timeout_ms) {
+    #ifdef __linux__
+            struct epoll_event ev[64];
+            int n = epoll_wait(_epfd, ev, 64, timeout_ms);
+            for (int i = 0; i < n; i++) {
+                size_t ch = static_cast<size_t>(ev[i].data.u64);
+                if (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) read_channel(ch);
+                if ((ev[i].events & EPOLLOUT) && _channels[ch]->open) write_queue(ch);
+            }
+            return n > 0 ? n : 0;
+    #else
+            (void)timeout_ms;
+            return 0;
+    #endif
+        }
+
+        size_t wait_poll(int timeout_ms) {
+            _pollfds.clear();
+            _pollch.clear();
+            for (size_t ch = 0; ch < _channels.size(); ch++) {
+                const channel& c = *_channels[ch];
+                if (!c.open) continue;
+                struct pollfd p = {c.fd, static_cast<short>(POLLIN | (c.want_write ? POLLOUT : 0)), 0};
+                _pollfds.push_back(p);
+                _pollch.push_back(ch);
+            }
+            int n = poll(_pollfds.data(), _pollfds.size(), timeout_ms);
+            for (size_t i = 0; n > 0 && i < _pollfds.size(); i++) {
+                short re = _pollfds[i].revents;
+                if (re & (POLLIN | POLLHUP | POLLERR)) read_channel(_pollch[i]);
+                if ((re & POLLOUT) && _channels[_pollch[i]]->open) write_queue(_pollch[i]);
+            }
+            return n > 0 ? n : 0;
+        }
+
+        void read_channel(size_t ch) {
+            channel& c   = *_channels[ch];
+            auto deliver = [&c, ch](const char_type* frame, size_t size) {
+                if (c.open) c.on_frame(ch, frame, size); // unless a handler removed ch
+            };
+            for (int i = 0; i < max_reads && c.open; i++) {
+                c.stream.prepare();
+                size_t want = c.stream.room() * sizeof(char_type); // received() shrinks room()
+                ssize_t k   = read(c.fd, c.stream.space(), want);
+                if (k > 0) {
+                    c.stream.received(k / sizeof(char_type), deliver);
+                    if (static_cast<size_t>(k) < want) break; // drained, probably
+                } else if (k < 0 && errno == EINTR) {
+                    continue;
+                } else if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                } else {
+                    c.stream.finish(deliver); // end of file or error
+                    close_channel(c, k < 0 ? errno : 0);
+                }
+            }
+        }
+
+        void write_queue(size_t ch) {
+            channel& c = *_channels[ch];
+            while (c.open && c.pending) {
+                struct iovec iov[max_iov];
+                int n = 0;
+                for (auto it = c.out.begin(); it != c.out.end() && n < max_iov; ++it, ++n) {
+                    size_t skip     = n ? 0 : c.sent;
+                    iov[n].iov_base = const_cast<char_type*>(it->data() + skip);
+                    iov[n].iov_len  = (it->size() - skip) * sizeof(char_type);
+                }
+                ssize_t k = writev(c.fd, iov, n);
+                if (k < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    close_channel(c, errno);
+                    return;
+                }
+                size_t done = k / sizeof(char_type);
+                c.pending -= done;
+                while (done) {
+                    size_t left = c.out.front().size() - c.sent;
+                    if (done < left) {
+                        c.sent += done;
+                        break;
+                    }
+                    done -= left;
+                    c.sent = 0;
+                    if (c.spare.size() < max_spare) c.spare.push_back(std::move(c.out.front()));
+                    c.out.pop_front();
+                }
+            }
+            if (c.open && c.want_write != (c.pending != 0)) {
+                c.want_write = c.pending != 0;
+                watch(ch, EPOLL_CTL_MOD);
+            }
+        }
+
+        void close_channel(channel& c, int error) {
+            if (!c.open) return;
+            c.open  = false;
+            c.error = error;
+    #ifdef __linux__
+            if (_backend == reactor_backend::epoll) epoll_ctl(_epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+    #endif
+            c.out.clear();
+            c.pending = 0;
+            _open--;
+        }
+
+        size_t _buffer_size;
+        reactor_backend _backend;
+        int _epfd           = -1;
+        size_t _open        = 0;
+        size_t _max_pending = 1 << 20;
+        bool _stop          = false;
+        std::vector<std::unique_ptr<channel>> _channels; // stable addresses for the stream buffers
+        std::vector<struct pollfd> _pollfds;
+        std::vector<size_t> _pollch;
+    };
+
+}
+
+#endif // __SLIPREACTOR_H__
@@ -0,0 +1,287 @@
+/*!
+ *  @file SlipRecord.h
+ *
+ *  Typed encode and decode of fixed-layout binary records, with byte order
+ *  conversion done while escaping or unescaping.
+ */
+
+#pragma once
+
+#ifndef __SLIPRECORD_H__
+    #define __SLIPRECORD_H__
+
+    #include "SlipInPlace.h"
+
+    #if defined(__has_include)
+    #  if __has_include(<type_traits>)
+    #    define SLIP_HAS_TYPE_TRAITS 1
+    #  endif
+    #endif
+    #ifndef SLIP_HAS_TYPE_TRAITS
+        #define SLIP_HAS_TYPE_TRAITS 0
+    #endif
+
+namespace slip {
+
+    /**************************************************************************************
+     * Record layouts
+     **************************************************************************************/
+
+    /* Byte order of multi-character fields on the wire. */
+    enum class byte_order : uint8_t { little, big };
+
+    #if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static constexpr byte_order host_order = byte_order::big;
+    #else
+    static constexpr byte_order host_order = byte_order::little;
+    #endif
+
+    /**
+     * @brief One field of a record: Size characters at Offset in the struct.
+     *
+     * Use offsetof() and sizeof() of the member, for example
+     * `slip::field<offsetof(sample, t), sizeof(sample::t)>`.
+     */
+    template <size_t Offset, size_t Size>
+    struct field {
+        static constexpr size_t offset = Offset;
+        static constexpr size_t size   = Size;
+    };
+
+    /**
+     * @brief Wire layout of a record: its fields in wire order, and their byte order.
+     *
+     * Fields are sent back to back, so struct padding stays off the wire.
+     * Fields wider than one character are byte-swapped when Order is not the
+     * host byte order.
+     *
+     * @tparam Order    byte order of the fields on the wire
+     * @tparam Fields   field<> types, in wire order
+     */
+    template <byte_order Order, class... Fields>
+    struct layout;
+
+    template <byte_order Order>
+    struct layout<Order> {
+        static constexpr size_t wire_size = 0;
+        static constexpr size_t extent    = 0;
+        static constexpr bool identity_from(size_t) noexcept { return true; }
+        template <class READER>
+        static bool read(uint8_t*, READER&) noexcept {
+            return true;
+        }
+        template <class WRITER>
+        static void write(const uint8_t*, WRITER&) noexcept {}
+    };
+
+    template <byte_order Order, class F, class... Rest>
+    struct layout<Order, F, Rest...> {
+        using rest = layout<Order, Rest...>;
+
+        static constexpr bool swap        = Order != host_order && F::size > 1;
+        static constexpr size_t wire_size = F::size + rest::wire_size; ///< characters on the wire, unescaped
+        static constexpr size_t extent    = (F::offset + F::size > rest::extent) ? F::offset + F::size : rest::extent;
+
+        /** Are the fields from here a plain copy of the struct from character at onwards? */
+        static constexpr bool identity_from(size_t at) noexcept {
+            return !swap && F::offset == at && rest::identity_from(at + F::size);
+        }
+
+        /** Fill the fields of obj from decoded characters. @return false if r runs out */
+        template <class READER>
+        static bool read(uint8_t* obj, READER& r) noexcept {
+            for (size_t j = 0; j < F::size; j++) {
+                uint8_t c;
+                if (!r.next(c)) return false;
+                obj[F::offset + (swap ? F::size - 1 - j : j)] = c;
+            }
+            return rest::read(obj, r);
+        }
+
+        /** Send the fields of obj to w in wire order. */
+        template <class WRITER>
+        static void write(const uint8_t* obj, WRITER& w) noexcept {
+            for (size_t j = 0; j < F::size; j++) w.put(obj[F::offset + (swap ? F::size - 1 - j : j)]);
+            rest::write(obj, w);
+        }
+    };
+
+    /** The whole of T as one field: sent exactly as it is in memory. */
+    template <typename T>
+    using raw_layout = layout<host_order, field<0, sizeof(T)>>;
+
+    /**************************************************************************************
+     * Record encoder and decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Encodes a T straight from the struct, converting byte order on the way.
+     *
+     * ```c++
+     * struct sample { uint32_t t; int16_t x, y; };
+     * using wire = slip::layout<slip::byte_order::big, slip::field<offsetof(sample, t), 4>,
+     *                           slip::field<offsetof(sample, x), 2>, slip::field<offsetof(sample, y), 2>>;
+     * uint8_t buf[slip::record_encoder<sample, wire>::max_encoded_size];
+     * size_t n = slip::record_encoder<sample, wire>::encode(buf, sizeof(buf), s);
+     * ```
+     *
+     * @tparam T        a trivially copyable type
+     * @tparam LAYOUT   layout<> of T on the wire
+     * @tparam ENCODER  the encoder_base type to use
+     */
+    template <typename T, class LAYOUT = raw_layout<T>, class ENCODER = encoder>
+    struct record_encoder {
+    #if SLIP_HAS_TYPE_TRAITS
+        static_assert(std::is_trivially_copyable<T>::value, "records must be trivially copyable");
+    #endif
+        static_assert(LAYOUT::extent <= sizeof(T), "layout does not fit the record");
+
+        using char_type = typename ENCODER::char_type;
+
+        static constexpr size_t wire_size        = LAYOUT::wire_size;
+        static constexpr size_t max_encoded_size = 2 * wire_size + 1; ///< every character escaped
+
+        /** @brief Exact encoded size of src. */
+        static inline size_t encoded_size(const T& src) noexcept {
+            counter w;
+            LAYOUT::write(reinterpret_cast<const uint8_t*>(&src), w);
+            return w.size + 1;
+        }
+
+        /**
+         * @brief Encode src.
+         * @return size_t   encoded size, or 0 if dest is too small
+         */
+        static inline size_t encode(char_type* dest, size_t destsize, const T& src) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            if (!dest) return BAD_DECODE;
+            if (identity) return ENCODER::encode(dest, destsize, reinterpret_cast<const char_type*>(&src), sizeof(T));
+            writer w{dest, dest + destsize, false};
+            LAYOUT::write(reinterpret_cast<const uint8_t*>(&src), w);
+            if (w.full || w.at == w.end) return BAD_DECODE;
+            *(w.at++) = ENCODER::end_code();
+            return w.at - dest;
+        }
+
+        /**
+         * @copydoc encode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encode(_FromT* dest, size_t destsize, const T& src) noexcept {
+            return encode(reinterpret_cast<char_type*>(dest), destsize, src);
+        }
+
+     protected:
+        static constexpr bool identity = LAYOUT::identity_from(0) && LAYOUT::wire_size == sizeof(T);
+
+        static int special_index(uint8_t c) noexcept {
+            for (int i = 0; i < ENCODER::num_specials; i++) {
+                if (static_cast<char_type>(c) == ENCODER::special_codes()[i]) return i;
+            }
+            return -1;
+        }
+
+        struct writer {
+            char_type* at;
+            char_type* end;
+            bool full;
+            void put(uint8_t c) noexcept {
+                int isp = special_index(c);
+                if (end - at < (isp < 0 ? 1 : 2)) {
+                    full = true;
+                } else if (isp < 0) {
+                    *(at++) = static_cast<char_type>(c);
+                } else {
+                    *(at++) = ENCODER::esc_code();
+                    *(at++) = ENCODER::escaped_codes()[isp];
+                }
+            }
+        };
+
+        struct counter {
+            size_t size = 0;
+            void put(uint8_t c) noexcept { size += special_index(c) < 0 ? 1 : 2; }
+        };
+    };
+
+    /**
+     * @brief Decodes a frame straight into a T, converting byte order on the way.
+     *
+     * The frame must decode to exactly LAYOUT::wire_size characters. Characters
+     * of T not covered by the layout (padding) are left as they were.
+     *
+     * @tparam T        a trivially copyable type
+     * @tparam LAYOUT   layout<> of T on the wire
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <typename T, class LAYOUT = raw_layout<T>, class DECODER = decoder>
+    struct record_decoder {
+    #if SLIP_HAS_TYPE_TRAITS
+        static_assert(std::is_trivially_copyable<T>::value, "records must be trivially copyable");
+    #endif
+        static_assert(LAYOUT::extent <= sizeof(T), "layout does not fit the record");
+
+        using char_type = typename DECODER::char_type;
+
+        static constexpr size_t wire_size = LAYOUT::wire_size;
+
+        /**
+         * @brief Decode the frame in src into dest.
+         *
+         * dest is undefined if this fails.
+         *
+         * @return true     if the frame holds exactly one record
+         */
+        static inline bool decode(T& dest, const char_type* src, size_t srcsize) noexcept {
+            if (!src) return false;
+            if (identity) { // a longer frame overflows dest and fails
+                return DECODER::decode(reinterpret_cast<char_type*>(&dest), sizeof(T), src, srcsize) == sizeof(T);
+            }
+            reader r{src, src + srcsize, false};
+            if (!LAYOUT::read(reinterpret_cast<uint8_t*>(&dest), r)) return false;
+            uint8_t extra;
+            return !r.next(extra) && !r.bad;
+        }
+
+        /**
+         * @copydoc decode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline bool decode(T& dest, const _FromT* src, size_t srcsize) noexcept {
+            return decode(dest, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+     protected:
+        static constexpr bool identity = LAYOUT::identity_from(0) && LAYOUT::wire_size == sizeof(T);
+
+        /* Unescapes one character at a time, stopping at END or the end of input. */
+        struct reader {
+            const char_type* at;
+            const char_type* end;
+            bool bad;
+            bool next(uint8_t& c) noexcept {
+                if (at >= end || *at == DECODER::end_code()) return false;
+                if (*at != DECODER::esc_code()) {
+                    c = static_cast<uint8_t>(*(at++));
+                    return true;
+                }
+                if (++at >= end) return !(bad = true);
+                for (int i = 0; i < DECODER::num_specials; i++) {
+                    if (*at == DECODER::escaped_codes()[i]) {
+                        at++;
+                        c = static_cast<uint8_t>(DECODER::special_codes()[i]);
+                        return true;
+                    }
+                }
+                return !(bad = true);
+            }
+        };
+    };
+
+}
+
+#endif // __SLIPRECORD_H__
@@ -0,0 +1,253 @@
+/*!
+ *  @file SlipRing.h
+ *
+ *  Wait-free single-producer/single-consumer byte ring that decodes SLIP
+ *  frames in place as they arrive.
+ *
+ *  Meant for handing received bytes from a UART interrupt to the main loop.
+ *  Needs <atomic>, so 32-bit MCU toolchains and hosts only.
+ */
+
+#pragma once
+
+#ifndef __SLIPRING_H__
+    #define __SLIPRING_H__
+
+    #include "SlipInPlace.h"
+    #include <atomic>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Decoded frame in a ring
+     **************************************************************************************/
+
+    /**
+     * @brief A decoded frame still held by a ring.
+     *
+     * A frame that wraps around the end of the ring storage comes in two
+     * segments. Otherwise second_size is zero.
+     *
+     * @tparam _CharT   character type of the ring
+     */
+    template <typename _CharT>
+    struct ring_frame {
+        _CharT* first      = nullptr; ///< start of the frame
+        size_t first_size  = 0;       ///< bytes at first
+        _CharT* second     = nullptr; ///< rest of a wrapped frame, at the start of the ring
+        size_t second_size = 0;       ///< bytes at second
+        size_t end_index   = 0;       ///< ring index just past the frame's END, used by release()
+
+        /** decoded size of the frame */
+        size_t size() const noexcept { return first_size + second_size; }
+
+        /**
+         * @brief Copy the frame into one contiguous buffer.
+         * @return size_t   size(), or 0 if dest is too small
+         */
+        size_t copy(_CharT* dest, size_t destsize) const noexcept {
+            if (!dest || destsize < size()) return 0;
+            memcpy(dest, first, first_size * sizeof(_CharT));
+            if (second_size) memcpy(dest + first_size, second, second_size * sizeof(_CharT));
+            return size();
+        }
+    };
+
+    /**************************************************************************************
+     * Tracing policy
+     **************************************************************************************/
+
+    /**
+     * @brief Default tracer for spsc_ring: does nothing.
+     *
+     * Positions are ring indices that only grow. See SlipTrace.h for a tracer
+     * that timestamps these events.
+     */
+    struct no_trace {
+        /** Producer: characters up to pos have arrived. */
+        static __ALWAYS_INLINE__ void arrived(const void*, size_t) noexcept {}
+        /** Consumer: the END just before pos was found. */
+        static __ALWAYS_INLINE__ void end_found(const void*, size_t) noexcept {}
+        /** Consumer: the frame whose END is just before pos was returned by next(). */
+        static __ALWAYS_INLINE__ void delivered(const void*, size_t) noexcept {}
+    };
+
+    /**************************************************************************************
+     * SPSC ring
+     **************************************************************************************/
+
+    /**
+     * @brief Fixed-capacity SPSC ring with incremental in-place SLIP decoding.
+     *
+     * The producer (typically an RX interrupt) calls push() or write(). Neither
+     * ever waits: bytes that do not fit are dropped and counted.
+     *
+     * The consumer calls next() to decode whatever has arrived. Each raw byte is
+     * decoded once, in place, so a partly received frame is never rescanned.
+     * Decoded bytes stay where they are until the consumer hands the frame back
+     * with release(). Frames must be released in the order next() returned them.
+     *
+     * Empty frames (for example the leading END many senders emit) are skipped.
+     * Frames with bad escapes, and frames too long to ever fit in the ring, are
+     * dropped and counted in errors().
+     *
+     * @tparam N        capacity in characters, a power of two
+     * @tparam DECODER  the decoder_base type whose codes to use
+     * @tparam TRACER   tracing policy, no_trace by default
+     */
+    template <size_t N, class DECODER = decoder, class TRACER = no_trace>
+    class spsc_ring {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "ring capacity must be a power of two");
+
+     public:
+        using char_type = typename DECODER::char_type;
+        using frame     = ring_frame<char_type>;
+
+        static constexpr size_t capacity = N;
+
+        /**
+         * @brief Producer: append one received character.
+         * @return false if the ring was full and c was dropped
+         */
+        bool push(char_type c) noexcept {
+            size_t head = _head.load(std::memory_order_relaxed);
+            if (head - _tail.load(std::memory_order_acquire) == N) {
+                _dropped.store(_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+            _buf[head & mask] = c;
+            _head.store(head + 1, std::memory_order_release);
+            TRACER::arrived(this, head + 1);
+            return true;
+        }
+
+        /**
+         * @brief Producer: append up to n received characters.
+         * @return size_t   characters appended. The rest were dropped.
+         */
+        size_t write(const char_type* src, size_t n) noexcept {
+            size_t head = _head.load(std::memory_order_relaxed);
+            size_t room = N - (head - _tail.load(std::memory_order_acquire));
+            if (n > room) {
+                _dropped.store(_dropped.load(std::memory_order_relaxed) + (n - room), std::memory_order_relaxed);
+                n = room;
+            }
+            size_t at = head & mask, k = (n < N - at) ? n : N - at;
+            memcpy(_buf + at, src, k * sizeof(char_type));
+            memcpy(_buf, src + k, (n - k) * sizeof(char_type));
+            _head.store(head + n, std::memory_order_release);
+            if (n) TRACER::arrived(this, head + n);
+            return n;
+        }
+
+        /** Characters the producer had to drop because the ring was full. */
+        size_t dropped() const noexcept { return _dropped.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Consumer: decode newly arrived characters up to the next complete frame.
+         *
+         * @param f         set to the frame when one is complete
+         * @return true     if f holds a new frame, false if more input is needed
+         */
+        bool next(frame& f) noexcept {
+            const size_t head = _head.load(std::memory_order_acquire);
+            while (_scan != head) {
+                if (_out == _scan && !_escaped && !_bad) {
+                    // nothing escaped yet, so decoded characters are already in place
+                    size_t at = _scan & mask, n = (head - _scan < N - at) ? head - _scan : N - at, k = 0;
+                    const char_type* seg = _buf + at;
+                    while (k < n && seg[k] != DECODER::end_code() && seg[k] != DECODER::esc_code()) k++;
+                    _scan += k;
+                    _out += k;
+                    if (k == n) continue;
+                }
+                char_type c = _buf[_scan++ & mask];
+                if (_escaped) {
+                    _escaped = false;
+                    int isp  = escape_index(c);
+                    if (isp < 0)
+                        _bad = true;
+                    else if (!_bad)
+                        _buf[_out++ & mask] = DECODER::special_codes()[isp];
+                } else if (c == DECODER::end_code()) {
+                    TRACER::end_found(this, _scan);
+                    if (finish(f)) {
+                        TRACER::delivered(this, _scan);
+                        return true;
+                    }
+                } else if (c == DECODER::esc_code()) {
+                    _escaped = true;
+                } else if (!_bad) {
+                    _buf[_out++ & mask] = c;
+                }
+            }
+            if (_outstanding == 0 && (_bad || head - _tail.load(std::memory_order_relaxed) == N)) {
+                // a frame that fills the whole ring can never complete: drop it up to its END
+                _bad         = true;
+                _frame_start = _out = _scan;
+                _tail.store(_scan, std::memory_order_release);
+            }
+            return false;
+        }
+
+        /** Consumer: hand the oldest frame returned by next() back to the producer. */
+        void release(const frame& f) noexcept {
+            if (_outstanding == 0) return;
+            _outstanding--;
+            // with nothing else held, also free any skipped frames after f
+            _tail.store(_outstanding ? f.end_index : _frame_start, std::memory_order_release);
+        }
+
+        /** Characters received and not yet released. */
+        size_t size() const noexcept {
+            return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+        }
+
+        size_t frames() const noexcept { return _frames; } ///< frames returned by next()
+        size_t errors() const noexcept { return _errors; } ///< frames dropped as bad or too long
+
+     protected:
+        static constexpr size_t mask = N - 1;
+
+        static int escape_index(char_type c) noexcept {
+            for (int i = 0; i < DECODER::num_specials; i++) {
+                if (c == DECODER::escaped_codes()[i]) return i;
+            }
+            return -1;
+        }
+
+        bool finish(frame& f) noexcept {
+            size_t start = _frame_start, len = _out - start;
+            bool bad     = _bad;
+            _frame_start = _out = _scan;
+            _bad                = false;
+            if (bad) _errors++;
+            if (bad || len == 0) {
+                if (_outstanding == 0) _tail.store(_scan, std::memory_order_release);
+                return false;
+            }
+            size_t at     = start & mask;
+            f.first       = _buf + at;
+            f.first_size  = (len < N - at) ? len : N - at;
+            f.second      = _buf;
+            f.second_size = len - f.first_size;
+            f.end_index   = _scan;
+            _outstanding++;
+            _frames++;
+            return true;
+        }
+
+        // producer side, then the storage, then consumer side, so the two
+        // indices do not share a cache line on hosts
+        std::atomic<size_t> _head{0};
+        std::atomic<size_t> _dropped{0};
+        char_type _buf[N];
+        std::atomic<size_t> _tail{0};
+        size_t _scan = 0, _out = 0, _frame_start = 0;
+        size_t _outstanding = 0, _frames = 0, _errors = 0;
+        bool _escaped = false, _bad = false;
+    };
+
+}
+
+#endif // __SLIPRING_H__
@@ -0,0 +1,612 @@
+/*!
+ *  @file SlipScheduler.h
+ *
+ *  Many SLIP links on many cores: channels are sharded across worker threads,
+ *  each with its own epoll set, and the work of a ready channel is a task that
+ *  idle workers steal. Frames of one channel are handled in order, by one
+ *  worker at a time.
+ *
+ *  Host only: needs Linux (epoll, eventfd, thread affinity).
+ */
+
+#pragma once
+
+#ifndef __SLIPSCHEDULER_H__
+    #define __SLIPSCHEDULER_H__
+
+    #include "SlipStream.h"
+
+    #ifdef __linux__
+
+        #include <atomic>
+        #include <deque>
+        #include <errno.h>
+        #include <fcntl.h>
+        #include <functional>
+        #include <memory>
+        #include <mutex>
+        #include <pthread.h>
+        #include <sched.h>
+        #include <sys/epoll.h>
+        #include <sys/eventfd.h>
+        #include <sys/uio.h>
+        #include <thread>
+        #include <unistd.h>
+        #include <vector>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Work-stealing deque
+     **************************************************************************************/
+
+    /**
+     * @brief Bounded Chase-Lev deque.
+     *
+     * The owning thread pushes and pops at the bottom, other threads steal from
+     * the top. T must be trivially copyable. Capacity is rounded up to a power
+     * of two, and push() fails when the deque is full.
+     */
+    template <class T>
+    class work_deque {
+     public:
+        explicit work_deque(size_t capacity) {
+            size_t n = 1;
+            while (n < capacity) n <<= 1;
+            _mask  = n - 1;
+            _slots = std::unique_ptr<std::atomic<T>[]>(new std::atomic<T>[n]);
+        }
+
+        /** Owner only. */
+        bool push(T x) noexcept {
+            int64_t b = _bottom.load(std::memory_order_relaxed);
+            int64_t t = _top.load(std::memory_order_acquire);
+            if (b - t > static_cast<int64_t>(_mask)) return false;
+            _slots[b & _mask].store(x, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /** Owner only: take the newest item. */
+        bool pop(T& x) noexcept {
+            int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+            _bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = _top.load(std::memory_order_relaxed);
+            if (t > b) { // empty
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            x = _slots[b & _mask].load(std::memory_order_relaxed);
+            if (t == b) { // the last item: race the thieves for it
+                bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /** Any thread: take the oldest item. Fails when empty or when another thread won the race. */
+        bool steal(T& x) noexcept {
+            int64_t t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = _bottom.load(std::memory_order_acquire);
+            if (t >= b) return false;
+            x = _slots[t & _mask].load(std::memory_order_relaxed);
+            return _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        /** Items in the deque, approximate while other threads use it. */
+        size_t size() const noexcept {
+            int64_t n = _bottom.load(std::memory_order_relaxed) - _top.load(std::memory_order_relaxed);
+            return n > 0 ? static_cast<size_t>(n) : 0;
+        }
+
+     private:
+        // thieves and the owner write different cache lines
+        std::atomic<int64_t> _top{0};
+        char _pad[64 - sizeof(std::atomic<int64_t>)];
+        std::atomic<int64_t> _bottom{0};
+        size_t _mask;
+        std::unique_ptr<std::atomic<T>[]> _slots;
+    };
+
+    /**************************************************************************************
+     * Scheduler
+     **************************************************************************************/
+
+    /**
+     * @brief Reads, decodes and writes many SLIP channels on a pool of worker threads.
+     *
+     * Each channel belongs to the epoll set of one worker, its shard. When the
+     * fd is ready, or a frame is sent on the channel, the channel is scheduled:
+     * its index goes on the work_deque of the worker that noticed, once until
+     * the task has run. The task reads the fd, decodes in place with the
+     * channel's stream_buffer, calls the handler for each frame, and writes the
+     * channel's queue with writev(). Workers with nothing to do steal tasks
+     * from the others, so a burst on one shard spreads over all cores, while a
+     * channel is never run by two workers at once and its frames are handled
+     * in order. Fds are watched with EPOLLONESHOT and re-armed by the task.
+     *
+     * Handlers may send() on any channel, and so may other threads. Channels
+     * are added before start(). File descriptors are made non-blocking and are
+     * not closed by the scheduler. A channel closes at end of file or on a read
+     * or write error, after its last frame without an END is handled.
+     *
+     * @tparam ENCODER  the encoder_base type for send()
+     * @tparam DECODER  the decoder_base type for received frames
+     */
+    template <class ENCODER = encoder, class DECODER = decoder>
+    class scheduler {
+     public:
+        using char_type = typename DECODER::char_type;
+        using handler   = std::function<void(size_t channel, const char_type* frame, size_t size)>;
+
+        /**
+         * @param max_channels  most channels that will be added
+         * @param workers       worker threads. 0 uses std::thread::hardware_concurrency()
+         * @param buffer_size   receive buffer characters per channel, at least the largest decoded frame
+         */
+        explicit scheduler(size_t max_channels, size_t workers = 0, size_t buffer_size = 4096)
+            : _max_channels(max_channels), _buffer_size(buffer_size) {
+            if (workers == 0) workers = std::thread::hardware_concurrency();
+            if (workers == 0) workers = 1;
+            for (size_t w = 0; w < workers; w++) _workers.emplace_back(new worker(max_channels));
+        }
+        ~scheduler() { stop(); }
+
+        scheduler(const scheduler&)            = delete;
+        scheduler& operator=(const scheduler&) = delete;
+
+        /** The epoll set and wakeup eventfd of every worker were created. */
+        bool ok() const noexcept {
+            for (auto& w : _workers)
+                if (w->epfd < 0 || w->wakefd < 0) return false;
+            return true;
+        }
+
+        size_t workers() const noexcept { return _workers.size(); } ///< worker threads
+
+        /**
+         * @brief Watch fd, which is made non-blocking. Only before start().
+         * @param shard     worker whose epoll set watches fd, -1 for round robin
+         * @return channel number, or -1 on errors
+         */
+        int add(int fd, handler on_frame, int shard = -1) {
+            if (_running || _channels.size() >= _max_channels || !ok()) return -1;
+            int flags = fcntl(fd, F_GETFL);
+            if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) return -1;
+            size_t ch = _channels.size();
+            size_t w  = shard < 0 ? ch % _workers.size() : static_cast<size_t>(shard) % _workers.size();
+            _channels.emplace_back(new channel(fd, w, _buffer_size, std::move(on_frame)));
+            if (!arm(ch, EPOLL_CTL_ADD)) {
+                _channels.pop_back();
+                return -1;
+            }
+            _open++;
+            return static_cast<int>(ch);
+        }
+
+        /**
+         * @brief Start the workers.
+         * @param pin   pin worker i to the i-th CPU this process may run on
+         * @return false if the scheduler is running or could not be set up
+         */
+        bool start(bool pin = true) {
+            if (_running || !ok()) return false;
+            _stopping = false;
+            _running  = true;
+            std::vector<int> cpus;
+            if (pin) cpus = allowed_cpus();
+            _pinned = !cpus.empty();
+            for (size_t w = 0; w < _workers.size(); w++) {
+                _workers[w]->thread = std::thread([this, w] { work(w); });
+                if (!cpus.empty()) {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(cpus[w % cpus.size()], &set);
+                    if (pthread_setaffinity_np(_workers[w]->thread.native_handle(), sizeof(set), &set)) _pinned = false;
+                }
+            }
+            return true;
+        }
+
+        /** Stop and join the workers. Tasks not run yet stay scheduled for the next start(). */
+        void stop() {
+            if (!_running) return;
+            _stopping.store(true);
+            for (auto& w : _workers) wake(*w);
+            for (auto& w : _workers) w->thread.join();
+            _running = false;
+        }
+
+        bool running() const noexcept { return _running; } ///< between start() and stop()
+        bool pinned() const noexcept { return _pinned; }   ///< every worker was pinned to a CPU
+
+        /** Stop watching channel ch. Queued frames are discarded and the fd is left open. */
+        void remove(size_t ch) { schedule(ch, closing); }
+
+        bool is_open(size_t ch) const noexcept { return _channels[ch]->open.load(); } ///< not closed or removed
+        size_t open_channels() const noexcept { return _open.load(); }              ///< channels open
+        int error(size_t ch) const noexcept { return _channels[ch]->error.load(); }  ///< errno that closed ch, or 0
+        size_t shard(size_t ch) const noexcept { return _channels[ch]->shard; }      ///< worker watching ch
+
+        uint64_t frames(size_t ch) const noexcept { return _channels[ch]->frames.load(std::memory_order_relaxed); }       ///< frames received
+        uint64_t errors(size_t ch) const noexcept { return _channels[ch]->errors.load(std::memory_order_relaxed); }       ///< bad escapes
+        uint64_t oversized(size_t ch) const noexcept { return _channels[ch]->oversized.load(std::memory_order_relaxed); } ///< frames too large
+        size_t pending(size_t ch) const noexcept { return _channels[ch]->pending.load(std::memory_order_relaxed); }       ///< characters queued
+
+        uint64_t tasks(size_t w) const noexcept { return _workers[w]->tasks.load(std::memory_order_relaxed); }   ///< tasks run by worker w
+        uint64_t steals(size_t w) const noexcept { return _workers[w]->steals.load(std::memory_order_relaxed); } ///< of which stolen
+
+        /** Largest queue per channel, in encoded characters. send() refuses frames beyond it. */
+        void set_max_pending(size_t n) noexcept { _max_pending = n; }
+
+        /** Index of the worker running the calling thread, -1 outside this scheduler's workers. */
+        int current_worker() const noexcept {
+            const current& cur = current_thread();
+            return cur.owner == this ? static_cast<int>(cur.index) : -1;
+        }
+
+        /**
+         * @brief Encode a frame and queue it on channel ch. From any thread.
+         *
+         * The channel is scheduled, and its task writes the queue.
+         *
+         * @return false if ch is closed or its queue is full
+         */
+        bool send(size_t ch, const char_type* payload, size_t size) {
+            channel& c = *_channels[ch];
+            {
+                std::lock_guard<std::mutex> lock(c.lock);
+                if (!c.open.load(std::memory_order_relaxed) || c.pending + size + 1 > _max_pending) return false;
+                std::vector<char_type> f;
+                if (!c.spare.empty()) {
+                    f = std::move(c.spare.back());
+                    c.spare.pop_back();
+                }
+                f.resize(2 * size + 1);
+                size_t n = ENCODER::encode(f.data(), f.size(), payload, size);
+                if (!n || c.pending + n > _max_pending) {
+                    c.spare.push_back(std::move(f));
+                    return false;
+                }
+                f.resize(n);
+                c.pending += n;
+                c.out.push_back(std::move(f));
+            }
+            schedule(ch, writable);
+            return true;
+        }
+
+        /**
+         * @copydoc send
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        bool send(size_t ch, const _FromT* payload, size_t size) {
+            return send(ch, reinterpret_cast<const char_type*>(payload), size);
+        }
+
+     private:
+        static constexpr unsigned scheduled = 1; // on a deque or running
+        static constexpr unsigned readable  = 2; // the fd had an event
+        static constexpr unsigned writable  = 4; // frames were queued
+        static constexpr unsigned closing   = 8; // remove() was called
+
+        static constexpr int max_reads     = 4;   // reads per task, for fairness
+        static constexpr int max_rounds    = 4;   // task rounds before it goes back on the deque
+        static constexpr int max_iov       = 64;  // frames per writev
+        static constexpr size_t max_spare  = 16;  // frame vectors kept for reuse
+        static constexpr unsigned poll_gap = 32;  // tasks between checks of the own epoll set
+        static constexpr uint64_t wake_key = ~0ull;
+
+        struct channel {
+            channel(int fd, size_t shard, size_t size, handler h)
+                : fd(fd), shard(shard), buf(size), stream(buf.data(), size), on_frame(std::move(h)) {}
+            int fd;
+            size_t shard;
+            std::vector<char_type> buf;
+            stream_buffer<DECODER> stream; // task only
+            handler on_frame;
+            bool armed_out = false;        // task only: EPOLLOUT is in the armed events
+            std::atomic<unsigned> flags{0};
+            std::mutex lock;               // for the queue
+            std::deque<std::vector<char_type>> out;
+            std::vector<std::vector<char_type>> spare;
+            size_t sent = 0; // characters of out.front() already written
+            std::atomic<size_t> pending{0};
+            std::atomic<bool> open{true};
+            std::atomic<int> error{0};
+            std::atomic<uint64_t> frames{0}, errors{0}, oversized{0};
+        };
+
+        struct worker {
+            explicit worker(size_t capacity) : tasks_ready(capacity) {
+                epfd   = epoll_create1(EPOLL_CLOEXEC);
+                wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (epfd >= 0 && wakefd >= 0) {
+                    struct epoll_event ev;
+                    ev.events   = EPOLLIN;
+                    ev.data.u64 = wake_key;
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &ev);
+                }
+            }
+            ~worker() {
+                if (epfd >= 0) close(epfd);
+                if (wakefd >= 0) close(wakefd);
+            }
+            work_deque<size_t> tasks_ready;
+            std::mutex inject_lock; // tasks scheduled from outside the workers
+            std::vector<size_t> injected;
+            std::atomic<bool> has_injected{false};
+            std::atomic<bool> sleeping{false};
+            std::atomic<uint64_t> tasks{0}, steals{0};
+            int epfd;
+            int wakefd;
+            std::thread thread;
+        };
+
+        struct current {
+            const void* owner = nullptr;
+            size_t index      = 0;
+        };
+        static current& current_thread() noexcept {
+            static thread_local current cur;
+            return cur;
+        }
+
+        static std::vector<int> allowed_cpus() {
+            std::vector<int> cpus;
+            cpu_set_t set;
+            if (sched_getaffinity(0, sizeof(set), &set) == 0)
+                for (int i = 0; i < CPU_SETSIZE; i++)
+                    if (CPU_ISSET(i, &set)) cpus.push_back(i);
+            return cpus;
+        }
+
+        bool arm(size_t ch, int op) {
+            channel& c = *_channels[ch];
+            struct epoll_event ev;
+            ev.events   = EPOLLIN | EPOLLONESHOT | (c.armed_out ? static_cast<uint32_t>(EPOLLOUT) : 0);
+            ev.data.u64 = ch;
+            return epoll_ctl(_workers[c.shard]->epfd, op, c.fd, &ev) == 0;
+        }
+
+        void wake(worker& w) {
+            uint64_t one = 1;
+            ssize_t k    = write(w.wakefd, &one, sizeof(one));
+            (void)k;
+        }
+
+        // hand a task to a sleeping worker so it comes to steal
+        void wake_one() {
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the one in has_work()
+            if (_sleepers.load() == 0) return;
+            for (auto& w : _workers) {
+                if (w->sleeping.exchange(false)) {
+                    wake(*w);
+                    return;
+                }
+            }
+        }
+
+        void schedule(size_t ch, unsigned bits) {
+            channel& c = *_channels[ch];
+            if (c.flags.fetch_or(bits | scheduled) & scheduled) return; // the task will see bits
+            const current& cur = current_thread();
+            if (cur.owner == this) {
+                worker& me = *_workers[cur.index];
+                me.tasks_ready.push(ch); // never full: a channel is on at most one deque
+                if (me.tasks_ready.size() > 1) wake_one();
+            } else {
+                worker& w = *_workers[c.shard];
+                {
+                    std::lock_guard<std::mutex> lock(w.inject_lock);
+                    w.injected.push_back(ch);
+                }
+                w.has_injected.store(true);
+                if (w.sleeping.exchange(false)) wake(w);
+            }
+        }
+
+        void work(size_t index) {
+            current& cur = current_thread();
+            cur.owner    = this;
+            cur.index    = index;
+            worker& me   = *_workers[index];
+            unsigned since_poll = 0;
+            size_t ch;
+            while (!_stopping.load(std::memory_order_relaxed)) {
+                if (me.has_injected.load()) take_injected(me);
+                if (++since_poll >= poll_gap) { // keep the own channels moving while busy
+                    since_poll = 0;
+                    poll_events(me, 0);
+                }
+                if (me.tasks_ready.pop(ch) || steal(index, ch)) {
+                    run(ch);
+                    me.tasks.store(me.tasks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    continue;
+                }
+                since_poll = 0;
+                if (poll_events(me, 0)) continue;
+                // idle: announce it, look once more, then sleep in epoll_wait
+                me.sleeping.store(true);
+                _sleepers.fetch_add(1);
+                if (!has_work()) poll_events(me, -1);
+                me.sleeping.store(false);
+                _sleepers.fetch_sub(1);
+            }
+            cur.owner = nullptr;
+        }
+
+        bool has_work() const noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_stopping.load()) return true;
+            for (auto& w : _workers)
+                if (w->tasks_ready.size() || w->has_injected.load()) return true;
+            return false;
+        }
+
+        bool steal(size_t index, size_t& ch) {
+            size_t n = _workers.size();
+            for (size_t i = 1; i < n; i++) {
+                worker& victim = *_workers[(index + i) % n];
+                if (victim.tasks_ready.steal(ch)) {
+                    worker& me = *_workers[index];
+                    me.steals.store(me.steals.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    if (victim.tasks_ready.size() > 1) wake_one(); // more to share
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void take_injected(worker& me) {
+            std::vector<size_t> batch;
+            {
+                std::lock_guard<std::mutex> lock(me.inject_lock);
+                batch.swap(me.injected);
+                me.has_injected.store(false);
+            }
+            for (size_t ch : batch) me.tasks_ready.push(ch);
+            if (me.tasks_ready.size() > 1) wake_one();
+        }
+
+        size_t poll_events(worker& me, int timeout_ms) {
+            struct epoll_event ev[64];
+            int n = epoll_wait(me.epfd, ev, 64, timeout_ms);
+            size_t ready = 0;
+            for (int i = 0; i < n; i++) {
+                if (ev[i].data.u64 == wake_key) {
+                    uint64_t count;
+                    ssize_t k = read(me.wakefd, &count, sizeof(count));
+                    (void)k;
+                    continue;
+                }
+                schedule(static_cast<size_t>(ev[i].data.u64), readable);
+                ready++;
+            }
+            if (me.has_injected.load()) take_injected(me);
+            return ready;
+        }
+
+        void run(size_t ch) {
+            channel& c = *_channels[ch];
+            for (int round = 0;; round++) {
+                if (round == max_rounds) { // busy channel: let the others run
+                    _workers[current_thread().index]->tasks_ready.push(ch);
+                    return;
+                }
+                unsigned work = c.flags.fetch_and(scheduled);
+                if ((work & closing) && c.open.load()) close_channel(c, 0);
+                if ((work & readable) && c.open.load()) read_channel(ch);
+                if (c.pending.load() && c.open.load()) write_queue(c);
+                if (c.open.load()) {
+                    bool want_out = c.pending.load() != 0;
+                    if ((work & readable) || want_out != c.armed_out) {
+                        c.armed_out = want_out;
+                        arm(ch, EPOLL_CTL_MOD);
+                    }
+                }
+                unsigned expected = scheduled;
+                if (c.flags.compare_exchange_strong(expected, 0)) return;
+            }
+        }
+
+        void read_channel(size_t ch) {
+            channel& c   = *_channels[ch];
+            auto deliver = [&c, ch](const char_type* frame, size_t size) {
+                if (c.open.load(std::memory_order_relaxed)) c.on_frame(ch, frame, size);
+            };
+            for (int i = 0; i < max_reads && c.open.load(); i++) {
+                c.stream.prepare();
+                size_t want = c.stream.room() * sizeof(char_type); // received() shrinks room()
+                ssize_t k   = read(c.fd, c.stream.space(), want);
+                if (k > 0) {
+                    c.stream.received(k / sizeof(char_type), deliver);
+                    if (static_cast<size_t>(k) < want) break; // drained, probably
+                } else if (k < 0 && errno == EINTR) {
+                    continue;
+                } else if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                } else {
+                    c.stream.finish(deliver); // end of file or error
+                    close_channel(c, k < 0 ? errno : 0);
+                }
+            }
+            c.frames.store(c.stream.frames(), std::memory_order_relaxed);
+            c.errors.store(c.stream.errors(), std::memory_order_relaxed);
+            c.oversized.store(c.stream.oversized(), std::memory_order_relaxed);
+        }
+
+        void write_queue(channel& c) {
+            for (;;) {
+                struct iovec iov[max_iov];
+                int n = 0;
+                {
+                    std::lock_guard<std::mutex> lock(c.lock);
+                    for (auto it = c.out.begin(); it != c.out.end() && n < max_iov; ++it, ++n) {
+                        size_t skip     = n ? 0 : c.sent;
+                        iov[n].iov_base = const_cast<char_type*>(it->data() + skip);
+                        iov[n].iov_len  = (it->size() - skip) * sizeof(char_type);
+                    }
+                }
+                if (n == 0) return;
+                ssize_t k = writev(c.fd, iov, n); // only the task pops, so the iovecs stay valid
+                if (k < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                    close_channel(c, errno);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(c.lock);
+                size_t done = k / sizeof(char_type);
+                c.pending -= done;
+                while (done) {
+                    size_t left = c.out.front().size() - c.sent;
+                    if (done < left) {
+                        c.sent += done;
+                        break;
+                    }
+                    done -= left;
+                    c.sent = 0;
+                    if (c.spare.size() < max_spare) c.spare.push_back(std::move(c.out.front()));
+                    c.out.pop_front();
+                }
+            }
+        }
+
+        void close_channel(channel& c, int error) {
+            {
+                std::lock_guard<std::mutex> lock(c.lock);
+                if (!c.open.load()) return;
+                c.error.store(error);
+                c.open.store(false);
+                c.out.clear();
+                c.sent    = 0;
+                c.pending = 0;
+            }
+            epoll_ctl(_workers[c.shard]->epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+            _open--;
+        }
+
+        size_t _max_channels;
+        size_t _buffer_size;
+        size_t _max_pending = 1 << 20;
+        bool _running       = false;
+        bool _pinned        = false;
+        std::atomic<bool> _stopping{false};
+        std::atomic<size_t> _sleepers{0};
+        std::atomic<size_t> _open{0};
+        std::vector<std::unique_ptr<worker>> _workers;
+        std::vector<std::unique_ptr<channel>> _channels; // fixed while running
+    };
+
+}
+
+    #endif // __linux__
+
+#endif // __SLIPSCHEDULER_H__
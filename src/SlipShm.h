@@ -0,0 +1,603 @@
+/*!
+ *  @file SlipShm.h
+ *
+ *  Hand SLIP frames from one process to others through shared memory: a
+ *  single-producer, multi-consumer ring of encoded frames in a memfd or a
+ *  POSIX shared memory object, with futex wakeups.
+ *
+ *  Host only: needs Linux (memfd, futex).
+ */
+
+#pragma once
+
+#ifndef __SLIPSHM_H__
+    #define __SLIPSHM_H__
+
+    #include "SlipInPlace.h"
+
+    #ifdef __linux__
+
+        #include <algorithm>
+        #include <atomic>
+        #include <chrono>
+        #include <climits>
+        #include <cstddef>
+        #include <errno.h>
+        #include <fcntl.h>
+        #include <linux/futex.h>
+        #include <new>
+        #include <signal.h>
+        #include <string>
+        #include <sys/mman.h>
+        #include <sys/stat.h>
+        #include <sys/syscall.h>
+        #include <time.h>
+        #include <unistd.h>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Shared layout
+     **************************************************************************************/
+
+    /** @brief What a consumer checks before mapping a shared ring. */
+    struct shm_ring_info {
+        static constexpr uint32_t magic_value   = 0x52504c53; // "SLPR"
+        static constexpr uint16_t version_value = 1;
+
+        uint32_t magic;
+        uint16_t version;
+        uint8_t char_size;
+        uint8_t end_code;
+        uint8_t esc_code;
+        uint8_t reserved[3];
+        uint32_t max_consumers;
+        uint64_t capacity; // characters, a power of two
+    };
+
+    /**
+     * @brief Start of a shared ring: what the producer and consumers share besides the data.
+     *
+     * Positions are character counts that only grow. The data is a plain SLIP
+     * stream, so runs of END (the padding before a wrap) are empty frames.
+     */
+    struct shm_ring_header {
+        shm_ring_info info; // first, read with pread() before mapping
+
+        alignas(64) std::atomic<uint64_t> head; // end of the committed frames
+        std::atomic<uint32_t> data_seq;         // futex word: bumped to wake consumers
+        std::atomic<uint32_t> data_waiters;     // consumers sleeping on data_seq
+        std::atomic<uint32_t> closed;           // the producer is done
+
+        alignas(64) std::atomic<uint32_t> space_seq; // futex word: bumped to wake the producer
+        std::atomic<uint32_t> space_waiters;         // the producer sleeps on space_seq
+    };
+
+    /** @brief A consumer's place in a shared ring. */
+    struct shm_consumer_slot {
+        enum : uint32_t { vacant = 0, joining = 1, active = 2 };
+        alignas(64) std::atomic<uint32_t> state;
+        std::atomic<int32_t> pid;
+        std::atomic<uint64_t> tail; // the consumer released everything before
+    };
+
+    /** @brief Where things are in the shared memory. */
+    struct shm_ring_layout {
+        static constexpr size_t page = 4096;
+        static size_t slots_offset() noexcept { return sizeof(shm_ring_header); }
+        static size_t data_offset(size_t max_consumers) noexcept {
+            size_t end = slots_offset() + max_consumers * sizeof(shm_consumer_slot);
+            return (end + page - 1) / page * page;
+        }
+        static size_t size(size_t max_consumers, size_t data_bytes) noexcept {
+            return data_offset(max_consumers) + data_bytes;
+        }
+    };
+
+    /** @brief Process-shared futex operations on a 32-bit atomic. */
+    struct shm_futex {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit");
+
+        /** Sleep while w holds expected, at most timeout_ms (-1 for ever). */
+        static void wait(std::atomic<uint32_t>& w, uint32_t expected, int timeout_ms) noexcept {
+            struct timespec ts;
+            ts.tv_sec  = timeout_ms / 1000;
+            ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&w), FUTEX_WAIT, expected, timeout_ms < 0 ? nullptr : &ts,
+                    nullptr, 0);
+        }
+        /** Milliseconds left until deadline, for a timeout_ms of -1 (for ever) or more. */
+        static int left_ms(std::chrono::steady_clock::time_point deadline, int timeout_ms) noexcept {
+            if (timeout_ms < 0) return -1;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            return ms > 0 ? static_cast<int>(ms) : 0;
+        }
+
+        /** Wake every thread sleeping on w, in any process. */
+        static void wake(std::atomic<uint32_t>& w) noexcept {
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&w), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+    };
+
+    /**************************************************************************************
+     * Frames in a shared ring
+     **************************************************************************************/
+
+    /**
+     * @brief An encoded frame viewed in place in a shared ring.
+     *
+     * The data is read-only and shared with the other consumers, so the frame is
+     * decoded to a buffer of the consumer's own, or only validated.
+     *
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <class DECODER = decoder>
+    struct shm_frame {
+        using char_type = typename DECODER::char_type;
+
+        const char_type* data = nullptr; ///< encoded frame in the ring, END included
+        size_t size           = 0;       ///< encoded characters at data
+        uint64_t end          = 0;       ///< ring position after the frame, for release()
+
+        /** Decoded size, without checking the escapes. */
+        size_t decoded_size() const noexcept { return DECODER::decoded_size(data, size); }
+
+        /** @brief Decode to dest. @return decoded size, 0 on errors or if dest is too small */
+        size_t decode(char_type* dest, size_t destsize) const noexcept { return DECODER::decode(dest, destsize, data, size); }
+
+        /** Every escape is a valid pair, and no raw special character is left, without decoding. */
+        bool valid() const noexcept {
+            const char_type* p = data;
+            const char_type* e = data + size - 1; // the END
+            for (; p < e; p++) {
+                if (*p == DECODER::esc_code()) {
+                    if (++p == e) return false;
+                    if (*p != DECODER::escend_code() && *p != DECODER::escesc_code() &&
+                        !(DECODER::is_null_encoded && *p == DECODER::escnull_code()))
+                        return false;
+                } else if (*p == DECODER::end_code() || (DECODER::is_null_encoded && *p == DECODER::null_code())) {
+                    return false;
+                }
+            }
+            return size && *e == DECODER::end_code();
+        }
+    };
+
+    /**************************************************************************************
+     * Producer
+     **************************************************************************************/
+
+    /**
+     * @brief Writes frames to a shared ring that other processes read.
+     *
+     * publish() encodes each frame with ENCODER::encode straight into the ring.
+     * A frame never wraps: when it does not fit before the end of the ring, the
+     * rest is filled with END and the frame goes to the start. The producer
+     * never overwrites what a consumer has not released. publish() drops the
+     * frame when there is no room, and publish_wait() sleeps until the slowest
+     * consumer makes room.
+     *
+     * Consumers that ran out of frames sleep on a futex. The producer wakes
+     * them only when one sleeps, and with set_notify_batch(n) only every n
+     * frames, so a busy ring costs no system calls at all.
+     *
+     * The ring is a memfd when no name is given. Pass fd() to the consumers,
+     * by fork() or over a Unix socket. A named ring is a POSIX shared memory
+     * object that replaces any left under the same name, and is unlinked when
+     * the producer goes away.
+     *
+     * @tparam ENCODER  the encoder_base type to use
+     */
+    template <class ENCODER = encoder>
+    class shm_producer {
+     public:
+        using char_type = typename ENCODER::char_type;
+
+        /**
+         * @param name          POSIX shared memory name such as "/link0", or nullptr for a memfd
+         * @param capacity      ring characters, rounded up to a power of two
+         * @param max_consumers consumers that may attach at once
+         */
+        explicit shm_producer(const char* name, size_t capacity = 1 << 20, size_t max_consumers = 8)
+            : _max_consumers(max_consumers) {
+            size_t n = 64;
+            while (n < capacity) n <<= 1;
+            _capacity = n;
+            _mask     = n - 1;
+            if (name) {
+                shm_unlink(name);
+                _fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+                if (_fd >= 0) _name = name;
+            } else {
+                _fd = memfd_create("slip-shm-ring", 0);
+            }
+            if (_fd < 0) return;
+            _size = shm_ring_layout::size(max_consumers, n * sizeof(char_type));
+            if (ftruncate(_fd, _size) < 0) return;
+            void* p = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+            if (p == MAP_FAILED) return;
+            _map   = static_cast<uint8_t*>(p);
+            _hdr   = new (_map) shm_ring_header();
+            _slots = reinterpret_cast<shm_consumer_slot*>(_map + shm_ring_layout::slots_offset());
+            for (size_t i = 0; i < max_consumers; i++) new (_slots + i) shm_consumer_slot();
+            _data            = reinterpret_cast<char_type*>(_map + shm_ring_layout::data_offset(max_consumers));
+            _hdr->info.char_size     = sizeof(char_type);
+            _hdr->info.end_code      = static_cast<uint8_t>(ENCODER::end_code());
+            _hdr->info.esc_code      = static_cast<uint8_t>(ENCODER::esc_code());
+            _hdr->info.capacity      = n;
+            _hdr->info.max_consumers = static_cast<uint32_t>(max_consumers);
+            _hdr->info.version       = shm_ring_info::version_value;
+            std::atomic_thread_fence(std::memory_order_release);
+            _hdr->info.magic = shm_ring_info::magic_value; // last: consumers check it
+        }
+
+        ~shm_producer() {
+            close();
+            if (_map) munmap(_map, _size);
+            if (_fd >= 0) ::close(_fd);
+            if (!_name.empty()) shm_unlink(_name.c_str());
+        }
+
+        shm_producer(const shm_producer&)            = delete;
+        shm_producer& operator=(const shm_producer&) = delete;
+
+        bool ok() const noexcept { return _hdr != nullptr; } ///< the ring was created
+        int fd() const noexcept { return _fd; }              ///< for consumers, by fork() or SCM_RIGHTS
+        size_t capacity() const noexcept { return _capacity; } ///< ring characters
+
+        uint64_t frames() const noexcept { return _frames; }   ///< frames published
+        uint64_t dropped() const noexcept { return _dropped; } ///< frames that found no room
+        uint64_t wakeups() const noexcept { return _wakeups; } ///< futex wakes of consumers
+
+        /** Consumers attached now. */
+        size_t consumers() const noexcept {
+            size_t n = 0;
+            for (size_t i = 0; i < _max_consumers; i++)
+                if (_slots[i].state.load() == shm_consumer_slot::active) n++;
+            return n;
+        }
+
+        /** Wake sleeping consumers at most every n frames, and on notify(). 1 by default. */
+        void set_notify_batch(size_t n) noexcept { _batch = n ? n : 1; }
+
+        /**
+         * @brief Encode a frame into the ring.
+         * @return false if the frame is empty, or there is no room for it and it was dropped
+         */
+        bool publish(const char_type* payload, size_t size) noexcept {
+            if (size == 0) return false;
+            int r = try_publish(payload, size);
+            if (r != published) _dropped++;
+            return r == published;
+        }
+
+        /**
+         * @brief Encode a frame into the ring, waiting for room.
+         * @param timeout_ms    -1 waits for ever
+         * @return false if the frame is empty or larger than the ring, or on a timeout
+         */
+        bool publish_wait(const char_type* payload, size_t size, int timeout_ms = -1) noexcept {
+            if (!_hdr || size == 0) return false;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            for (;;) {
+                _hdr->space_waiters.fetch_add(1);
+                uint32_t seq = _hdr->space_seq.load();
+                int r        = try_publish(payload, size);
+                int left     = (r == full) ? shm_futex::left_ms(deadline, timeout_ms) : 0;
+                if (left != 0) {
+                    notify(); // consumers may sleep on frames not announced yet
+                    shm_futex::wait(_hdr->space_seq, seq, left);
+                }
+                _hdr->space_waiters.fetch_sub(1);
+                if (left != 0) continue;
+                if (r != published) _dropped++;
+                return r == published;
+            }
+        }
+
+        /**
+         * @copydoc publish
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        bool publish(const _FromT* payload, size_t size) noexcept {
+            return publish(reinterpret_cast<const char_type*>(payload), size);
+        }
+
+        /**
+         * @copydoc publish_wait
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        bool publish_wait(const _FromT* payload, size_t size, int timeout_ms = -1) noexcept {
+            return publish_wait(reinterpret_cast<const char_type*>(payload), size, timeout_ms);
+        }
+
+        /** Wake the consumers that sleep, for frames not announced yet. */
+        void notify() noexcept {
+            _unannounced = 0;
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the one in shm_consumer::wait()
+            if (_hdr->data_waiters.load(std::memory_order_relaxed) == 0) return;
+            _hdr->data_seq.fetch_add(1);
+            shm_futex::wake(_hdr->data_seq);
+            _wakeups++;
+        }
+
+        /** No more frames: consumers see closed() once they have read the rest. */
+        void close() noexcept {
+            if (!_hdr || _hdr->closed.load()) return;
+            _hdr->closed.store(1);
+            _hdr->data_seq.fetch_add(1);
+            shm_futex::wake(_hdr->data_seq);
+        }
+
+        /**
+         * @brief Detach consumers whose process is gone, so they hold no room.
+         * @return size_t   consumers detached
+         */
+        size_t reap() noexcept {
+            size_t n = 0;
+            for (size_t i = 0; i < _max_consumers; i++) {
+                shm_consumer_slot& s = _slots[i];
+                int32_t pid          = s.pid.load();
+                if (s.state.load() == shm_consumer_slot::active && pid > 0 && kill(pid, 0) < 0 && errno == ESRCH) {
+                    s.state.store(shm_consumer_slot::vacant);
+                    n++;
+                }
+            }
+            return n;
+        }
+
+     private:
+        enum { published, full, never };
+
+        // room for n more characters, looking at the tails again when the last look was not enough
+        bool has_room(size_t n) noexcept {
+            if (_capacity - (_head - _min_tail) >= n) return true;
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the one in shm_consumer::release()
+            uint64_t low = _head;
+            for (size_t i = 0; i < _max_consumers; i++) {
+                if (_slots[i].state.load(std::memory_order_acquire) != shm_consumer_slot::active) continue;
+                uint64_t t = _slots[i].tail.load(std::memory_order_acquire);
+                if (t < low) low = t;
+            }
+            _min_tail = low;
+            return _capacity - (_head - _min_tail) >= n;
+        }
+
+        int try_publish(const char_type* payload, size_t size) noexcept {
+            if (!_hdr || size == 0) return never;
+            size_t at     = _head & _mask;
+            size_t contig = _capacity - at;
+            size_t bound  = 2 * size + 1;
+            size_t pad    = 0;
+            size_t room   = bound;
+            if (bound > contig || !has_room(bound)) { // the exact size decides
+                room = ENCODER::encoded_size(payload, size);
+                if (room > _capacity) return never;
+                if (room > contig) pad = contig;
+                if (!has_room(pad + room)) return full;
+            }
+            if (pad) {
+                for (size_t i = 0; i < pad; i++) _data[at + i] = ENCODER::end_code(); // empty frames
+                _head += pad;
+                at = 0;
+            }
+            size_t esize = ENCODER::encode(_data + at, room, payload, size);
+            if (esize == 0) return never;
+            _head += esize;
+            _hdr->head.store(_head, std::memory_order_release);
+            _frames++;
+            if (++_unannounced >= _batch) notify();
+            return published;
+        }
+
+        std::string _name;
+        int _fd                    = -1;
+        uint8_t* _map              = nullptr;
+        size_t _size               = 0;
+        shm_ring_header* _hdr      = nullptr;
+        shm_consumer_slot* _slots  = nullptr;
+        char_type* _data           = nullptr;
+        size_t _max_consumers;
+        size_t _capacity;
+        size_t _mask;
+        uint64_t _head             = 0;
+        uint64_t _min_tail         = 0;
+        size_t _batch              = 1;
+        size_t _unannounced        = 0;
+        uint64_t _frames           = 0;
+        uint64_t _dropped          = 0;
+        uint64_t _wakeups          = 0;
+    };
+
+    /**************************************************************************************
+     * Consumer
+     **************************************************************************************/
+
+    /**
+     * @brief Reads the frames of a shared ring, in place.
+     *
+     * A consumer attaches at the current end of the ring and sees every frame
+     * published from then on. next() hands out frames by pointer into the ring,
+     * which is mapped read-only. release() gives back the room of a frame and
+     * of every frame before it. Until then the producer does not overwrite
+     * them, so release in batches, but soon enough. wait() spins a little,
+     * then sleeps on a futex until the producer announces frames.
+     *
+     * @tparam DECODER  the decoder_base type to use. Its codes must be the producer's.
+     */
+    template <class DECODER = decoder>
+    class shm_consumer {
+     public:
+        using char_type = typename DECODER::char_type;
+        using frame     = shm_frame<DECODER>;
+
+        /** Attach to a named ring. */
+        explicit shm_consumer(const char* name) {
+            int fd = shm_open(name, O_RDWR, 0);
+            if (fd < 0) return;
+            attach(fd);
+            ::close(fd);
+        }
+
+        /** Attach to the ring of a producer's fd(). The fd is not closed. */
+        explicit shm_consumer(int fd) { attach(fd); }
+
+        ~shm_consumer() {
+            if (_slot) {
+                _slot->state.store(shm_consumer_slot::vacant);
+                wake_producer(_hdr->head.load());
+            }
+            if (_data) munmap(const_cast<char_type*>(_data), _data_bytes);
+            if (_map) munmap(_map, _map_size);
+        }
+
+        shm_consumer(const shm_consumer&)            = delete;
+        shm_consumer& operator=(const shm_consumer&) = delete;
+
+        bool ok() const noexcept { return _slot != nullptr; } ///< attached to a ring
+        uint64_t frames() const noexcept { return _frames; }  ///< frames read
+
+        /** The producer closed the ring and every frame was read. */
+        bool closed() const noexcept { return _hdr && _hdr->closed.load() && !available(); }
+
+        /**
+         * @brief The next frame, in place.
+         * @return false if none was published yet
+         */
+        bool next(frame& f) noexcept {
+            if (!_slot) return false;
+            uint64_t head = _hdr->head.load(std::memory_order_acquire);
+            while (_pos < head) {
+                size_t at          = _pos & _mask;
+                const char_type* p = _data + at;
+                if (*p == DECODER::end_code()) { // padding before a wrap
+                    _pos++;
+                    continue;
+                }
+                size_t n           = std::min<uint64_t>(head - _pos, _capacity - at);
+                const char_type* e = find_end(p, n);
+                if (!e) return false; // frames never wrap: the producer is broken
+                f.data = p;
+                f.size = e - p + 1;
+                f.end  = _pos + f.size;
+                _pos   = f.end;
+                _frames++;
+                return true;
+            }
+            return false;
+        }
+
+        /** Give the room of f, and of every frame before it, back to the producer. */
+        void release(const frame& f) noexcept {
+            _slot->tail.store(f.end, std::memory_order_release);
+            wake_producer(f.end);
+        }
+
+        /**
+         * @brief Wait until a frame is published or the ring is closed.
+         * @param timeout_ms    -1 waits for ever
+         * @return true if a frame is available
+         */
+        bool wait(int timeout_ms = -1) noexcept {
+            if (!_slot) return false;
+            for (int i = 0; i < spins; i++) {
+                if (available()) return true;
+                if (_hdr->closed.load(std::memory_order_relaxed)) return false;
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            for (;;) {
+                uint32_t seq = _hdr->data_seq.load();
+                _hdr->data_waiters.fetch_add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the one in shm_producer::notify()
+                int left = shm_futex::left_ms(deadline, timeout_ms);
+                if (!available() && !_hdr->closed.load() && left != 0) shm_futex::wait(_hdr->data_seq, seq, left);
+                _hdr->data_waiters.fetch_sub(1);
+                if (available()) return true;
+                if (_hdr->closed.load() || left == 0) return false;
+            }
+        }
+
+     private:
+        static constexpr int spins = 256; // looks at head before sleeping
+
+        bool available() const noexcept { return _hdr->head.load(std::memory_order_acquire) > _pos; }
+
+        // wake a producer waiting for room once half the ring is free behind tail,
+        // so that it does not wake for every frame released
+        void wake_producer(uint64_t tail) noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the one in shm_producer::has_room()
+            if (_hdr->space_waiters.load(std::memory_order_relaxed) == 0) return;
+            if (_hdr->head.load(std::memory_order_relaxed) - tail > _capacity / 2) return;
+            _hdr->space_seq.fetch_add(1);
+            shm_futex::wake(_hdr->space_seq);
+        }
+
+        void attach(int fd) {
+            shm_ring_info h;
+            struct stat st;
+            if (pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) return;
+            if (h.magic != shm_ring_info::magic_value || h.version != shm_ring_info::version_value ||
+                h.char_size != sizeof(char_type) || h.end_code != static_cast<uint8_t>(DECODER::end_code()) ||
+                h.esc_code != static_cast<uint8_t>(DECODER::esc_code()) || h.capacity < 2 ||
+                (h.capacity & (h.capacity - 1)))
+                return;
+            size_t data_at = shm_ring_layout::data_offset(h.max_consumers);
+            _data_bytes    = h.capacity * sizeof(char_type);
+            if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < data_at + _data_bytes) return;
+
+            void* p = mmap(nullptr, data_at, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) return;
+            _map      = static_cast<uint8_t*>(p);
+            _map_size = data_at;
+            p         = mmap(nullptr, _data_bytes, PROT_READ, MAP_SHARED, fd, data_at); // consumers cannot scribble on frames
+            if (p == MAP_FAILED) return;
+            _data     = static_cast<const char_type*>(p);
+            _hdr      = reinterpret_cast<shm_ring_header*>(_map);
+            _capacity = h.capacity;
+            _mask     = h.capacity - 1;
+
+            shm_consumer_slot* slots = reinterpret_cast<shm_consumer_slot*>(_map + shm_ring_layout::slots_offset());
+            for (uint32_t i = 0; i < h.max_consumers; i++) {
+                uint32_t expected = shm_consumer_slot::vacant;
+                if (!slots[i].state.compare_exchange_strong(expected, shm_consumer_slot::joining)) continue;
+                // the producer ignores a joining slot. Whatever it writes meanwhile is past
+                // the head it had, so a tail at a head read after going active is safe.
+                slots[i].tail.store(_hdr->head.load());
+                slots[i].pid.store(getpid());
+                slots[i].state.store(shm_consumer_slot::active);
+                _pos = _hdr->head.load();
+                slots[i].tail.store(_pos);
+                _slot = slots + i;
+                return;
+            }
+        }
+
+        static const char_type* find_end(const char_type* p, size_t n) noexcept {
+            if (sizeof(char_type) == 1)
+                return static_cast<const char_type*>(memchr(p, static_cast<uint8_t>(DECODER::end_code()), n));
+            for (const char_type* e = p + n; p < e; p++)
+                if (*p == DECODER::end_code()) return p;
+            return nullptr;
+        }
+
+        uint8_t* _map              = nullptr;
+        size_t _map_size           = 0;
+        const char_type* _data     = nullptr;
+        size_t _data_bytes         = 0;
+        shm_ring_header* _hdr      = nullptr;
+        shm_consumer_slot* _slot   = nullptr;
+        uint64_t _capacity         = 0;
+        uint64_t _mask             = 0;
+        uint64_t _pos              = 0;
+        uint64_t _frames           = 0;
+    };
+
+}
+
+    #endif // __linux__
+
+#endif // __SLIPSHM_H__
@@ -0,0 +1,198 @@
+/*!
+ *  @file SlipStats.h
+ *
+ *  Statistics policies for encoder_base and decoder_base: frames, payload
+ *  bytes, escapes by kind, decode errors by reason and frames without END.
+ */
+
+#pragma once
+
+#ifndef __SLIPSTATS_H__
+    #define __SLIPSTATS_H__
+
+    #include "SlipInPlace.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * Counters
+     **************************************************************************************/
+
+    /* Why a decode failed. Indexes codec_counters::decode_errors. */
+    enum class decode_error : uint8_t {
+        bad_escape       = 0, ///< ESC followed by a character that is not an escaped code
+        truncated_escape = 1, ///< ESC as the last character of the input
+        overflow         = 2, ///< dest too small for the decoded frame
+    };
+
+    /** @brief Counters kept by a counting policy. A plain struct: copy it to take a snapshot. */
+    struct codec_counters {
+        size_t encoded_frames     = 0;  ///< frames encoded
+        size_t encoded_bytes      = 0;  ///< payload characters encoded
+        size_t encoded_escapes[3] = {}; ///< escapes written, by special character: END, ESC, NULL
+        size_t encode_overflows   = 0;  ///< encodes that failed for lack of room
+        size_t decoded_frames     = 0;  ///< frames decoded
+        size_t decoded_bytes      = 0;  ///< payload characters decoded
+        size_t decoded_escapes[3] = {}; ///< escapes read, by special character: END, ESC, NULL
+        size_t unterminated       = 0;  ///< frames decoded up to the end of the input, with no END
+        size_t decode_errors[3]   = {}; ///< failed decodes, by decode_error
+
+        /** Add other's counts, for example to total per-thread snapshots. */
+        codec_counters& operator+=(const codec_counters& other) noexcept {
+            encoded_frames += other.encoded_frames;
+            encoded_bytes += other.encoded_bytes;
+            encode_overflows += other.encode_overflows;
+            decoded_frames += other.decoded_frames;
+            decoded_bytes += other.decoded_bytes;
+            unterminated += other.unterminated;
+            for (int i = 0; i < 3; i++) {
+                encoded_escapes[i] += other.encoded_escapes[i];
+                decoded_escapes[i] += other.decoded_escapes[i];
+                decode_errors[i] += other.decode_errors[i];
+            }
+            return *this;
+        }
+
+        size_t errors(decode_error e) const noexcept { return decode_errors[static_cast<int>(e)]; }
+    };
+
+    /**************************************************************************************
+     * Counting policies
+     **************************************************************************************/
+
+    /**
+     * @brief Statistics policy that counts into STORE::counters().
+     *
+     * Each hook scans the frame once before the codec runs, mirroring the
+     * checks encode and decode make. That works the same for the scalar codec
+     * and the vector kernels, and for in-place coding that overwrites src.
+     * The price is one extra scalar pass over each frame while counting.
+     *
+     * @tparam STORE    provides static codec_counters& counters()
+     */
+    template <class STORE>
+    struct counting_policy {
+        static constexpr bool enabled = true;
+
+        /** Counters of this policy. See STORE for their scope. */
+        static codec_counters snapshot() noexcept { return STORE::counters(); }
+        static void reset() noexcept { STORE::counters() = codec_counters(); }
+
+        template <class CODEC, typename _CharT>
+        static void encoding(const _CharT* src, size_t srcsize, size_t destsize) noexcept {
+            if (!src) return;
+            size_t nescapes[3] = {};
+            for (const _CharT* send = src + srcsize; src < send; src++) {
+                int isp = special_index<CODEC>(*src);
+                if (isp >= 0) nescapes[isp]++;
+            }
+            codec_counters& c = STORE::counters();
+            if (destsize < srcsize + nescapes[0] + nescapes[1] + nescapes[2] + 1) {
+                c.encode_overflows++;
+                return;
+            }
+            c.encoded_frames++;
+            c.encoded_bytes += srcsize;
+            for (int i = 0; i < 3; i++) c.encoded_escapes[i] += nescapes[i];
+        }
+
+        template <class CODEC, typename _CharT>
+        static void decoding(const _CharT* src, size_t srcsize, size_t destsize) noexcept {
+            if (!src || srcsize < 1) return;
+            codec_counters& c     = STORE::counters();
+            const _CharT* send    = src + srcsize;
+            size_t n              = 0;
+            size_t nescapes[3]    = {};
+            bool ended            = false;
+            int error             = destsize < 1 ? static_cast<int>(decode_error::overflow) : -1;
+            while (error < 0 && src < send) {
+                if (*src == CODEC::end_code()) {
+                    ended = true;
+                    break;
+                }
+                if (*src == CODEC::esc_code()) {
+                    if (++src >= send) {
+                        error = static_cast<int>(decode_error::truncated_escape);
+                        break;
+                    }
+                    int isp = escaped_index<CODEC>(*src);
+                    if (n >= destsize) {
+                        error = static_cast<int>(decode_error::overflow);
+                    } else if (isp < 0) {
+                        error = static_cast<int>(decode_error::bad_escape);
+                    } else {
+                        nescapes[isp]++;
+                    }
+                } else if (n >= destsize) {
+                    error = static_cast<int>(decode_error::overflow);
+                }
+                src++;
+                n++;
+            }
+            if (error >= 0) {
+                c.decode_errors[error]++;
+                return;
+            }
+            c.decoded_frames++;
+            c.decoded_bytes += n;
+            if (!ended) c.unterminated++;
+            for (int i = 0; i < 3; i++) c.decoded_escapes[i] += nescapes[i];
+        }
+
+     protected:
+        template <class CODEC, typename _CharT>
+        static int special_index(_CharT c) noexcept {
+            for (int i = 0; i < CODEC::num_specials; i++) {
+                if (c == CODEC::special_codes()[i]) return i;
+            }
+            return -1;
+        }
+        template <class CODEC, typename _CharT>
+        static int escaped_index(_CharT c) noexcept {
+            for (int i = 0; i < CODEC::num_specials; i++) {
+                if (c == CODEC::escaped_codes()[i]) return i;
+            }
+            return -1;
+        }
+    };
+
+    /**
+     * @brief One set of counters per Tag, shared by every codec that names it.
+     *
+     * Use a tag per link, with the same tag for that link's encoder and decoder.
+     * The counters are not synchronised: keep each tag on one thread.
+     *
+     * ```c++
+     * struct radio;
+     * using rx = slip::slip_decoder_base<uint8_t, slip::counting_stats<radio>>;
+     * rx::decode(buf, n, buf, n);
+     * slip::codec_counters c = slip::counting_stats<radio>::snapshot();
+     * ```
+     */
+    template <class Tag = void>
+    struct counting_stats : public counting_policy<counting_stats<Tag>> {
+        static codec_counters& counters() noexcept {
+            static codec_counters c;
+            return c;
+        }
+    };
+
+    #ifndef __AVR__
+    /**
+     * @brief Counters per Tag and per thread.
+     *
+     * snapshot() returns the calling thread's counters. Each thread can send
+     * its snapshot somewhere to be totalled with codec_counters::operator+=.
+     */
+    template <class Tag = void>
+    struct thread_stats : public counting_policy<thread_stats<Tag>> {
+        static codec_counters& counters() noexcept {
+            static thread_local codec_counters c;
+            return c;
+        }
+    };
+    #endif
+
+}
+
+#endif // __SLIPSTATS_H__
@@ -0,0 +1,320 @@
+/*!
+ *  @file SlipStream.h
+ *
+ *  Encode and decode SLIP streams that arrive and leave in arbitrary chunks,
+ *  such as reads from a pipe or a file, where frames span chunk boundaries.
+ */
+
+#pragma once
+
+#ifndef __SLIPSTREAM_H__
+    #define __SLIPSTREAM_H__
+
+    #include "SlipInPlace.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * Stream encoder
+     **************************************************************************************/
+
+    /**
+     * @brief Encodes frames given a piece at a time.
+     *
+     * Each piece is escaped with ENCODER::encode, so the vector kernels apply
+     * when ENCODER is dispatched. end() closes the frame.
+     *
+     * @tparam ENCODER  the encoder_base type to use
+     */
+    template <class ENCODER = encoder>
+    class stream_encoder {
+     public:
+        using char_type = typename ENCODER::char_type;
+
+        /** Largest encoded size of a piece of n characters, without END. */
+        static constexpr size_t max_encoded_size(size_t n) noexcept { return 2 * n; }
+
+        /**
+         * @brief Escape the next piece of the current frame.
+         * @param dest      destination, room for at least max_encoded_size(srcsize) + 1 characters
+         * @return size_t   characters written to dest
+         */
+        size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            if (srcsize == 0) return 0;
+            size_t esize = ENCODER::encode(dest, destsize, src, srcsize);
+            if (esize == 0) return 0;
+            _open = true;
+            return esize - 1; // drop the END
+        }
+
+        /**
+         * @brief Close the current frame.
+         * @return size_t   characters written to dest (always 1)
+         */
+        size_t end(char_type* dest) noexcept {
+            *dest = ENCODER::end_code();
+            _open = false;
+            _frames++;
+            return 1;
+        }
+
+        bool in_frame() const noexcept { return _open; }     ///< a piece was encoded since the last end()
+        uint64_t frames() const noexcept { return _frames; } ///< frames closed so far
+
+     private:
+        bool _open       = false;
+        uint64_t _frames = 0;
+    };
+
+    /**************************************************************************************
+     * Stream decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Decodes an encoded stream a chunk at a time.
+     *
+     * Chunks are cut at END characters and each piece is decoded with
+     * DECODER::decode, so the vector kernels apply when DECODER is dispatched.
+     * An escape split across two chunks is held back until the next one.
+     *
+     * The decoded size of a chunk is never larger than the chunk, so dest may be
+     * the chunk itself. A frame with a bad escape is dropped from the escape up
+     * to its END and counted in errors(). What was decoded of it before the
+     * escape has already been returned. Empty frames (END after END) are skipped.
+     *
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <class DECODER = decoder>
+    class stream_decoder {
+     public:
+        using char_type = typename DECODER::char_type;
+
+        /** @brief Decode the next chunk. Frame ends are not marked in dest. */
+        size_t decode(char_type* dest, const char_type* src, size_t srcsize) noexcept {
+            return decode(dest, src, srcsize, [](char_type*) { return size_t(0); });
+        }
+
+        /**
+         * @brief Decode the next chunk.
+         *
+         * @param dest      destination, room for srcsize characters. May be src.
+         * @param on_end    called as `size_t on_end(char_type* at)` at the end of each
+         *                  frame, at the position in dest after its last character. It
+         *                  may write one character there, such as a delimiter, and
+         *                  returns how many it wrote (0 or 1).
+         * @return size_t   characters written to dest
+         */
+        template <typename _Fn>
+        size_t decode(char_type* dest, const char_type* src, size_t srcsize, _Fn on_end) noexcept {
+            return decode(dest, src, srcsize, on_end, [](char_type*) {});
+        }
+
+        /**
+         * @brief Decode the next chunk, and be told where dropped frames end.
+         *
+         * For callers that keep frames in dest across chunks: on_drop(at) is called
+         * instead of on_end when a frame with a bad escape ends, so the caller can
+         * discard dest up to at.
+         */
+        template <typename _Fn, typename _DropFn>
+        size_t decode(char_type* dest, const char_type* src, size_t srcsize, _Fn on_end, _DropFn on_drop) noexcept {
+            char_type* dstart     = dest;
+            const char_type* send = src + srcsize;
+            if (_held && src < send) { // the escape held back from the last chunk
+                _held = false;
+                if (*src == DECODER::end_code()) {
+                    _bad = true; // truncated escape: fall through to END handling below
+                } else {
+                    const char_type seq[2] = {DECODER::esc_code(), *src++};
+                    if (DECODER::decode(dest, 1, seq, 2) == 1) {
+                        dest++;
+                        _size++;
+                    } else {
+                        _bad = true;
+                    }
+                }
+            }
+            while (src < send) {
+                const char_type* e = find_end(src, send - src);
+                const char_type* stop = e ? e : send;
+                if (!_bad && stop > src) {
+                    size_t n = stop - src;
+                    if (!e && stop[-1] == DECODER::esc_code()) { // escape split across chunks
+                        _held = true;
+                        n--;
+                    }
+                    size_t d = n ? DECODER::decode(dest, n, src, n) : 0;
+                    if (n && d == 0) {
+                        _bad  = true;
+                        _held = false;
+                    }
+                    dest += d;
+                    _size += d;
+                    if (_held) _size++; // the frame is not empty, whatever the escape turns out to be
+                }
+                if (!e) break;
+                dest += close(dest, on_end, on_drop);
+                src = e + 1;
+            }
+            return dest - dstart;
+        }
+
+        /**
+         * @brief End of the stream: close a last frame that has no END.
+         * @return size_t   characters written to dest by on_end
+         */
+        template <typename _Fn>
+        size_t finish(char_type* dest, _Fn on_end) noexcept {
+            return finish(dest, on_end, [](char_type*) {});
+        }
+
+        /** @copydoc finish */
+        template <typename _Fn, typename _DropFn>
+        size_t finish(char_type* dest, _Fn on_end, _DropFn on_drop) noexcept {
+            if (_held) {
+                _held = false;
+                _bad  = true;
+            }
+            return close(dest, on_end, on_drop);
+        }
+
+        /** @copydoc finish */
+        size_t finish(char_type* dest) noexcept {
+            return finish(dest, [](char_type*) { return size_t(0); });
+        }
+
+        uint64_t frames() const noexcept { return _frames; } ///< good frames so far
+        uint64_t errors() const noexcept { return _errors; } ///< frames dropped for bad escapes
+
+     private:
+        template <typename _Fn, typename _DropFn>
+        size_t close(char_type* dest, _Fn& on_end, _DropFn& on_drop) noexcept {
+            size_t n = 0;
+            if (_bad) {
+                _errors++;
+                on_drop(dest);
+            } else if (_size) {
+                _frames++;
+                n = on_end(dest);
+            }
+            _bad  = false;
+            _size = 0;
+            return n;
+        }
+
+        static const char_type* find_end(const char_type* p, size_t n) noexcept {
+            if (sizeof(char_type) == 1)
+                return static_cast<const char_type*>(memchr(p, static_cast<uint8_t>(DECODER::end_code()), n));
+            for (const char_type* e = p + n; p < e; p++)
+                if (*p == DECODER::end_code()) return p;
+            return nullptr;
+        }
+
+        bool _held       = false; // chunk ended on an escape
+        bool _bad        = false; // dropping the rest of the current frame
+        size_t _size     = 0;     // characters decoded in the current frame
+        uint64_t _frames = 0;
+        uint64_t _errors = 0;
+    };
+
+
+    /**************************************************************************************
+     * Stream receive buffer
+     **************************************************************************************/
+
+    /**
+     * @brief Receive buffer of one stream that hands out whole frames in place.
+     *
+     * Reads go to space(), right after the decoded part of the unfinished
+     * frame, and received() decodes them in place with a stream_decoder. Every
+     * complete frame is then contiguous in the buffer and is handed out by
+     * pointer. Frames stay valid until the next prepare(), which moves the
+     * unfinished frame to the front. A frame larger than the buffer is dropped
+     * and counted in oversized().
+     *
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <class DECODER = decoder>
+    class stream_buffer {
+     public:
+        using char_type = typename DECODER::char_type;
+
+        /** Receive into buf, which must outlive the stream_buffer. */
+        stream_buffer(char_type* buf, size_t size) noexcept : _buf(buf), _size(size) {}
+
+        /** Make room for the next read. Invalidates the frames handed out so far. */
+        void prepare() noexcept {
+            if (_start) {
+                memmove(_buf, _buf + _start, (_end - _start) * sizeof(char_type));
+                _end -= _start;
+                _start = 0;
+            }
+            if (_end == _size) { // no END in a whole buffer
+                if (!_skipping) _oversized++;
+                _skipping = true;
+                _end      = 0;
+            }
+        }
+
+        char_type* space() noexcept { return _buf + _end; } ///< where to read to
+        size_t room() const noexcept { return _size - _end; } ///< characters that fit at space()
+
+        /**
+         * @brief Decode n characters that were read to space().
+         * @param deliver   called as deliver(const char_type* frame, size_t size) for each complete frame
+         */
+        template <typename _Fn>
+        void received(size_t n, _Fn deliver) noexcept {
+            char_type* data = space();
+            _end += _decoder.decode(data, data, n, ender(deliver), dropper());
+        }
+
+        /** End of the stream: deliver a last frame that has no END. */
+        template <typename _Fn>
+        void finish(_Fn deliver) noexcept {
+            _decoder.finish(space(), ender(deliver), dropper());
+        }
+
+        uint64_t frames() const noexcept { return _decoder.frames(); } ///< good frames so far
+        uint64_t errors() const noexcept { return _decoder.errors(); } ///< frames dropped for bad escapes
+        uint64_t oversized() const noexcept { return _oversized; }     ///< frames larger than the buffer
+
+     private:
+        template <typename _Fn>
+        struct end_fn {
+            stream_buffer* self;
+            _Fn& deliver;
+            size_t operator()(char_type* at) {
+                size_t end = at - self->_buf;
+                if (self->_skipping) {
+                    self->_skipping = false; // the rest of an oversized frame
+                } else {
+                    deliver(static_cast<const char_type*>(self->_buf + self->_start), end - self->_start);
+                }
+                self->_start = end;
+                return 0;
+            }
+        };
+        struct drop_fn {
+            stream_buffer* self;
+            void operator()(char_type* at) {
+                self->_skipping = false;
+                self->_start    = at - self->_buf;
+            }
+        };
+        template <typename _Fn>
+        end_fn<_Fn> ender(_Fn& deliver) noexcept { return {this, deliver}; }
+        drop_fn dropper() noexcept { return {this}; }
+
+        char_type* _buf;
+        size_t _size;
+        size_t _start       = 0;     // where the unfinished frame starts
+        size_t _end         = 0;     // end of the decoded characters
+        bool _skipping      = false; // dropping a frame larger than the buffer
+        uint64_t _oversized = 0;
+        stream_decoder<DECODER> _decoder;
+    };
+
+}
+
+#endif // __SLIPSTREAM_H__
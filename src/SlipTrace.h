@@ -0,0 +1,335 @@
+/*!
+ *  @file SlipTrace.h
+ *
+ *  Frame latency tracing for spsc_ring: timestamps when characters arrive,
+ *  when a frame's END is found and when the frame is delivered, and reports
+ *  the latencies between them as histograms and percentiles.
+ *
+ *  Host only: needs threads, <mutex> and containers.
+ */
+
+#pragma once
+
+#ifndef __SLIPTRACE_H__
+    #define __SLIPTRACE_H__
+
+    #include "SlipRing.h"
+    #include <algorithm>
+    #include <atomic>
+    #include <chrono>
+    #include <functional>
+    #include <iomanip>
+    #include <memory>
+    #include <mutex>
+    #include <ostream>
+    #include <string>
+    #include <vector>
+    #if defined(__x86_64__) || defined(__i386__)
+        #include <x86intrin.h>
+    #else
+        #include <time.h>
+    #endif
+
+    /**
+     * @brief Events kept per thread and tracer tag, a power of two.
+     *
+     * Once a thread has recorded more than this, its oldest events are
+     * overwritten.
+     */
+    #ifndef SLIP_TRACE_EVENTS
+        #define SLIP_TRACE_EVENTS 16384
+    #endif
+
+namespace slip {
+
+    /**************************************************************************************
+     * Clock
+     **************************************************************************************/
+
+    /**
+     * @brief The cheapest monotonic clock on the host: the TSC on x86,
+     * otherwise clock_gettime(CLOCK_MONOTONIC).
+     */
+    struct trace_clock {
+        static __ALWAYS_INLINE__ uint64_t now() noexcept {
+    #if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+    #else
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + ts.tv_nsec;
+    #endif
+        }
+
+        /** Nanoseconds per tick of now(). Measured against steady_clock on first use. */
+        static double ns_per_tick() noexcept {
+    #if defined(__x86_64__) || defined(__i386__)
+            static const double ns = [] {
+                using clock = std::chrono::steady_clock;
+                auto t0     = clock::now();
+                uint64_t c0 = now();
+                while (clock::now() - t0 < std::chrono::milliseconds(10)) {
+                }
+                uint64_t c1 = now();
+                return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / (c1 - c0);
+            }();
+            return ns;
+    #else
+            return 1.0;
+    #endif
+        }
+    };
+
+    /**************************************************************************************
+     * Trace events
+     **************************************************************************************/
+
+    /** What a trace_event records. */
+    enum class trace_kind : uint8_t {
+        arrived,   ///< characters up to pos arrived
+        end_found, ///< the END just before pos was found
+        delivered, ///< the frame ending just before pos was returned
+    };
+
+    struct trace_event {
+        uint64_t ticks;     ///< trace_clock::now()
+        uint64_t pos;       ///< ring index
+        const void* source; ///< the ring
+        trace_kind kind;
+    };
+
+    /**
+     * @brief Events recorded by one thread. Only that thread writes; other
+     * threads may copy it at any time.
+     */
+    class trace_buffer {
+     public:
+        static constexpr size_t capacity = SLIP_TRACE_EVENTS;
+        static_assert((capacity & (capacity - 1)) == 0, "SLIP_TRACE_EVENTS must be a power of two");
+
+        __ALWAYS_INLINE__ void record(trace_kind kind, const void* source, size_t pos) noexcept {
+            size_t head    = _head.load(std::memory_order_relaxed);
+            trace_event& e = _events[head & (capacity - 1)];
+            e.ticks        = trace_clock::now();
+            e.pos          = pos;
+            e.source       = source;
+            e.kind         = kind;
+            _head.store(head + 1, std::memory_order_release);
+        }
+
+        /**
+         * Append the events still held to out. Events overwritten while copying,
+         * and the one a record() in progress may be writing, are left out.
+         */
+        void copy_to(std::vector<trace_event>& out) const {
+            size_t head  = _head.load(std::memory_order_acquire);
+            size_t first = std::max(head, capacity) - capacity;
+            size_t at    = out.size();
+            for (size_t i = first; i < head; i++) out.push_back(_events[i & (capacity - 1)]);
+            std::atomic_thread_fence(std::memory_order_acquire); // the copies above before the load below
+            size_t intact = std::max(_head.load(std::memory_order_relaxed) + 1, capacity) - capacity;
+            if (intact > first) out.erase(out.begin() + at, out.begin() + at + (std::min(intact, head) - first));
+        }
+
+     private:
+        std::atomic<size_t> _head{0};
+        trace_event _events[capacity];
+    };
+
+    /**************************************************************************************
+     * Latency report
+     **************************************************************************************/
+
+    /** @brief Distribution of one latency, in nanoseconds. */
+    struct latency_stats {
+        static constexpr int num_buckets = 40;
+
+        size_t count = 0;
+        double min = 0, p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0, mean = 0;
+        size_t histogram[num_buckets] = {}; ///< bucket b: [2^b, 2^(b+1)) ns, bucket 0 also holds 0
+
+        /** Fill in from the samples, sorting them. */
+        void set(std::vector<double>& ns) {
+            count = ns.size();
+            if (!count) return;
+            std::sort(ns.begin(), ns.end());
+            auto rank = [&](double p) { return ns[std::min(count - 1, static_cast<size_t>(p * count))]; };
+            min = ns.front();
+            max = ns.back();
+            p50 = rank(0.50), p90 = rank(0.90), p99 = rank(0.99), p999 = rank(0.999);
+            double sum = 0;
+            for (double v : ns) {
+                sum += v;
+                int b = 0;
+                while (b + 1 < num_buckets && v >= static_cast<double>(2ull << b)) b++;
+                histogram[b]++;
+            }
+            mean = sum / count;
+        }
+    };
+
+    /**
+     * @brief Per-frame latencies from a set of trace events.
+     *
+     * Each delivered frame is matched to the arrival that brought its END: the
+     * first arrival of the same ring reaching past the END. Frames whose arrival
+     * or END event was overwritten are not counted. An arrival is only trusted
+     * when the arrival before it was seen too, and reached the END of the frame
+     * before, so the first arrival of each ring is never used.
+     */
+    struct latency_report {
+        latency_stats arrival_to_end;      ///< last character arrived to END found
+        latency_stats end_to_delivery;     ///< END found to frame returned
+        latency_stats arrival_to_delivery; ///< last character arrived to frame returned
+
+        latency_report() = default;
+
+        latency_report(const std::vector<trace_event>& events, double ns_per_tick = trace_clock::ns_per_tick()) {
+            struct mark {
+                const void* source;
+                uint64_t pos;
+                uint64_t ticks;
+                bool operator<(const mark& o) const noexcept {
+                    return source != o.source ? std::less<const void*>()(source, o.source) : pos < o.pos;
+                }
+            };
+            std::vector<mark> arrivals, ends;
+            for (const trace_event& e : events) {
+                if (e.kind == trace_kind::arrived) arrivals.push_back({e.source, e.pos, e.ticks});
+                if (e.kind == trace_kind::end_found) ends.push_back({e.source, e.pos, e.ticks});
+            }
+            std::sort(arrivals.begin(), arrivals.end());
+            std::sort(ends.begin(), ends.end());
+            std::vector<double> a2e, e2d, a2d;
+            for (const trace_event& e : events) {
+                if (e.kind != trace_kind::delivered) continue;
+                mark m{e.source, e.pos, 0};
+                auto a = std::lower_bound(arrivals.begin(), arrivals.end(), m);
+                auto f = std::lower_bound(ends.begin(), ends.end(), m);
+                if (a == arrivals.end() || a->source != e.source) continue;
+                if (f == ends.end() || f->source != e.source || f->pos != e.pos) continue;
+                if (a->ticks > f->ticks) continue; // a later arrival: the real one was overwritten
+                // the arrival before a must be seen, or a may follow overwritten ones
+                if (a == arrivals.begin() || std::prev(a)->source != e.source) continue;
+                if (f != ends.begin() && std::prev(f)->source == e.source && std::prev(a)->pos < std::prev(f)->pos) continue;
+                a2e.push_back(elapsed(a->ticks, f->ticks) * ns_per_tick);
+                e2d.push_back(elapsed(f->ticks, e.ticks) * ns_per_tick);
+                a2d.push_back(elapsed(a->ticks, e.ticks) * ns_per_tick);
+            }
+            arrival_to_end.set(a2e);
+            end_to_delivery.set(e2d);
+            arrival_to_delivery.set(a2d);
+        }
+
+        /** Print percentiles and a histogram of each latency. */
+        void print(std::ostream& os) const {
+            print(os, "arrival -> END", arrival_to_end);
+            print(os, "END -> delivery", end_to_delivery);
+            print(os, "arrival -> delivery", arrival_to_delivery);
+        }
+
+     private:
+        // counters on different cores can be a few ticks apart
+        static double elapsed(uint64_t from, uint64_t to) noexcept { return to > from ? double(to - from) : 0.0; }
+
+        static void print(std::ostream& os, const char* name, const latency_stats& s) {
+            os << name << ": " << s.count << " frames";
+            if (!s.count) {
+                os << "\n\n";
+                return;
+            }
+            std::ios_base::fmtflags flags = os.flags();
+            std::streamsize precision     = os.precision();
+            os << std::fixed << std::setprecision(0);
+            os << ", ns min " << s.min << " p50 " << s.p50 << " p90 " << s.p90 << " p99 " << s.p99 << " p99.9 "
+               << s.p999 << " max " << s.max << " mean " << s.mean << "\n";
+            size_t most = *std::max_element(s.histogram, s.histogram + latency_stats::num_buckets);
+            for (int b = 0; b < latency_stats::num_buckets; b++) {
+                if (!s.histogram[b]) continue;
+                os << "  < " << (2ull << b) << " ns\t" << s.histogram[b] << "\t"
+                   << std::string(1 + s.histogram[b] * 50 / most, '#') << "\n";
+            }
+            os << "\n";
+            os.flags(flags);
+            os.precision(precision);
+        }
+    };
+
+    /**************************************************************************************
+     * Tracer
+     **************************************************************************************/
+
+    /**
+     * @brief spsc_ring tracer that records every event with trace_clock in a
+     * buffer per thread.
+     *
+     * Recording is a clock read and four stores into the calling thread's
+     * buffer, with no locks or shared writes. A thread's first event registers
+     * its buffer, under a lock, once. Buffers outlive their threads so that
+     * report() still sees their events.
+     *
+     * ```c++
+     * struct rx_link;
+     * slip::spsc_ring<4096, slip::decoder, slip::frame_tracer<rx_link>> ring;
+     * ...
+     * slip::frame_tracer<rx_link>::report().print(std::cout);
+     * ```
+     *
+     * @tparam Tag      separates the events of different links
+     */
+    template <class Tag = void>
+    class frame_tracer {
+     public:
+        static __ALWAYS_INLINE__ void arrived(const void* source, size_t pos) noexcept {
+            buffer().record(trace_kind::arrived, source, pos);
+        }
+        static __ALWAYS_INLINE__ void end_found(const void* source, size_t pos) noexcept {
+            buffer().record(trace_kind::end_found, source, pos);
+        }
+        static __ALWAYS_INLINE__ void delivered(const void* source, size_t pos) noexcept {
+            buffer().record(trace_kind::delivered, source, pos);
+        }
+
+        /** Events recorded by all threads since the last clear(). */
+        static std::vector<trace_event> events() {
+            std::vector<trace_event> out;
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            for (auto& b : registry().buffers) b->copy_to(out);
+            uint64_t after = registry().cleared_at.load(std::memory_order_relaxed);
+            out.erase(std::remove_if(out.begin(), out.end(), [after](const trace_event& e) { return e.ticks < after; }),
+                      out.end());
+            return out;
+        }
+
+        /** Latencies of the frames in events(). */
+        static latency_report report() { return latency_report(events()); }
+
+        /** Leave out the events recorded so far, for example before tracing a new ring. */
+        static void clear() noexcept { registry().cleared_at.store(trace_clock::now(), std::memory_order_relaxed); }
+
+     private:
+        struct buffers {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<trace_buffer>> buffers;
+            std::atomic<uint64_t> cleared_at{0};
+        };
+
+        static buffers& registry() {
+            static buffers r;
+            return r;
+        }
+
+        static trace_buffer& buffer() noexcept {
+            static thread_local trace_buffer* mine = nullptr;
+            if (!mine) {
+                std::lock_guard<std::mutex> lock(registry().mutex);
+                registry().buffers.emplace_back(new trace_buffer());
+                mine = registry().buffers.back().get();
+            }
+            return *mine;
+        }
+    };
+
+}
+
+#endif // __SLIPTRACE_H__
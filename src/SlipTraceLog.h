@@ -0,0 +1,485 @@
+/*!
+ *  @file SlipTraceLog.h
+ *
+ *  Frame trace logging for production debugging: codecs hand each frame to a
+ *  lock-free ring, and a background thread writes them to a binary trace file.
+ *  Includes the reader for those files.
+ *
+ *  Host only: needs threads and stdio.
+ */
+
+#pragma once
+
+#ifndef __SLIPTRACELOG_H__
+    #define __SLIPTRACELOG_H__
+
+    #include "SlipInPlace.h"
+    #include "SlipUtils.h"
+    #include <algorithm>
+    #include <atomic>
+    #include <chrono>
+    #include <memory>
+    #include <mutex>
+    #include <new>
+    #include <stdio.h>
+    #include <string>
+    #include <thread>
+    #include <time.h>
+    #include <vector>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Trace records
+     **************************************************************************************/
+
+    /** Which way a logged frame was going. */
+    enum class trace_direction : uint8_t { rx = 0, tx = 1 };
+
+    /** @brief One logged frame, as read back from a trace file. */
+    struct trace_record {
+        uint64_t ns = 0;                             ///< wall-clock time of logging, ns since the Unix epoch
+        uint16_t link = 0;                           ///< link id given to the logger
+        trace_direction direction = trace_direction::rx;
+        uint32_t size = 0;                           ///< frame size when logged
+        std::string data;                            ///< frame bytes, the first max_frame of them if truncated
+
+        bool truncated() const noexcept { return data.size() < size; }
+    };
+
+    /**
+     * @brief Layout of trace files.
+     *
+     * An 8-character magic, then one record after another. Each record is a
+     * 20-character little-endian header (u64 ns, u16 link, u8 direction,
+     * u8 reserved, u32 frame size, u32 stored size) and the stored bytes.
+     */
+    struct trace_file {
+        static constexpr size_t header_size = 20;
+
+        static const char* magic() noexcept { return "SLIPTRC1"; }
+
+        static void put(uint8_t* p, uint64_t v, int n) noexcept {
+            for (int i = 0; i < n; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+        }
+        static uint64_t get(const uint8_t* p, int n) noexcept {
+            uint64_t v = 0;
+            for (int i = n - 1; i >= 0; i--) v = (v << 8) | p[i];
+            return v;
+        }
+    };
+
+    /**************************************************************************************
+     * Logger
+     **************************************************************************************/
+
+    /** What log() does when the ring is full. */
+    enum class trace_overflow : uint8_t {
+        drop, ///< drop the new frame and count it: never stalls the caller
+        wait, ///< yield until the writer thread frees a slot
+    };
+
+    /**
+     * @brief Asynchronous frame logger.
+     *
+     * log() copies the frame into a preallocated ring of fixed-size slots, which
+     * any number of threads may fill at once without locks (a bounded MPSC queue
+     * with a sequence number per slot). A background thread started by start()
+     * writes the slots to the trace file in the order they were claimed. Frames
+     * longer than max_frame are truncated, keeping their full size in the record.
+     * On destruction the logger detaches itself from the logging codecs it was
+     * attached to, waiting for their calls in progress, before it stops.
+     *
+     * ```c++
+     * slip::trace_logger log(fopen("link.trace", "wb"));
+     * log.start();
+     * log.log(slip::trace_direction::rx, 1, frame, size);
+     * ```
+     */
+    class trace_logger {
+     public:
+        /**
+         * @param file      open for binary writing. Not closed by the logger.
+         * @param slots     frames the ring holds, rounded up to a power of two
+         * @param max_frame characters kept of each frame
+         * @param overflow  what log() does when the ring is full
+         */
+        explicit trace_logger(FILE* file, size_t slots = 1024, size_t max_frame = 512,
+                              trace_overflow overflow = trace_overflow::drop)
+            : _file(file), _max_frame(max_frame), _overflow(overflow) {
+            size_t n = 2;
+            while (n < slots) n <<= 1;
+            _mask   = n - 1;
+            _stride = (sizeof(slot) + max_frame + alignof(slot) - 1) / alignof(slot) * alignof(slot);
+            _storage.reset(new uint8_t[n * _stride + alignof(slot)]);
+            _slots = _storage.get() + (alignof(slot) - reinterpret_cast<uintptr_t>(_storage.get()) % alignof(slot));
+            for (size_t i = 0; i < n; i++) new (_slots + i * _stride) slot{{i}, 0, 0, 0, 0, trace_direction::rx};
+            if (_file) fwrite(trace_file::magic(), 1, 8, _file);
+        }
+
+        ~trace_logger() {
+            std::vector<void (*)(trace_logger*)> hooks;
+            {
+                std::lock_guard<std::mutex> lock(_hooks_mutex);
+                hooks.swap(_hooks);
+            }
+            for (auto detach : hooks) detach(this);
+            stop();
+        }
+
+        trace_logger(const trace_logger&)            = delete;
+        trace_logger& operator=(const trace_logger&) = delete;
+
+        /** Start the writer thread. */
+        void start() {
+            if (_writer.joinable()) return;
+            _stop.store(false, std::memory_order_relaxed);
+            _writer = std::thread([this] { run(); });
+        }
+
+        /** Write what is queued, then stop the writer thread. */
+        void stop() {
+            if (!_writer.joinable()) return;
+            _stop.store(true, std::memory_order_release);
+            _writer.join();
+        }
+
+        /**
+         * @brief Queue a frame for writing. Safe from any thread.
+         *
+         * With trace_overflow::wait this waits for the writer thread, so start() it first.
+         *
+         * @return false if the ring was full and the frame was dropped
+         */
+        bool log(trace_direction direction, uint16_t link, const void* data, size_t size) noexcept {
+            if (!data) size = 0;
+            size_t pos = _enqueue.load(std::memory_order_relaxed);
+            slot* s;
+            for (;;) {
+                s             = &at(pos);
+                size_t seq    = s->seq.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) { // full
+                    if (_overflow == trace_overflow::drop) {
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    std::this_thread::yield();
+                    pos = _enqueue.load(std::memory_order_relaxed);
+                } else {
+                    pos = _enqueue.load(std::memory_order_relaxed);
+                }
+            }
+            s->ns        = now_ns();
+            s->link      = link;
+            s->direction = direction;
+            s->size      = static_cast<uint32_t>(size);
+            s->stored    = static_cast<uint32_t>(size < _max_frame ? size : _max_frame);
+            if (s->stored) memcpy(reinterpret_cast<uint8_t*>(s) + sizeof(slot), data, s->stored);
+            s->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t dropped() const noexcept { return _dropped.load(std::memory_order_relaxed); } ///< frames dropped by log()
+        size_t written() const noexcept { return _written.load(std::memory_order_relaxed); } ///< frames written to the file
+        size_t max_frame() const noexcept { return _max_frame; }
+
+        /** Have detach(this) called from the destructor. Used by trace_hook::attach(). */
+        void on_destroy(void (*detach)(trace_logger*)) {
+            std::lock_guard<std::mutex> lock(_hooks_mutex);
+            if (std::find(_hooks.begin(), _hooks.end(), detach) == _hooks.end()) _hooks.push_back(detach);
+        }
+
+     protected:
+        struct alignas(64) slot {
+            std::atomic<size_t> seq;
+            uint64_t ns;
+            uint32_t size, stored;
+            uint16_t link;
+            trace_direction direction;
+        };
+
+        slot& at(size_t pos) noexcept {
+            return *reinterpret_cast<slot*>(_slots + (pos & _mask) * _stride);
+        }
+
+        static uint64_t now_ns() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
+
+        /** Write every filled slot. @return false if there was none */
+        bool drain() noexcept {
+            bool any = false;
+            for (;;) {
+                slot& s = at(_dequeue);
+                if (s.seq.load(std::memory_order_acquire) != _dequeue + 1) return any;
+                uint8_t h[trace_file::header_size];
+                trace_file::put(h, s.ns, 8);
+                trace_file::put(h + 8, s.link, 2);
+                h[10] = static_cast<uint8_t>(s.direction);
+                h[11] = 0;
+                trace_file::put(h + 12, s.size, 4);
+                trace_file::put(h + 16, s.stored, 4);
+                if (_file) {
+                    fwrite(h, 1, sizeof(h), _file);
+                    fwrite(reinterpret_cast<const uint8_t*>(&s) + sizeof(slot), 1, s.stored, _file);
+                }
+                s.seq.store(_dequeue + _mask + 1, std::memory_order_release);
+                _dequeue++;
+                _written.fetch_add(1, std::memory_order_relaxed);
+                any = true;
+            }
+        }
+
+        void run() noexcept {
+            for (;;) {
+                bool stopping = _stop.load(std::memory_order_acquire);
+                if (drain()) continue;
+                if (_file) fflush(_file);
+                if (stopping) return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        FILE* _file;
+        size_t _max_frame, _mask = 0, _stride = 0;
+        trace_overflow _overflow;
+        std::unique_ptr<uint8_t[]> _storage;
+        uint8_t* _slots = nullptr; // _storage aligned for slot
+        alignas(64) std::atomic<size_t> _enqueue{0};
+        alignas(64) size_t _dequeue = 0;
+        std::atomic<size_t> _written{0};
+        std::atomic<size_t> _dropped{0};
+        std::atomic<bool> _stop{false};
+        std::thread _writer;
+        std::mutex _hooks_mutex;
+        std::vector<void (*)(trace_logger*)> _hooks;
+    };
+
+    /**
+     * @brief The logger a logging codec hands its frames to, one per codec type.
+     *
+     * use() counts its callers in one of two halves, chosen by an epoch. After
+     * attach() swaps the logger it moves the epoch on and waits until the old
+     * half is empty, so no call still holds the old logger when it returns, and
+     * new calls do not hold it up. The logger detaches itself the same way when
+     * destroyed.
+     *
+     * @tparam Owner    the logging codec
+     */
+    template <class Owner>
+    class trace_hook {
+     public:
+        /** Log to logger, or to nothing if it is nullptr. Returns once no call uses the old one. */
+        static void attach(trace_logger* logger, uint16_t link) {
+            std::lock_guard<std::mutex> lock(state().mutex);
+            state().link.store(link, std::memory_order_relaxed);
+            trace_logger* old = state().logger.exchange(logger);
+            if (logger && logger != old) logger->on_destroy(&detach);
+            quiesce();
+        }
+
+        /** Call fn(logger, link) if a logger is attached. */
+        template <typename _Fn>
+        static __ALWAYS_INLINE__ void use(_Fn fn) noexcept {
+            shared& s = state();
+            unsigned e;
+            for (;;) {
+                e = s.epoch.load();
+                s.users[e & 1].fetch_add(1);
+                if (s.epoch.load() == e) break;
+                s.users[e & 1].fetch_sub(1, std::memory_order_release); // attach() moved on: count in the new half
+            }
+            trace_logger* logger = s.logger.load();
+            if (logger) fn(*logger, s.link.load(std::memory_order_relaxed));
+            s.users[e & 1].fetch_sub(1, std::memory_order_release);
+        }
+
+     private:
+        struct shared {
+            std::mutex mutex; // serializes attach()
+            std::atomic<trace_logger*> logger{nullptr};
+            std::atomic<uint16_t> link{0};
+            std::atomic<unsigned> epoch{0};
+            std::atomic<size_t> users[2] = {};
+        };
+
+        static shared& state() noexcept {
+            static shared s;
+            return s;
+        }
+
+        static void detach(trace_logger* logger) {
+            std::lock_guard<std::mutex> lock(state().mutex);
+            trace_logger* expected = logger;
+            if (state().logger.compare_exchange_strong(expected, nullptr)) quiesce();
+        }
+
+        static void quiesce() noexcept {
+            unsigned e = state().epoch.fetch_add(1);
+            while (state().users[e & 1].load(std::memory_order_acquire)) std::this_thread::yield();
+        }
+    };
+
+    /**************************************************************************************
+     * Logging codecs
+     **************************************************************************************/
+
+    /**
+     * @brief ENCODER that hands each encoded frame to a trace_logger.
+     *
+     * Nothing is logged until attach(). Each Tag has its own logger and link id.
+     * A logger may be destroyed while attached: it detaches itself first.
+     *
+     * @tparam ENCODER  the encoder_base type to use
+     * @tparam Tag      separates links that use the same ENCODER
+     */
+    template <class ENCODER = encoder, class Tag = void>
+    struct logged_encoder : public ENCODER {
+        using char_type = typename ENCODER::char_type;
+
+        /**
+         * Log frames to logger, or stop logging if it is nullptr. Returns once no
+         * call on another thread still uses the previous logger.
+         */
+        static void attach(trace_logger* logger, uint16_t link = 0) { hook::attach(logger, link); }
+
+        /** @copydoc encoder_base::encode */
+        static inline size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            size_t esize = ENCODER::encode(dest, destsize, src, srcsize);
+            if (esize) {
+                hook::use([&](trace_logger& logger, uint16_t link) {
+                    logger.log(trace_direction::tx, link, dest, esize * sizeof(char_type));
+                });
+            }
+            return esize;
+        }
+
+        /**
+         * @copydoc encode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return encode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+     protected:
+        using hook = trace_hook<logged_encoder>;
+    };
+
+    /**
+     * @brief DECODER that hands each frame to a trace_logger before decoding it.
+     *
+     * The frame is logged as given, so frames that fail to decode are logged too.
+     *
+     * @tparam DECODER  the decoder_base type to use
+     * @tparam Tag      separates links that use the same DECODER
+     */
+    template <class DECODER = decoder, class Tag = void>
+    struct logged_decoder : public DECODER {
+        using char_type = typename DECODER::char_type;
+
+        /**
+         * Log frames to logger, or stop logging if it is nullptr. Returns once no
+         * call on another thread still uses the previous logger.
+         */
+        static void attach(trace_logger* logger, uint16_t link = 0) { hook::attach(logger, link); }
+
+        /** @copydoc decoder_base::decode */
+        static inline size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            if (src && srcsize) {
+                hook::use([&](trace_logger& logger, uint16_t link) {
+                    logger.log(trace_direction::rx, link, src, srcsize * sizeof(char_type));
+                });
+            }
+            return DECODER::decode(dest, destsize, src, srcsize);
+        }
+
+        /**
+         * @copydoc decode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t decode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return decode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+     protected:
+        using hook = trace_hook<logged_decoder>;
+    };
+
+    /**************************************************************************************
+     * Reader
+     **************************************************************************************/
+
+    /**
+     * @brief Reads trace files written by trace_logger.
+     *
+     * ```c++
+     * slip::trace_reader in(fopen("link.trace", "rb"));
+     * slip::trace_record r;
+     * while (in.next(r)) puts(slip::trace_reader::format(r).c_str());
+     * ```
+     */
+    class trace_reader {
+     public:
+        /** @param file  open for binary reading. Not closed by the reader. */
+        explicit trace_reader(FILE* file) : _file(file) {
+            char magic[8];
+            _good = _file && fread(magic, 1, 8, _file) == 8 && memcmp(magic, trace_file::magic(), 8) == 0;
+        }
+
+        /** Was the file a trace file, with no damaged record read so far? */
+        bool good() const noexcept { return _good; }
+
+        /** @return false at the end of the file, or if it is not a valid trace */
+        bool next(trace_record& r) {
+            uint8_t h[trace_file::header_size];
+            if (!_good) return false;
+            size_t n = fread(h, 1, sizeof(h), _file);
+            if (n != sizeof(h)) {
+                _good = n == 0; // a partial header is damage, none is the end
+                return false;
+            }
+            r.ns        = trace_file::get(h, 8);
+            r.link      = static_cast<uint16_t>(trace_file::get(h + 8, 2));
+            r.direction = static_cast<trace_direction>(h[10]);
+            r.size      = static_cast<uint32_t>(trace_file::get(h + 12, 4));
+            r.data.resize(static_cast<size_t>(trace_file::get(h + 16, 4)));
+            if (r.data.size() > r.size || fread(&r.data[0], 1, r.data.size(), _file) != r.data.size()) {
+                _good = false;
+                return false;
+            }
+            return true;
+        }
+
+        /** One line for r: UTC time, link, direction, size and the bytes, C-escaped. */
+        static std::string format(const trace_record& r) {
+            char when[64];
+            time_t secs = static_cast<time_t>(r.ns / 1000000000u);
+            struct tm utc;
+            gmtime_r(&secs, &utc);
+            size_t n = strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", &utc);
+            snprintf(when + n, sizeof(when) - n, ".%09uZ link %u %s %u ", static_cast<unsigned>(r.ns % 1000000000u),
+                     r.link, r.direction == trace_direction::tx ? "tx" : "rx", static_cast<unsigned>(r.size));
+            std::string line = when;
+            escaped_append(line, r.data.data(), r.data.size());
+            if (r.truncated()) line += "...";
+            return line;
+        }
+
+     private:
+        FILE* _file;
+        bool _good;
+    };
+
+}
+
+#endif // __SLIPTRACELOG_H__
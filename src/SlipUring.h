@@ -0,0 +1,327 @@
+/*!
+ *  @file SlipUring.h
+ *
+ *  Read and decode many serial ports (or pipes, ptys, sockets) from one
+ *  thread with io_uring: one batched submission for all channels, decoding
+ *  in place in the buffers the kernel filled.
+ *
+ *  Linux only (5.11 or later for timeouts). Uses the raw system calls, so
+ *  there is no liburing dependency.
+ */
+
+#pragma once
+
+#ifndef __SLIPURING_H__
+    #define __SLIPURING_H__
+
+    #include "SlipStream.h"
+    #include <errno.h>
+    #include <linux/io_uring.h>
+    #include <string.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #include <time.h>
+    #include <unistd.h>
+    #include <vector>
+
+namespace slip {
+
+    /**************************************************************************************
+     * Minimal io_uring
+     **************************************************************************************/
+
+    /**
+     * @brief A submission and completion queue pair over the raw system calls.
+     *
+     * Just what the frame reader needs: queue reads, submit them in one call,
+     * wait with a timeout and reap completions. Single-threaded.
+     */
+    class io_ring {
+     public:
+        explicit io_ring(unsigned entries) {
+            io_uring_params p;
+            memset(&p, 0, sizeof(p));
+            _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+            if (_fd < 0) return;
+            _sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            _cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            if (p.features & IORING_FEAT_SINGLE_MMAP) _sq_size = _cq_size = (_sq_size > _cq_size ? _sq_size : _cq_size);
+            _sq = map(_sq_size, IORING_OFF_SQ_RING);
+            _cq = (p.features & IORING_FEAT_SINGLE_MMAP) ? _sq : map(_cq_size, IORING_OFF_CQ_RING);
+            _sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+            _sqes      = static_cast<io_uring_sqe*>(map(_sqes_size, IORING_OFF_SQES));
+            if (!_sq || !_cq || !_sqes) {
+                unmap();
+                return;
+            }
+            uint8_t* sq = static_cast<uint8_t*>(_sq);
+            uint8_t* cq = static_cast<uint8_t*>(_cq);
+            _sq_head    = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+            _sq_tail    = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            _sq_mask    = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            _sq_array   = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            _cq_head    = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            _cq_tail    = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            _cq_mask    = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            _cqes       = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+            _entries    = p.sq_entries;
+            _ext_arg    = (p.features & IORING_FEAT_EXT_ARG) != 0;
+            _tail       = *_sq_tail;
+            _submitted  = _tail;
+        }
+        ~io_ring() { unmap(); }
+
+        io_ring(const io_ring&)            = delete;
+        io_ring& operator=(const io_ring&) = delete;
+
+        bool ok() const noexcept { return _fd >= 0; }
+
+        /** Register one fixed buffer, for IORING_OP_READ_FIXED with buf_index 0. */
+        bool register_buffer(void* buf, size_t size) noexcept {
+            struct iovec iov = {buf, size};
+            return syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+        }
+
+        /** Next free submission entry, zeroed, or nullptr if the queue is full. */
+        io_uring_sqe* get_sqe() noexcept {
+            if (_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) >= _entries) return nullptr;
+            unsigned i       = _tail & _sq_mask;
+            io_uring_sqe* sq = &_sqes[i];
+            memset(sq, 0, sizeof(*sq));
+            _sq_array[i] = i;
+            _tail++;
+            return sq;
+        }
+
+        /**
+         * @brief Submit queued entries and wait for at least one completion.
+         * @param timeout_ms    -1 waits for ever, 0 only submits
+         * @return false on errors other than a timeout or a signal
+         */
+        bool submit_and_wait(int timeout_ms) noexcept {
+            __atomic_store_n(_sq_tail, _tail, __ATOMIC_RELEASE);
+            unsigned flags = timeout_ms ? IORING_ENTER_GETEVENTS : 0;
+            unsigned wait  = timeout_ms ? 1 : 0;
+            struct __kernel_timespec ts;
+            struct io_uring_getevents_arg arg;
+            void* argp     = nullptr;
+            size_t argsize = 0;
+            if (timeout_ms > 0 && _ext_arg) {
+                ts.tv_sec  = timeout_ms / 1000;
+                ts.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+                memset(&arg, 0, sizeof(arg));
+                arg.ts = reinterpret_cast<uint64_t>(&ts);
+                argp    = &arg;
+                argsize = sizeof(arg);
+                flags |= IORING_ENTER_EXT_ARG;
+            }
+            long k = syscall(__NR_io_uring_enter, _fd, _tail - _submitted, wait, flags, argp, argsize);
+            if (k < 0) return errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY;
+            _submitted += static_cast<unsigned>(k);
+            return true;
+        }
+
+        /** Call fn(cqe) for every completion that arrived, and free them. */
+        template <typename _Fn>
+        size_t reap(_Fn fn) {
+            unsigned head = *_cq_head;
+            unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            for (unsigned i = head; i != tail; i++) fn(_cqes[i & _cq_mask]);
+            __atomic_store_n(_cq_head, tail, __ATOMIC_RELEASE);
+            return tail - head;
+        }
+
+     private:
+        void* map(size_t size, off_t offset) noexcept {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+            return p == MAP_FAILED ? nullptr : p;
+        }
+
+        void unmap() noexcept {
+            if (_sqes) munmap(_sqes, _sqes_size);
+            if (_cq && _cq != _sq) munmap(_cq, _cq_size);
+            if (_sq) munmap(_sq, _sq_size);
+            if (_fd >= 0) close(_fd);
+            _sq = _cq = _sqes = nullptr;
+            _fd               = -1;
+        }
+
+        int _fd            = -1;
+        void* _sq          = nullptr;
+        void* _cq          = nullptr;
+        io_uring_sqe* _sqes = nullptr;
+        size_t _sq_size = 0, _cq_size = 0, _sqes_size = 0;
+        unsigned *_sq_head = nullptr, *_sq_tail = nullptr, *_sq_array = nullptr;
+        unsigned *_cq_head = nullptr, *_cq_tail = nullptr;
+        io_uring_cqe* _cqes = nullptr;
+        unsigned _sq_mask = 0, _cq_mask = 0, _entries = 0;
+        unsigned _tail      = 0; // local submission tail
+        unsigned _submitted = 0; // tail as of the last io_uring_enter
+        bool _ext_arg       = false;
+    };
+
+    /**************************************************************************************
+     * Multi-channel frame reader
+     **************************************************************************************/
+
+    /**
+     * @brief Reads many file descriptors with io_uring and queues decoded frames.
+     *
+     * Each channel has one read in flight into its own stream_buffer, a slice
+     * of one registered arena when the kernel allows it. All reads due are
+     * submitted with one system call. A completed read is decoded in place, so
+     * every complete frame is queued by pointer, without a copy.
+     *
+     * Frames returned by next() stay valid until the next wait(), which moves
+     * each unfinished frame to the front of its buffer and reads again. A
+     * frame larger than the buffer is dropped and counted in oversized().
+     *
+     * @tparam DECODER  the decoder_base type to use
+     */
+    template <class DECODER = decoder>
+    class uring_reader {
+     public:
+        using char_type = typename DECODER::char_type;
+
+        /** A decoded frame, in the channel's buffer. */
+        struct frame {
+            size_t channel;
+            const char_type* data;
+            size_t size;
+        };
+
+        /**
+         * @param max_channels  channels that can be added
+         * @param buffer_size   characters per channel, at least the largest decoded frame
+         */
+        uring_reader(size_t max_channels, size_t buffer_size = 4096)
+            : _ring(static_cast<unsigned>(max_channels)), _buffer_size(buffer_size) {
+            _channels.reserve(max_channels);
+            _arena_size = max_channels * buffer_size * sizeof(char_type);
+            void* p     = mmap(nullptr, _arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return;
+            _arena      = static_cast<char_type*>(p);
+            _registered = _ring.ok() && _ring.register_buffer(_arena, _arena_size);
+        }
+        ~uring_reader() {
+            if (_arena) munmap(_arena, _arena_size);
+        }
+
+        uring_reader(const uring_reader&)            = delete;
+        uring_reader& operator=(const uring_reader&) = delete;
+
+        /** io_uring is available. If not, fall back to blocking reads. */
+        bool ok() const noexcept { return _ring.ok() && _arena; }
+
+        /** Reads go to registered buffers (IORING_OP_READ_FIXED). */
+        bool registered() const noexcept { return _registered; }
+
+        /**
+         * @brief Start reading fd. The reader does not close it.
+         * @return channel number, or -1 if all channels are in use
+         */
+        int add(int fd) {
+            if (!ok() || _channels.size() == _channels.capacity()) return -1;
+            _channels.push_back(channel(fd, _arena + _channels.size() * _buffer_size, _buffer_size));
+            return static_cast<int>(_channels.size() - 1);
+        }
+
+        /** Channel ch has not reached end of file or an error yet. */
+        bool is_open(size_t ch) const noexcept { return _channels[ch].status != channel_state::closed; }
+
+        /** Channels still open. */
+        size_t open_channels() const noexcept {
+            size_t n = 0;
+            for (const channel& c : _channels) n += c.status != channel_state::closed;
+            return n;
+        }
+
+        /** Last read error on channel ch (an errno value), or 0. */
+        int error(size_t ch) const noexcept { return _channels[ch].error; }
+
+        uint64_t frames(size_t ch) const noexcept { return _channels[ch].stream.frames(); }       ///< frames decoded
+        uint64_t errors(size_t ch) const noexcept { return _channels[ch].stream.errors(); }       ///< bad escapes
+        uint64_t oversized(size_t ch) const noexcept { return _channels[ch].stream.oversized(); } ///< frames too large
+
+        /**
+         * @brief Submit reads for every idle channel, then wait for and decode completions.
+         *
+         * Invalidates the frames from the previous call.
+         *
+         * @param timeout_ms    -1 waits until a read completes, 0 does not wait
+         * @return size_t       reads completed, or 0 on a timeout or when all channels are closed
+         */
+        size_t wait(int timeout_ms = -1) {
+            _frames.clear();
+            _next = 0;
+            size_t inflight = 0;
+            for (size_t i = 0; i < _channels.size(); i++) {
+                channel& c = _channels[i];
+                if (c.status == channel_state::idle) submit(i, c);
+                inflight += c.status == channel_state::reading;
+            }
+            if (!inflight || !_ring.submit_and_wait(timeout_ms)) return 0;
+            return _ring.reap([this](const io_uring_cqe& cqe) { complete(cqe); });
+        }
+
+        /** Next queued frame, until the next wait(). */
+        bool next(frame& f) noexcept {
+            if (_next >= _frames.size()) return false;
+            f = _frames[_next++];
+            return true;
+        }
+
+     private:
+        enum class channel_state : uint8_t { idle, reading, closed };
+
+        struct channel {
+            channel(int fd, char_type* buf, size_t size) : fd(fd), stream(buf, size) {}
+            int fd;
+            stream_buffer<DECODER> stream;
+            channel_state status = channel_state::idle;
+            int error            = 0;
+        };
+
+        void submit(size_t i, channel& c) {
+            io_uring_sqe* sqe = _ring.get_sqe();
+            if (!sqe) return; // stays idle until the next wait()
+            c.stream.prepare(); // the frames before were handed out by the last wait()
+            sqe->opcode    = _registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            sqe->fd        = c.fd;
+            sqe->off       = static_cast<uint64_t>(-1); // current position, for files
+            sqe->addr      = reinterpret_cast<uint64_t>(c.stream.space());
+            sqe->len       = static_cast<unsigned>(c.stream.room() * sizeof(char_type));
+            sqe->buf_index = 0;
+            sqe->user_data = i;
+            c.status       = channel_state::reading;
+        }
+
+        void complete(const io_uring_cqe& cqe) {
+            size_t i     = static_cast<size_t>(cqe.user_data);
+            channel& c   = _channels[i];
+            c.status     = channel_state::idle;
+            auto deliver = [this, i](const char_type* data, size_t size) { _frames.push_back({i, data, size}); };
+            if (cqe.res > 0) {
+                c.stream.received(cqe.res / sizeof(char_type), deliver);
+                return;
+            }
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN) return; // read again
+            c.error  = cqe.res < 0 ? -cqe.res : 0;
+            c.status = channel_state::closed;
+            c.stream.finish(deliver);
+        }
+
+        io_ring _ring;
+        size_t _buffer_size;
+        char_type* _arena  = nullptr;
+        size_t _arena_size = 0;
+        bool _registered   = false;
+        std::vector<channel> _channels;
+        std::vector<frame> _frames;
+        size_t _next = 0;
+    };
+
+}
+
+#endif // __SLIPURING_H__
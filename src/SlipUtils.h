@@ -3,67 +3,169 @@
 #ifndef __SLIPUTILS_H__
     #define __SLIPUTILS_H__
 
-    #include <iomanip>
+    #include <stdint.h> // for uint8_t
     #include <string>
-    #include <ostream>
-    #include <sstream>
-    #include <algorithm>
+    #include <string.h> // for memcpy
 
 namespace slip {
-    inline std::string escaped(const char* buf, size_t size, const char* brackets = "\"\"") {
-        std::stringstream oss;
-        size_t br_len = brackets ? strlen(brackets) : 0;
-        if (br_len > 0) {
-            oss << brackets[0];
-        }
-        static char c_escapes[] = {
-            '\0', '0', // NULL
-            '\'', '\'', // single quote
-            '\"', '"', // double quote
-            '\?', '?', // question mark
-            '\\', '\\', // backslash
-            '\a', 'a', // audible bell
-            '\b', 'b', // backspace
-            '\f', 'f', // formfeed
-            '\n', 'n', // line feed
-            '\r', 'r', // carriage return
-            '\t', 't', // horizontal tab
-            '\v', 'v' // vertical tab
-        };
-        std::for_each(buf, (buf + size), [&oss,&brackets](char c) {
-            unsigned char uc = static_cast<unsigned char>(c);
-            int c_esc;
-            for (c_esc = 0; c_esc < sizeof(c_escapes); c_esc += 2) {
-                if (uc == c_escapes[c_esc])
-                    break;
+
+    /**
+     * @brief How each character is shown by escaped(): C escapes, itself if
+     * printable, otherwise a 3-digit octal escape.
+     *
+     * Built once, on first use.
+     */
+    struct escape_table {
+        uint8_t len[256];  ///< characters of text used
+        char text[256][4]; ///< the escaped form
+
+        escape_table() noexcept {
+            static const char c_escapes[] = {
+                '\0', '0', // NULL
+                '\'', '\'', // single quote
+                '\"', '"', // double quote
+                '\?', '?', // question mark
+                '\\', '\\', // backslash
+                '\a', 'a', // audible bell
+                '\b', 'b', // backspace
+                '\f', 'f', // formfeed
+                '\n', 'n', // line feed
+                '\r', 'r', // carriage return
+                '\t', 't', // horizontal tab
+                '\v', 'v' // vertical tab
+            };
+            for (unsigned c = 0; c < 256; c++) {
+                text[c][0] = '\\';
+                if (c >= 0x20 && c < 0x7f) {
+                    len[c]     = 1;
+                    text[c][0] = static_cast<char>(c);
+                } else {
+                    len[c]     = 4;
+                    text[c][1] = static_cast<char>('0' + (c >> 6));
+                    text[c][2] = static_cast<char>('0' + ((c >> 3) & 7));
+                    text[c][3] = static_cast<char>('0' + (c & 7));
+                }
             }
-            if (c_esc < sizeof(c_escapes)) {
-                char sc = c_escapes[c_esc+1];
-                oss << '\\' << sc;
-            } else if (isprint(uc)) {
-                oss << c;
-            } else {
-                oss << "\\" << std::setfill('0') << std::setw(3) << std::oct
-                    << static_cast<unsigned int>(uc);
+            for (size_t i = 0; i < sizeof(c_escapes); i += 2) {
+                unsigned char uc = static_cast<unsigned char>(c_escapes[i]);
+                len[uc]          = 2;
+                text[uc][0]      = '\\';
+                text[uc][1]      = c_escapes[i + 1];
             }
-        });
-        if (br_len > 0) {
-            if (br_len > 1)
-                oss << brackets[1];
-            else
-                oss << brackets[0];
         }
-        return oss.str();
+
+        static const escape_table& get() noexcept {
+            static const escape_table table;
+            return table;
+        }
+    };
+
+    /** @brief Exact length of escaped(buf, size, brackets). */
+    inline size_t escaped_size(const char* buf, size_t size, const char* brackets = "\"\"") noexcept {
+        const escape_table& t = escape_table::get();
+        size_t n              = (brackets && brackets[0]) ? 2 : 0;
+        for (size_t i = 0; i < size; i++) n += t.len[static_cast<unsigned char>(buf[i])];
+        return n;
+    }
+
+    /**
+     * @brief Write buf as a C-escaped string into dest. No terminating NULL is written.
+     *
+     * brackets gives the opening and closing characters. With one character it
+     * is used for both, and NULL or "" means none.
+     *
+     * @return size_t   characters written, or 0 if dest is smaller than escaped_size()
+     */
+    inline size_t escaped_to(char* dest, size_t destsize, const char* buf, size_t size,
+                             const char* brackets = "\"\"") noexcept {
+        const escape_table& t = escape_table::get();
+        size_t n              = escaped_size(buf, size, brackets);
+        if (!dest || destsize < n) return 0;
+        char* out       = dest;
+        const char* end = dest + n - ((brackets && brackets[0]) ? 1 : 0); // nothing past the escaped text
+        if (brackets && brackets[0]) *(out++) = brackets[0];
+        size_t i = 0;
+        for (; i < size && end - out >= 4; i++) { // copy all 4: one fixed-size store
+            unsigned char uc = static_cast<unsigned char>(buf[i]);
+            memcpy(out, t.text[uc], 4);
+            out += t.len[uc];
+        }
+        for (; i < size; i++) {
+            unsigned char uc = static_cast<unsigned char>(buf[i]);
+            memcpy(out, t.text[uc], t.len[uc]);
+            out += t.len[uc];
+        }
+        if (brackets && brackets[0]) *(out++) = brackets[1] ? brackets[1] : brackets[0];
+        return n;
+    }
+
+    /** @brief Append buf C-escaped to out, growing it at most once. */
+    inline std::string& escaped_append(std::string& out, const char* buf, size_t size, const char* brackets = "\"\"") {
+        size_t at = out.size();
+        out.resize(at + escaped_size(buf, size, brackets));
+        escaped_to(&out[at], out.size() - at, buf, size, brackets);
+        return out;
+    }
+
+    inline std::string escaped(const char* buf, size_t size, const char* brackets = "\"\"") {
+        std::string out;
+        return escaped_append(out, buf, size, brackets);
     }
 
     inline std::string escaped(const unsigned char* buf, size_t size, const char* brackets = "\"\"") {
         return escaped(reinterpret_cast<const char*>(buf), size, brackets);
     }
 
-    inline std::string escaped(std::string& src, const char* brackets = "\"\"") {
+    inline std::string escaped(const std::string& src, const char* brackets = "\"\"") {
         return escaped(src.c_str(), src.length(), brackets);
     }
 
+    /** @brief Length of hexdump(buf, size, sep): two digits per character, sep between characters. */
+    inline size_t hexdump_size(size_t size, char sep = ' ') noexcept {
+        return size ? 2 * size + (sep ? size - 1 : 0) : 0;
+    }
+
+    /**
+     * @brief Write buf as lower-case hex into dest, e.g. "c0 db 01". No terminating NULL is written.
+     *
+     * @param sep       character between bytes, or 0 for none
+     * @return size_t   characters written, or 0 if dest is smaller than hexdump_size()
+     */
+    inline size_t hexdump_to(char* dest, size_t destsize, const unsigned char* buf, size_t size,
+                             char sep = ' ') noexcept {
+        static const char digits[] = "0123456789abcdef";
+        size_t n                   = hexdump_size(size, sep);
+        if (!dest || destsize < n) return 0;
+        char* out = dest;
+        for (size_t i = 0; i < size; i++) {
+            if (sep && i) *(out++) = sep;
+            *(out++) = digits[buf[i] >> 4];
+            *(out++) = digits[buf[i] & 0x0f];
+        }
+        return n;
+    }
+
+    inline size_t hexdump_to(char* dest, size_t destsize, const char* buf, size_t size, char sep = ' ') noexcept {
+        return hexdump_to(dest, destsize, reinterpret_cast<const unsigned char*>(buf), size, sep);
+    }
+
+    /** @brief Append buf as hex to out, growing it at most once. */
+    inline std::string& hexdump_append(std::string& out, const unsigned char* buf, size_t size, char sep = ' ') {
+        size_t at = out.size();
+        out.resize(at + hexdump_size(size, sep));
+        hexdump_to(&out[at], out.size() - at, buf, size, sep);
+        return out;
+    }
+
+    inline std::string hexdump(const unsigned char* buf, size_t size, char sep = ' ') {
+        std::string out;
+        return hexdump_append(out, buf, size, sep);
+    }
+
+    inline std::string hexdump(const char* buf, size_t size, char sep = ' ') {
+        return hexdump(reinterpret_cast<const unsigned char*>(buf), size, sep);
+    }
+
 }; // namespace slip
 
-#endif // __SLIPUTILS_H__
\ No newline at end of file
+#endif // __SLIPUTILS_H__
@@ -0,0 +1,219 @@
+/*!
+ *  @file SlipWhitening.h
+ *
+ *  Optional payload whitening: each frame is XORed with the one-byte key that
+ *  leaves the fewest characters to escape.
+ */
+
+#pragma once
+
+#ifndef __SLIPWHITENING_H__
+    #define __SLIPWHITENING_H__
+
+    #include "SlipInPlace.h"
+
+namespace slip {
+
+    /**************************************************************************************
+     * Whitening encoder
+     **************************************************************************************/
+
+    /**
+     * @brief Encoder that XOR-whitens each frame to minimise escapes.
+     *
+     * A byte histogram of the payload picks the key k that minimises the number
+     * of payload bytes b with b ^ k special. Ties go to the lowest key, so
+     * payloads that need no escapes keep k = 0. The frame on the wire is the key
+     * (escaped if special), then the payload XOR k, escaped, then END.
+     *
+     * Costs one character per frame. Saves up to one character per payload byte
+     * for payloads crowded around the special codes, such as raw sensor samples
+     * near 0xC0.
+     *
+     * @tparam ENCODER  the encoder_base type whose codes to use
+     */
+    template <class ENCODER>
+    struct whitening_encoder : public ENCODER {
+        using char_type = typename ENCODER::char_type;
+
+        /**
+         * @brief The XOR key for src.
+         *
+         * @param nescapes  if not NULL, set to the escapes needed with that key, key included
+         */
+        static uint8_t choose_key(const char_type* src, size_t srcsize, size_t* nescapes = NULL) noexcept {
+            size_t hist[256] = {};
+            for (size_t i = 0; i < srcsize; i++) hist[static_cast<uint8_t>(src[i])]++;
+            const char_type* specials = ENCODER::special_codes();
+            size_t best_cost = ~size_t(0);
+            uint8_t best     = 0;
+            for (unsigned k = 0; k < 256; k++) {
+                size_t cost = ENCODER::test_codes(static_cast<char_type>(k), specials) < 0 ? 0 : 1;
+                for (int i = 0; i < ENCODER::num_specials; i++) cost += hist[static_cast<uint8_t>(specials[i]) ^ k];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best      = static_cast<uint8_t>(k);
+                }
+            }
+            if (nescapes) *nescapes = best_cost;
+            return best;
+        }
+
+        /** @copydoc encoder_base::encoded_size */
+        static inline size_t encoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t nescapes;
+            choose_key(src, srcsize, &nescapes);
+            return 1 + srcsize + nescapes + 1;
+        }
+
+        /**
+         * @copydoc encoder_base::encode
+         *
+         * Fails without writing anything if dest is too small for the whole frame.
+         */
+        static inline size_t encode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            const char_type* specials          = ENCODER::special_codes();
+            const char_type* escapes           = ENCODER::escaped_codes();
+            if (!dest || !src) return BAD_DECODE;
+            size_t nescapes;
+            uint8_t key  = choose_key(src, srcsize, &nescapes);
+            size_t esize = 1 + srcsize + nescapes + 1;
+            if (destsize < esize) return BAD_DECODE;
+            if (dest <= src && src <= dest + destsize) { // in-place: same trick as encoder_base
+                src = (char_type*)memmove(dest + destsize - srcsize, src, srcsize);
+            }
+            const char_type* send = src + srcsize;
+            char_type* dstart     = dest;
+            int isp               = ENCODER::test_codes(static_cast<char_type>(key), specials);
+            if (isp < 0) {
+                *(dest++) = static_cast<char_type>(key);
+            } else {
+                *(dest++) = ENCODER::esc_code();
+                *(dest++) = escapes[isp];
+            }
+            while (src < send) {
+                char_type c = static_cast<char_type>(static_cast<uint8_t>(*(src++)) ^ key);
+                isp         = ENCODER::test_codes(c, specials);
+                if (isp < 0) {
+                    *(dest++) = c;
+                } else {
+                    *(dest++) = ENCODER::esc_code();
+                    *(dest++) = escapes[isp];
+                }
+            }
+            *(dest++) = ENCODER::end_code();
+            return dest - dstart;
+        }
+
+        /**
+         * @copydoc choose_key
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline uint8_t choose_key(const _FromT* src, size_t srcsize, size_t* nescapes = NULL) noexcept {
+            return choose_key(reinterpret_cast<const char_type*>(src), srcsize, nescapes);
+        }
+
+        /**
+         * @copydoc encoded_size
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encoded_size(const _FromT* src, size_t srcsize) noexcept {
+            return encoded_size(reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+        /**
+         * @copydoc encode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t encode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return encode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+    };
+
+    /**************************************************************************************
+     * Whitening decoder
+     **************************************************************************************/
+
+    /**
+     * @brief Decoder for whitening_encoder frames. Unescapes and removes the XOR in one pass.
+     *
+     * @tparam DECODER  the decoder_base type whose codes to use
+     */
+    template <class DECODER>
+    struct whitening_decoder : public DECODER {
+        using char_type = typename DECODER::char_type;
+
+        /** @copydoc decoder_base::decoded_size */
+        static inline size_t decoded_size(const char_type* src, size_t srcsize) noexcept {
+            size_t size = DECODER::decoded_size(src, srcsize);
+            return size ? size - 1 : 0; // less the key
+        }
+
+        /** @copydoc decoder_base::decode */
+        static inline size_t decode(char_type* dest, size_t destsize, const char_type* src, size_t srcsize) noexcept {
+            static constexpr size_t BAD_DECODE = 0;
+            const char_type* specials          = DECODER::special_codes();
+            const char_type* escapes           = DECODER::escaped_codes();
+            const char_type* send              = src + srcsize;
+            char_type* dstart                  = dest;
+            char_type* dend                    = dest + destsize;
+            if (!dest || !src || srcsize < 1 || destsize < 1) return BAD_DECODE;
+            bool keyed  = false;
+            uint8_t key = 0;
+            int isp;
+
+            while (src < send) {
+                if (src[0] == DECODER::end_code()) break;
+                char_type c;
+                if (src[0] != DECODER::esc_code()) {
+                    c = *(src++);
+                } else {
+                    src++;
+                    if (src >= send) return BAD_DECODE;
+                    isp = DECODER::test_codes(src[0], escapes);
+                    if (isp < 0) return BAD_DECODE; // invalid escape code
+                    c = specials[isp];
+                    src++;
+                }
+                if (!keyed) {
+                    key   = static_cast<uint8_t>(c);
+                    keyed = true;
+                } else {
+                    if (dest >= dend) return BAD_DECODE; // not enough room for results
+                    *(dest++) = static_cast<char_type>(static_cast<uint8_t>(c) ^ key);
+                }
+            }
+            return dest - dstart;
+        }
+
+        /**
+         * @copydoc decoded_size
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t decoded_size(const _FromT* src, size_t srcsize) noexcept {
+            return decoded_size(reinterpret_cast<const char_type*>(src), srcsize);
+        }
+
+        /**
+         * @copydoc decode
+         * @tparam _FromT must have same element size as char_type
+         */
+        template <typename _FromT,
+                  typename std::enable_if<sizeof(_FromT) == sizeof(char_type), bool>::type = true>
+        static inline size_t decode(_FromT* dest, size_t destsize, const _FromT* src, size_t srcsize) noexcept {
+            return decode(reinterpret_cast<char_type*>(dest), destsize, reinterpret_cast<const char_type*>(src), srcsize);
+        }
+    };
+
+}
+
+#endif // __SLIPWHITENING_H__
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <SlipAdaptive.h>
+#include <SlipDispatch.h>
+#include <SlipFrame.h>
+#include <SlipInPlace.h>
+#include <SlipNonTemporal.h>
+#include <SlipPool.h>
+#include <SlipRecord.h>
+#include <SlipStats.h>
+#include <SlipUtils.h>
+#include "perf_counters.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+ * Benchmark helpers
+ **************************************************************************************/
+
+using namespace std;
+using bytes = vector<uint8_t>;
+
+/** Heap allocations made through operator new, for allocations-per-frame */
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+/** Payload with the given fraction of SLIP special characters */
+bytes make_payload(size_t size, double density, unsigned seed = 1) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> byte(0, 255);
+    uniform_real_distribution<double> unit(0, 1);
+    const uint8_t specials[] = {slip::stdcodes::SLIP_END, slip::stdcodes::SLIP_ESC};
+    bytes payload(size);
+    for (auto& c : payload) {
+        if (unit(rng) < density) {
+            c = specials[byte(rng) & 1];
+        } else {
+            do { c = static_cast<uint8_t>(byte(rng)); } while (c == specials[0] || c == specials[1]);
+        }
+    }
+    return payload;
+}
+
+/** Best-of-reps throughput of fn() in MB/s of payload */
+template <typename _Fn>
+double throughput(size_t payload_size, int reps, _Fn fn) {
+    double best = 1e99;
+    for (int r = 0; r < reps; r++) {
+        auto t0 = chrono::steady_clock::now();
+        fn();
+        double s = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        if (s < best) best = s;
+    }
+    return payload_size / best / 1e6;
+}
+
+/**************************************************************************************
+ * Kernels by special-character density
+ **************************************************************************************/
+
+void bench_kernels(size_t size, int reps) {
+    using encoder = slip::encoder;
+    using decoder = slip::decoder;
+    cout << "## Kernel throughput, " << size << " byte payload, MB/s" << endl << endl;
+    cout << setw(12) << "kernel" << setw(9) << "density" << setw(10) << "encode" << setw(10) << "decode" << endl;
+    for (double density : {0.0, 0.01, 0.10, 0.50}) {
+        bytes payload = make_payload(size, density);
+        bytes frame(encoder::encoded_size(payload.data(), payload.size()));
+        bytes out(frame.size());
+        encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        for (int k = 0; k < static_cast<int>(slip::kernel_id::num_kernels); k++) {
+            slip::kernel_id kid = static_cast<slip::kernel_id>(k);
+            if (!slip::kernel_supported(kid)) continue;
+            auto enc = kid == slip::kernel_id::scalar ? static_cast<slip::kernels<encoder>::code_fn>(&encoder::encode) : slip::kernels<encoder>::encode(kid);
+            auto dec = kid == slip::kernel_id::scalar ? static_cast<slip::kernels<decoder>::code_fn>(&decoder::decode) : slip::kernels<decoder>::decode(kid);
+            if (!enc || !dec) continue;
+            double e = throughput(size, reps, [&] { enc(out.data(), out.size(), payload.data(), payload.size()); });
+            double d = throughput(size, reps, [&] { dec(out.data(), out.size(), frame.data(), frame.size()); });
+            cout << setw(12) << slip::kernel_name(kid) << setw(8) << int(density * 100) << "%"
+                 << setw(10) << fixed << setprecision(0) << e << setw(10) << d << endl;
+        }
+        slip::adaptive_encoder<encoder> aenc;
+        slip::adaptive_decoder<decoder> adec;
+        double e = throughput(size, reps, [&] { aenc.encode(out.data(), out.size(), payload.data(), payload.size()); });
+        double d = throughput(size, reps, [&] { adec.decode(out.data(), out.size(), frame.data(), frame.size()); });
+        int chosen = 0;
+        for (int k = 0; k < static_cast<int>(slip::kernel_id::num_kernels); k++)
+            if (aenc.counters().chosen[k] > aenc.counters().chosen[chosen]) chosen = k;
+        cout << setw(12) << "adaptive" << setw(8) << int(density * 100) << "%"
+             << setw(10) << fixed << setprecision(0) << e << setw(10) << d
+             << "  (" << slip::kernel_name(static_cast<slip::kernel_id>(chosen)) << ")" << endl;
+    }
+    cout << endl;
+}
+
+/**************************************************************************************
+ * Non-temporal stores for large out-of-place buffers
+ **************************************************************************************/
+
+/** Microseconds to re-read a working set that should still be cached */
+double reread_us(const bytes& working_set) {
+    auto t0              = chrono::steady_clock::now();
+    volatile uint64_t sum = 0;
+    for (size_t i = 0; i < working_set.size(); i += 64) sum = sum + working_set[i];
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+}
+
+void bench_nontemporal(size_t max_size, int reps) {
+    using encoder    = slip::dispatched_encoder<slip::slip_encoder_base<uint8_t>>;
+    using decoder    = slip::dispatched_decoder<slip::slip_decoder_base<uint8_t>>;
+    using nt_encoder = slip::nontemporal_encoder<slip::slip_encoder_base<uint8_t>>;
+    using nt_decoder = slip::nontemporal_decoder<slip::slip_decoder_base<uint8_t>>;
+    cout << "## Normal vs non-temporal out-of-place codecs, 1% density, MB/s" << endl;
+    cout << "## (reread: microseconds to re-read a 1 MB working set afterwards)" << endl << endl;
+    cout << setw(12) << "size" << setw(10) << "encode" << setw(10) << "nt" << setw(10) << "decode" << setw(10) << "nt"
+         << setw(10) << "reread" << setw(10) << "nt" << endl;
+    size_t saved = slip::nontemporal::threshold();
+    slip::nontemporal::set_threshold(0);
+    bytes working_set = make_payload(1 << 20, 0, 2);
+    for (size_t size = 1 << 20; size <= max_size; size *= 4) {
+        int r         = size >= (64u << 20) ? min(reps, 3) : reps;
+        bytes payload = make_payload(size, 0.01);
+        bytes frame(encoder::encoded_size(payload.data(), payload.size()));
+        bytes out(frame.size());
+        encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        double e    = throughput(size, r, [&] { encoder::encode(out.data(), out.size(), payload.data(), payload.size()); });
+        double e_nt = throughput(size, r, [&] { nt_encoder::encode(out.data(), out.size(), payload.data(), payload.size()); });
+        double d    = throughput(size, r, [&] { decoder::decode(out.data(), out.size(), frame.data(), frame.size()); });
+        double d_nt = throughput(size, r, [&] { nt_decoder::decode(out.data(), out.size(), frame.data(), frame.size()); });
+        reread_us(working_set);
+        encoder::encode(out.data(), out.size(), payload.data(), payload.size());
+        double w = reread_us(working_set);
+        reread_us(working_set);
+        nt_encoder::encode(out.data(), out.size(), payload.data(), payload.size());
+        double w_nt = reread_us(working_set);
+        cout << setw(10) << (size >> 20) << "MB" << fixed << setprecision(0) << setw(10) << e << setw(10) << e_nt
+             << setw(10) << d << setw(10) << d_nt << setw(10) << w << setw(10) << w_nt << endl;
+    }
+    slip::nontemporal::set_threshold(saved);
+    cout << endl;
+}
+
+/**************************************************************************************
+ * Allocations per decoded frame
+ **************************************************************************************/
+
+/** Time decoding every frame of stream nbatches times, and count heap allocations */
+template <typename _Fn>
+void alloc_row(const char* name, size_t nframes, int nbatches, _Fn decode_batch) {
+    size_t allocs0 = g_allocations;
+    auto t0        = chrono::steady_clock::now();
+    for (int b = 0; b < nbatches; b++) decode_batch();
+    double s      = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    double frames = double(nframes) * nbatches;
+    cout << setw(18) << name << fixed << setprecision(3) << setw(14) << (g_allocations - allocs0) / frames
+         << setprecision(0) << setw(14) << frames / s / 1e3 << endl;
+}
+
+void bench_alloc(int reps) {
+    using decoder          = slip::decoder;
+    const size_t nframes   = 10000;
+    const int nbatches     = 10 * reps;
+    mt19937 rng(3);
+    uniform_int_distribution<size_t> length(20, 200);
+    bytes stream;
+    vector<size_t> starts;
+    for (size_t i = 0; i < nframes; i++) {
+        bytes payload = make_payload(length(rng), 0.01, unsigned(i));
+        bytes frame(slip::encoder::encoded_size(payload.data(), payload.size()));
+        slip::encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        starts.push_back(stream.size());
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    starts.push_back(stream.size());
+    volatile size_t sink = 0;
+
+    cout << "## Decoded frame storage, " << nframes << " frames of 20-200 bytes per batch" << endl << endl;
+    cout << setw(18) << "storage" << setw(14) << "allocs/frame" << setw(14) << "kframes/s" << endl;
+    alloc_row("std::vector", nframes, nbatches, [&] {
+        for (size_t i = 0; i < nframes; i++) {
+            const uint8_t* src = stream.data() + starts[i];
+            size_t srcsize     = starts[i + 1] - starts[i];
+            bytes frame(decoder::decoded_size(src, srcsize));
+            frame.resize(decoder::decode(frame.data(), frame.size(), src, srcsize));
+            sink = sink + frame.size();
+        }
+    });
+    alloc_row("std::string", nframes, nbatches, [&] {
+        for (size_t i = 0; i < nframes; i++) {
+            const uint8_t* src = stream.data() + starts[i];
+            size_t srcsize     = starts[i + 1] - starts[i];
+            string frame(decoder::decoded_size(src, srcsize), '\0');
+            frame.resize(decoder::decode(reinterpret_cast<uint8_t*>(&frame[0]), frame.size(), src, srcsize));
+            sink = sink + frame.size();
+        }
+    });
+    alloc_row("slip::frame<256>", nframes, nbatches, [&] {
+        for (size_t i = 0; i < nframes; i++) {
+            slip::frame<256> frame;
+            frame.decode_from(stream.data() + starts[i], starts[i + 1] - starts[i]);
+            sink = sink + frame.size();
+        }
+    });
+    slip::frame_arena<> arena(stream.size());
+    alloc_row("frame_arena", nframes, nbatches, [&] {
+        for (size_t i = 0; i < nframes; i++) {
+            slip::frame_span<uint8_t> frame = arena.decode<decoder>(stream.data() + starts[i], starts[i + 1] - starts[i]);
+            sink = sink + frame.size;
+        }
+        arena.reset(); // whole batch released at once
+    });
+    static slip::frame_pool<256, 64> pool;
+    alloc_row("frame_pool", nframes, nbatches, [&] {
+        for (size_t i = 0; i < nframes; i++) {
+            auto frame = pool.decode<decoder>(stream.data() + starts[i], starts[i + 1] - starts[i]);
+            sink = sink + frame.size();
+        }
+    });
+    #if SLIP_HAS_PMR
+    slip::arena_resource resource(arena);
+    alloc_row("pmr::vector", nframes, nbatches, [&] {
+        for (size_t i = 0; i < nframes; i++) {
+            const uint8_t* src = stream.data() + starts[i];
+            size_t srcsize     = starts[i + 1] - starts[i];
+            std::pmr::vector<uint8_t> frame(decoder::decoded_size(src, srcsize), &resource);
+            frame.resize(decoder::decode(frame.data(), frame.size(), src, srcsize));
+            sink = sink + frame.size();
+        }
+        arena.reset();
+    });
+    #endif
+    cout << endl;
+}
+
+/**************************************************************************************
+ * Typed record decode
+ **************************************************************************************/
+
+struct telemetry {
+    uint32_t t;
+    int16_t x, y, z;
+    uint16_t status;
+    uint32_t seq;
+};
+using telemetry_wire =
+    slip::layout<slip::byte_order::big, slip::field<offsetof(telemetry, t), 4>, slip::field<offsetof(telemetry, x), 2>,
+                 slip::field<offsetof(telemetry, y), 2>, slip::field<offsetof(telemetry, z), 2>,
+                 slip::field<offsetof(telemetry, status), 2>, slip::field<offsetof(telemetry, seq), 4>>;
+
+static uint32_t be32(const uint8_t* p) { return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]; }
+static uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+
+void bench_records(int reps) {
+    const size_t nrecords = 100000;
+    using enc             = slip::record_encoder<telemetry, telemetry_wire>;
+    mt19937 rng(4);
+    uniform_int_distribution<int> near_end(0xB0, 0xDF); // samples that sit near END and ESC
+    bytes stream;
+    vector<size_t> starts;
+    uint8_t buf[enc::max_encoded_size];
+    for (size_t i = 0; i < nrecords; i++) {
+        int16_t v = static_cast<int16_t>(near_end(rng) << 8 | near_end(rng));
+        telemetry r{uint32_t(i * 10), v, int16_t(-v), int16_t(v ^ 0x5a5a), uint16_t(near_end(rng)), uint32_t(i)};
+        starts.push_back(stream.size());
+        stream.insert(stream.end(), buf, buf + enc::encode(buf, sizeof(buf), r));
+    }
+    starts.push_back(stream.size());
+    volatile uint32_t sink = 0;
+
+    cout << "## Telemetry records, " << nrecords << " big-endian records of " << enc::wire_size << " bytes" << endl << endl;
+    cout << setw(30) << "decode" << setw(14) << "Mrecords/s" << endl;
+    double mr = throughput(nrecords, reps, [&] {
+        uint8_t tmp[64];
+        for (size_t i = 0; i < nrecords; i++) {
+            size_t n = slip::decoder::decode(tmp, sizeof(tmp), stream.data() + starts[i], starts[i + 1] - starts[i]);
+            if (n != enc::wire_size) continue;
+            telemetry r;
+            r.t      = be32(tmp);
+            r.x      = static_cast<int16_t>(be16(tmp + 4));
+            r.y      = static_cast<int16_t>(be16(tmp + 6));
+            r.z      = static_cast<int16_t>(be16(tmp + 8));
+            r.status = be16(tmp + 10);
+            r.seq    = be32(tmp + 12);
+            sink     = sink + r.seq;
+        }
+    });
+    cout << setw(30) << "decode, then swap fields" << fixed << setprecision(1) << setw(14) << mr << endl;
+    mr = throughput(nrecords, reps, [&] {
+        for (size_t i = 0; i < nrecords; i++) {
+            telemetry r;
+            if (slip::record_decoder<telemetry, telemetry_wire>::decode(r, stream.data() + starts[i], starts[i + 1] - starts[i]))
+                sink = sink + r.seq;
+        }
+    });
+    cout << setw(30) << "record_decoder" << fixed << setprecision(1) << setw(14) << mr << endl << endl;
+}
+
+/**************************************************************************************
+ * Frame logging
+ **************************************************************************************/
+
+void bench_logging(size_t size, int reps) {
+    bytes payload = make_payload(size, 0.01);
+    bytes frame(2 * size + 1);
+    string text;
+    text.reserve(4 * size + 2);
+    cout << "## Frame logging, " << size << " bytes, 1% specials" << endl << endl;
+    cout << setw(20) << "" << setw(10) << "MB/s" << endl;
+    double mbs = throughput(size, reps, [&] { slip::encoder::encode(frame.data(), frame.size(), payload.data(), size); });
+    cout << setw(20) << "encode" << fixed << setprecision(0) << setw(10) << mbs << endl;
+    mbs = throughput(size, reps, [&] {
+        text.clear();
+        slip::escaped_append(text, reinterpret_cast<const char*>(payload.data()), size);
+    });
+    cout << setw(20) << "escaped_append" << setw(10) << mbs << endl;
+    mbs = throughput(size, reps, [&] {
+        text.clear();
+        slip::hexdump_append(text, payload.data(), size);
+    });
+    cout << setw(20) << "hexdump_append" << setw(10) << mbs << endl << endl;
+}
+
+/**************************************************************************************
+ * Codec statistics
+ **************************************************************************************/
+
+template <class ENCODER, class DECODER>
+void stats_row(const char* name, const bytes& payload, int reps) {
+    bytes frame(2 * payload.size() + 1), out(payload.size());
+    size_t esize = 0;
+    double enc   = throughput(payload.size(), reps, [&] { esize = ENCODER::encode(frame.data(), frame.size(), payload.data(), payload.size()); });
+    double dec   = throughput(payload.size(), reps, [&] { DECODER::decode(out.data(), out.size(), frame.data(), esize); });
+    cout << setw(20) << name << fixed << setprecision(0) << setw(10) << enc << setw(10) << dec << endl;
+}
+
+void bench_stats(size_t size, int reps) {
+    struct bench_link;
+    using counting = slip::counting_stats<bench_link>;
+    bytes payload  = make_payload(size, 0.01);
+    cout << "## Codec statistics, " << size << " bytes, 1% specials" << endl << endl;
+    cout << setw(20) << "MB/s" << setw(10) << "encode" << setw(10) << "decode" << endl;
+    stats_row<slip::slip_encoder_base<uint8_t>, slip::slip_decoder_base<uint8_t>>("no_stats", payload, reps);
+    stats_row<slip::slip_encoder_base<uint8_t, counting>, slip::slip_decoder_base<uint8_t, counting>>("counting_stats", payload, reps);
+    cout << endl;
+}
+
+/**************************************************************************************
+ * Hardware counters per test_codes variant
+ **************************************************************************************/
+
+/** Standard SLIP through 256-entry lookup tables, as a baseline for the compare chains */
+struct table_codec {
+    uint8_t escape[256];   ///< escaped code of a special character, 0 for a regular one
+    uint8_t unescape[256]; ///< special character of an escaped code, 0 for an invalid one
+
+    table_codec() noexcept {
+        memset(escape, 0, sizeof(escape));
+        memset(unescape, 0, sizeof(unescape));
+        escape[slip::stdcodes::SLIP_END]      = slip::stdcodes::SLIP_ESCEND;
+        escape[slip::stdcodes::SLIP_ESC]      = slip::stdcodes::SLIP_ESCESC;
+        unescape[slip::stdcodes::SLIP_ESCEND] = slip::stdcodes::SLIP_END;
+        unescape[slip::stdcodes::SLIP_ESCESC] = slip::stdcodes::SLIP_ESC;
+    }
+
+    static const table_codec& get() noexcept {
+        static const table_codec t;
+        return t;
+    }
+
+    static size_t encode(uint8_t* dest, size_t destsize, const uint8_t* src, size_t srcsize) noexcept {
+        const table_codec& t = get();
+        uint8_t *d = dest, *dend = dest + destsize;
+        for (const uint8_t* send = src + srcsize; src < send; src++) {
+            uint8_t e = t.escape[*src];
+            if (dend - d < (e ? 2 : 1)) return 0;
+            if (e) {
+                *(d++) = slip::stdcodes::SLIP_ESC;
+                *(d++) = e;
+            } else {
+                *(d++) = *src;
+            }
+        }
+        if (d >= dend) return 0;
+        *(d++) = slip::stdcodes::SLIP_END;
+        return d - dest;
+    }
+
+    static size_t decode(uint8_t* dest, size_t destsize, const uint8_t* src, size_t srcsize) noexcept {
+        const table_codec& t = get();
+        uint8_t *d = dest, *dend = dest + destsize;
+        for (const uint8_t* send = src + srcsize; src < send && *src != slip::stdcodes::SLIP_END; src++) {
+            if (d >= dend) return 0;
+            if (*src != slip::stdcodes::SLIP_ESC) {
+                *(d++) = *src;
+            } else {
+                if (++src >= send || !t.unescape[*src]) return 0;
+                *(d++) = t.unescape[*src];
+            }
+        }
+        return d - dest;
+    }
+};
+
+/** One row of counts per byte of payload, summed over reps runs of fn() */
+template <typename _Fn>
+void perf_row(perf_counters& perf, const char* name, const char* op, size_t size, int reps, _Fn fn) {
+    perf_counters::sample s = perf.measure([&] {
+        for (int r = 0; r < reps; r++) fn();
+    });
+    double bytes = static_cast<double>(size) * reps;
+    auto col     = [&](perf_counters::event e, double scale) {
+        if (s.valid[e]) cout << setw(12) << fixed << setprecision(2) << s.count[e] * scale / bytes;
+        else cout << setw(12) << "n/a";
+    };
+    cout << setw(12) << name << setw(8) << op;
+    col(perf_counters::cycles, 1);
+    if (s.valid[perf_counters::cycles] && s.valid[perf_counters::instructions] && s.count[perf_counters::cycles])
+        cout << setw(8) << fixed << setprecision(2) << double(s.count[perf_counters::instructions]) / s.count[perf_counters::cycles];
+    else cout << setw(8) << "n/a";
+    col(perf_counters::branch_misses, 1024);
+    col(perf_counters::l1d_misses, 1024);
+    col(perf_counters::llc_misses, 1024);
+    cout << endl;
+}
+
+void bench_perf(size_t size, int reps) {
+    using encoder = slip::encoder;
+    using decoder = slip::decoder;
+    perf_counters perf;
+    cout << "## Hardware counters, " << size << " byte payload" << endl << endl;
+    if (!perf.available()) {
+        cout << "perf events unavailable: " << perf.unavailable_reason() << endl << endl;
+        return;
+    }
+    const char* scalar = SLIP_UNROLL_LOOPS ? "unrolled" : "looped";
+    for (double density : {0.01, 0.10}) {
+        bytes payload = make_payload(size, density);
+        bytes frame(encoder::encoded_size(payload.data(), payload.size()));
+        bytes out(frame.size());
+        encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        cout << int(density * 100) << "% specials" << endl;
+        cout << setw(12) << "test_codes" << setw(8) << "" << setw(12) << "cycles/B" << setw(8) << "IPC"
+             << setw(12) << "brmiss/KB" << setw(12) << "L1Dmiss/KB" << setw(12) << "LLCmiss/KB" << endl;
+        perf_row(perf, scalar, "encode", size, reps, [&] { encoder::encode(out.data(), out.size(), payload.data(), size); });
+        perf_row(perf, scalar, "decode", size, reps, [&] { decoder::decode(out.data(), out.size(), frame.data(), frame.size()); });
+        perf_row(perf, "table", "encode", size, reps, [&] { table_codec::encode(out.data(), out.size(), payload.data(), size); });
+        perf_row(perf, "table", "decode", size, reps, [&] { table_codec::decode(out.data(), out.size(), frame.data(), frame.size()); });
+        for (int k = 1; k < static_cast<int>(slip::kernel_id::num_kernels); k++) {
+            slip::kernel_id kid = static_cast<slip::kernel_id>(k);
+            auto enc            = slip::kernels<encoder>::encode(kid);
+            auto dec            = slip::kernels<decoder>::decode(kid);
+            if (!slip::kernel_supported(kid) || !enc || !dec) continue;
+            perf_row(perf, slip::kernel_name(kid), "encode", size, reps, [&] { enc(out.data(), out.size(), payload.data(), size); });
+            perf_row(perf, slip::kernel_name(kid), "decode", size, reps, [&] { dec(out.data(), out.size(), frame.data(), frame.size()); });
+        }
+        cout << endl;
+    }
+}
+
+/**************************************************************************************
+ * MAIN
+ **************************************************************************************/
+
+int main(int argc, char* argv[]) {
+    size_t size = (argc > 1) ? strtoull(argv[1], NULL, 0) : (1 << 20);
+    int reps    = (argc > 2) ? atoi(argv[2]) : 10;
+    size_t nt_max = (argc > 3) ? strtoull(argv[3], NULL, 0) : (256 << 20);
+    bench_kernels(size, reps);
+    bench_nontemporal(nt_max, reps);
+    bench_alloc(reps);
+    bench_records(reps);
+    bench_logging(size, reps);
+    bench_stats(size, reps);
+    bench_perf(size, reps);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+/**
+ * Add a sidecar index to a raw SLIP capture, or print frames from an indexed one.
+ *
+ * capindex capture.slip               write capture.slip.idx
+ * capindex capture.slip first [last]  print frames [first, last], C-escaped
+ */
+
+#include <SlipCapture.h>
+#include <SlipUtils.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        fprintf(stderr, "usage: %s capture [first [last]]\n", argv[0]);
+        return 2;
+    }
+    std::string path = argv[1];
+    if (argc == 2) {
+        slip::mapped_file capture(path);
+        if (!capture.ok()) {
+            perror(argv[1]);
+            return 1;
+        }
+        std::vector<uint64_t> starts = slip::capture_index::build(capture.data(), capture.size());
+        if (!slip::capture_index::write(slip::capture_index::path_for(path), starts, capture.size())) {
+            perror(slip::capture_index::path_for(path).c_str());
+            return 1;
+        }
+        printf("%s: %zu frames, %zu bytes\n", slip::capture_index::path_for(path).c_str(), starts.size(), capture.size());
+        return 0;
+    }
+    slip::capture_reader<> capture(path);
+    if (!capture.is_open()) {
+        perror(argv[1]);
+        return 1;
+    }
+    size_t first = strtoull(argv[2], NULL, 0);
+    size_t last  = (argc > 3) ? strtoull(argv[3], NULL, 0) : first;
+    capture.decode_range(first, last + 1, [](size_t i, const uint8_t* data, size_t size) {
+        printf("%zu %s\n", i, size ? slip::escaped(data, size).c_str() : "(bad frame)");
+    });
+    return 0;
+}
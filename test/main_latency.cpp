@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+/**
+ * Frame latency over a pty loopback: one thread writes SLIP frames to the
+ * master side at a fixed rate, a reader thread moves bytes from the slave side
+ * into an spsc_ring, and the main thread takes frames from the ring.
+ *
+ * latency [frames] [payload-bytes] [interval-us] [chunk-bytes]
+ */
+
+#define SLIP_TRACE_EVENTS (1 << 16) // two events per frame on the main thread
+
+#include <SlipInPlace.h>
+#include <SlipRing.h>
+#include <SlipTrace.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+struct pty_link;
+using tracer = slip::frame_tracer<pty_link>;
+using ring   = slip::spsc_ring<1 << 16, slip::decoder, tracer>;
+
+static int open_pty(int& slave) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master)) return -1;
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0) return -1;
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    return master;
+}
+
+int main(int argc, char* argv[]) {
+    size_t nframes  = (argc > 1) ? strtoull(argv[1], NULL, 0) : 10000;
+    size_t payload  = (argc > 2) ? strtoull(argv[2], NULL, 0) : 64;
+    int interval_us = (argc > 3) ? atoi(argv[3]) : 100;
+    size_t chunk    = (argc > 4) ? strtoull(argv[4], NULL, 0) : 256;
+
+    int slave, master = open_pty(slave);
+    if (master < 0) {
+        perror("pty");
+        return 1;
+    }
+
+    static ring rx;
+    atomic<bool> done{false};
+    tracer::clear();
+
+    thread writer([&] {
+        vector<uint8_t> data(payload), frame(2 * payload + 1);
+        for (size_t i = 0; i < payload; i++) data[i] = static_cast<uint8_t>(i * 37);
+        for (size_t n = 0; n < nframes; n++) {
+            data[0]    = static_cast<uint8_t>(n);
+            size_t len = slip::encoder::encode(frame.data(), frame.size(), data.data(), data.size());
+            for (size_t at = 0; at < len;) {
+                ssize_t k = write(master, frame.data() + at, len - at);
+                if (k > 0) at += k;
+            }
+            this_thread::sleep_for(chrono::microseconds(interval_us));
+        }
+    });
+
+    thread reader([&] {
+        vector<uint8_t> buf(chunk);
+        struct pollfd p = {slave, POLLIN, 0};
+        while (!done.load(memory_order_relaxed)) {
+            if (poll(&p, 1, 10) <= 0) continue;
+            ssize_t k = read(slave, buf.data(), buf.size());
+            if (k > 0) rx.write(buf.data(), k);
+        }
+    });
+
+    size_t received = 0;
+    auto deadline   = chrono::steady_clock::now() + chrono::microseconds(interval_us) * nframes + chrono::seconds(5);
+    ring::frame f;
+    while (received < nframes && chrono::steady_clock::now() < deadline) {
+        if (rx.next(f)) {
+            received++;
+            rx.release(f);
+        }
+    }
+    done = true;
+    writer.join();
+    reader.join();
+    close(slave);
+    close(master);
+
+    cout << "## pty loopback, " << received << "/" << nframes << " frames of " << payload << " bytes every "
+         << interval_us << " us, reads of up to " << chunk << " bytes" << endl << endl;
+    tracer::report().print(cout);
+    return received == nframes ? 0 : 1;
+}
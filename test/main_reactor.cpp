@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+/**
+ * Round trips over many pty pairs: the main thread runs a reactor on the
+ * master sides that sends timestamped frames, and an echo thread sends every
+ * frame back from the slave sides, with a reactor (epoll or poll) or with the
+ * io_uring reader and blocking writes.
+ *
+ * reactor [pairs] [seconds] [payload-bytes] [window] [epoll|poll|uring]
+ */
+
+#include <SlipInPlace.h>
+#include <SlipReactor.h>
+#include <SlipTrace.h>
+#include <SlipUring.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+static int open_pty(int& slave) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master)) return -1;
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0) return -1;
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    return master;
+}
+
+static uint64_t now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void echo_reactor(const vector<int>& slaves, slip::reactor_backend backend, atomic<bool>& done) {
+    slip::reactor<> server(4096, backend);
+    for (int fd : slaves) server.add(fd, [&server](size_t ch, const uint8_t* frame, size_t size) { server.send(ch, frame, size); });
+    while (!done.load(memory_order_relaxed)) server.run_once(10);
+}
+
+static void echo_uring(const vector<int>& slaves, atomic<bool>& done) {
+    slip::uring_reader<> rx(slaves.size(), 4096);
+    for (int fd : slaves) rx.add(fd);
+    vector<uint8_t> out(2 * 4096 + 1);
+    slip::uring_reader<>::frame f;
+    while (!done.load(memory_order_relaxed)) {
+        rx.wait(10);
+        while (rx.next(f)) {
+            size_t n = slip::encoder::encode(out.data(), out.size(), f.data, f.size);
+            for (size_t at = 0; at < n;) {
+                ssize_t k = write(slaves[f.channel], out.data() + at, n - at);
+                if (k > 0) at += k;
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t pairs   = (argc > 1) ? strtoull(argv[1], NULL, 0) : 64;
+    double seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+    size_t payload = (argc > 3) ? strtoull(argv[3], NULL, 0) : 64;
+    size_t window  = (argc > 4) ? strtoull(argv[4], NULL, 0) : 1;
+    string mode    = (argc > 5) ? argv[5] : "epoll";
+    if (payload < sizeof(uint64_t)) payload = sizeof(uint64_t);
+
+    vector<int> masters, slaves;
+    for (size_t i = 0; i < pairs; i++) {
+        int slave, master = open_pty(slave);
+        if (master < 0) {
+            perror("pty");
+            return 1;
+        }
+        masters.push_back(master);
+        slaves.push_back(slave);
+    }
+    if (mode == "uring" && !slip::uring_reader<>(1).ok()) {
+        cerr << "io_uring is not available" << endl;
+        return 1;
+    }
+
+    atomic<bool> done{false};
+    thread echo([&] {
+        if (mode == "uring") echo_uring(slaves, done);
+        else echo_reactor(slaves, mode == "poll" ? slip::reactor_backend::poll : slip::reactor_backend::epoll, done);
+    });
+
+    slip::reactor<> client(4096);
+    vector<double> rtt;
+    rtt.reserve(1 << 20);
+    vector<uint8_t> frame(payload);
+    bool sending       = true;
+    size_t outstanding = 0;
+    auto send_one      = [&](size_t ch) {
+        uint64_t t = now_ns();
+        memcpy(frame.data(), &t, sizeof(t));
+        memcpy(frame.data() + sizeof(t), &ch, min(sizeof(ch), payload - sizeof(t)));
+        if (client.send(ch, frame.data(), frame.size())) outstanding++;
+    };
+    for (int fd : masters) {
+        client.add(fd, [&](size_t ch, const uint8_t* data, size_t size) {
+            uint64_t t;
+            if (size < sizeof(t)) return;
+            memcpy(&t, data, sizeof(t));
+            rtt.push_back(static_cast<double>(now_ns() - t));
+            outstanding--;
+            if (sending) send_one(ch);
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (size_t ch = 0; ch < pairs; ch++)
+        for (size_t w = 0; w < window; w++) send_one(ch);
+    auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+    while (chrono::steady_clock::now() < deadline) client.run_once(10);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t counted = rtt.size();
+    sending        = false;
+    auto drain     = chrono::steady_clock::now() + chrono::seconds(1);
+    while (outstanding && chrono::steady_clock::now() < drain) client.run_once(10);
+    done = true;
+    echo.join();
+    for (size_t i = 0; i < pairs; i++) {
+        close(masters[i]);
+        close(slaves[i]);
+    }
+
+    rtt.resize(counted);
+    slip::latency_stats s;
+    s.set(rtt);
+    cout << "## " << pairs << " pty pairs, " << mode << " echo, " << payload << "-byte frames, window " << window << endl
+         << endl;
+    cout << fixed << setprecision(0) << "round trips/s: " << counted / elapsed << endl;
+    cout << setprecision(1) << "round trip us: p50 " << s.p50 / 1e3 << "  p90 " << s.p90 / 1e3 << "  p99 " << s.p99 / 1e3
+         << "  p99.9 " << s.p999 / 1e3 << "  max " << s.max / 1e3 << endl;
+    return counted ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+/**
+ * Scaling of the sharded scheduler: both ends of N socket pairs are channels
+ * of one scheduler, and every frame received is hashed a number of times and
+ * sent back, so window frames per pair ping-pong until the time is up. Each
+ * frame carries a sequence number per channel, and frames handled out of order
+ * are counted. Runs with 1, 2, 4, ... workers up to max-workers.
+ *
+ * scheduler [pairs] [seconds] [work] [window] [max-workers] [payload-bytes] [nopin]
+ */
+
+#include <SlipInPlace.h>
+#include <SlipScheduler.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // per channel, touched only by the task of the channel
+    struct peer {
+        uint64_t next_send = 0;
+        uint64_t next_recv = 0;
+        uint64_t hash      = 0;
+        vector<uint8_t> frame;
+        char pad[64];
+    };
+
+    struct result {
+        double frames_per_s;
+        uint64_t steals;
+        uint64_t out_of_order;
+        bool pinned;
+    };
+
+    uint64_t hash_rounds(const uint8_t* data, size_t size, size_t rounds) {
+        uint64_t h = 14695981039346656037ull;
+        for (size_t r = 0; r < rounds; r++)
+            for (size_t i = 0; i < size; i++) h = (h ^ data[i]) * 1099511628211ull;
+        return h;
+    }
+
+    result run(size_t workers, size_t pairs, double seconds, size_t work, size_t window, size_t payload, bool pin) {
+        vector<array<int, 2>> fds(pairs);
+        for (auto& p : fds) {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, p.data())) {
+                perror("socketpair");
+                exit(1);
+            }
+        }
+        slip::scheduler<> s(2 * pairs, workers, 4096);
+        vector<peer> peers(2 * pairs);
+        atomic<uint64_t> out_of_order{0};
+        for (size_t i = 0; i < 2 * pairs; i++) {
+            peers[i].frame.resize(payload);
+            int ch = s.add(fds[i / 2][i % 2], [&](size_t ch, const uint8_t* data, size_t size) {
+                peer& p = peers[ch];
+                uint64_t seq;
+                if (size < sizeof(seq)) return;
+                memcpy(&seq, data, sizeof(seq));
+                if (seq != p.next_recv) out_of_order++;
+                p.next_recv = seq + 1;
+                p.hash += hash_rounds(data, size, work);
+                memcpy(p.frame.data(), &p.next_send, sizeof(seq));
+                p.next_send++;
+                s.send(ch, p.frame.data(), p.frame.size());
+            });
+            if (ch < 0) {
+                cerr << "cannot add channel " << i << endl;
+                exit(1);
+            }
+        }
+        for (size_t i = 0; i < 2 * pairs; i += 2) { // start the ping-pong from one end of each pair
+            for (size_t w = 0; w < window; w++) {
+                memcpy(peers[i].frame.data(), &peers[i].next_send, sizeof(uint64_t));
+                peers[i].next_send++;
+                s.send(i, peers[i].frame.data(), peers[i].frame.size());
+            }
+        }
+
+        auto total = [&] {
+            uint64_t n = 0;
+            for (size_t ch = 0; ch < 2 * pairs; ch++) n += s.frames(ch);
+            return n;
+        };
+        s.start(pin);
+        this_thread::sleep_for(chrono::milliseconds(100)); // warm up
+        uint64_t n0 = total();
+        auto t0     = chrono::steady_clock::now();
+        this_thread::sleep_for(chrono::duration<double>(seconds));
+        uint64_t n1    = total();
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        s.stop();
+
+        result r;
+        r.frames_per_s = (n1 - n0) / elapsed;
+        r.steals       = 0;
+        for (size_t w = 0; w < s.workers(); w++) r.steals += s.steals(w);
+        r.out_of_order = out_of_order;
+        r.pinned       = s.pinned();
+        for (auto& p : fds) {
+            close(p[0]);
+            close(p[1]);
+        }
+        return r;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t pairs   = (argc > 1) ? strtoull(argv[1], NULL, 0) : 256;
+    double seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+    size_t work    = (argc > 3) ? strtoull(argv[3], NULL, 0) : 16;
+    size_t window  = (argc > 4) ? strtoull(argv[4], NULL, 0) : 4;
+    size_t maxw    = (argc > 5) ? strtoull(argv[5], NULL, 0) : thread::hardware_concurrency();
+    size_t payload = (argc > 6) ? strtoull(argv[6], NULL, 0) : 64;
+    bool pin       = !(argc > 7 && string(argv[7]) == "nopin");
+    if (maxw == 0) maxw = 1;
+    if (payload < sizeof(uint64_t)) payload = sizeof(uint64_t);
+
+    cout << "## Sharded scheduler, " << pairs << " socket pairs, " << payload << "-byte frames, window " << window
+         << ", " << work << " hash rounds per frame, " << thread::hardware_concurrency() << " CPUs" << endl
+         << endl;
+    cout << setw(8) << "workers" << setw(12) << "kframes/s" << setw(9) << "speedup" << setw(10) << "steals"
+         << setw(14) << "out of order" << setw(8) << "pinned" << endl;
+    double base = 0;
+    int status  = 0;
+    for (size_t w = 1;; w = (2 * w > maxw && w < maxw) ? maxw : 2 * w) {
+        result r = run(w, pairs, seconds, work, window, payload, pin);
+        if (w == 1) base = r.frames_per_s;
+        cout << setw(8) << w << fixed << setprecision(0) << setw(12) << r.frames_per_s / 1e3 << setprecision(2)
+             << setw(9) << (base ? r.frames_per_s / base : 0) << setw(10) << r.steals << setw(14) << r.out_of_order
+             << setw(8) << (r.pinned ? "yes" : "no") << endl;
+        if (r.out_of_order) status = 1;
+        if (w >= maxw) break;
+    }
+    return status;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+/**
+ * Frames from one process to consumer processes: through a shared-memory ring
+ * that consumers read in place, and through one pipe per consumer, written in
+ * 64 KB batches. Consumers either decode every frame, or only count frames,
+ * which leaves the cost of the transport itself.
+ *
+ * shmring [frames] [payload-bytes] [consumers] [notify-batch]
+ */
+
+#include <SlipInPlace.h>
+#include <SlipShm.h>
+#include <SlipStream.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    struct tally {
+        uint64_t frames = 0;
+        uint64_t bytes  = 0;
+    };
+
+    vector<vector<uint8_t>> make_payloads(size_t size) {
+        mt19937 rng(7);
+        vector<vector<uint8_t>> p(256, vector<uint8_t>(size));
+        for (auto& v : p)
+            for (auto& c : v) c = (rng() % 100 == 0) ? 0xC0 : static_cast<uint8_t>(rng()); // about 1% specials
+        return p;
+    }
+
+    // fork a consumer that runs body() and sends back its tally; returns the read end of its result pipe
+    template <typename _Fn>
+    int spawn(vector<pid_t>& children, _Fn body) {
+        int p[2];
+        if (pipe(p)) exit(1);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(p[0]);
+            tally t = body(p[1]);
+            ssize_t k = write(p[1], &t, sizeof(t));
+            _exit(k == sizeof(t) ? 0 : 1);
+        }
+        close(p[1]);
+        char ready;
+        if (read(p[0], &ready, 1) != 1) exit(1); // the consumer is set up
+        children.push_back(pid);
+        return p[0];
+    }
+
+    void collect(vector<pid_t>& children, vector<int>& results, tally& total) {
+        for (size_t c = 0; c < children.size(); c++) {
+            tally t;
+            if (read(results[c], &t, sizeof(t)) == sizeof(t)) {
+                total.frames += t.frames;
+                total.bytes += t.bytes;
+            }
+            close(results[c]);
+            waitpid(children[c], nullptr, 0);
+        }
+    }
+
+    void report(const char* name, bool decode, const tally& t, double s, size_t consumers, uint64_t wakeups) {
+        cout << setw(10) << name << setw(10) << (decode ? "decode" : "count") << fixed << setprecision(2) << setw(12) << t.frames / consumers / s / 1e6
+             << setprecision(0) << setw(12) << t.bytes / consumers / s / 1e6 << setw(10) << wakeups << endl;
+    }
+
+    void run_shm(const vector<vector<uint8_t>>& payloads, size_t nframes, size_t consumers, size_t batch, bool decode) {
+        slip::shm_producer<> tx(nullptr, 1 << 20, consumers);
+        if (!tx.ok()) {
+            cerr << "shared memory ring not available" << endl;
+            return;
+        }
+        tx.set_notify_batch(batch);
+        vector<pid_t> children;
+        vector<int> results;
+        size_t maxsize = payloads[0].size();
+        for (size_t c = 0; c < consumers; c++) {
+            results.push_back(spawn(children, [&](int out) {
+                slip::shm_consumer<> rx(tx.fd());
+                vector<uint8_t> buf(maxsize);
+                tally t;
+                char ready = 1;
+                if (write(out, &ready, 1) != 1 || !rx.ok()) return t;
+                slip::shm_consumer<>::frame f;
+                while (rx.wait(-1)) {
+                    while (rx.next(f)) {
+                        t.bytes += decode ? f.decode(buf.data(), buf.size()) : f.size;
+                        t.frames++;
+                    }
+                    rx.release(f);
+                }
+                return t;
+            }));
+        }
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < nframes; i++) {
+            const vector<uint8_t>& p = payloads[i & 255];
+            tx.publish_wait(p.data(), p.size());
+        }
+        tx.close();
+        tally total;
+        collect(children, results, total);
+        double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        report("shm", decode, total, s, consumers, tx.wakeups());
+    }
+
+    void run_pipe(const vector<vector<uint8_t>>& payloads, size_t nframes, size_t consumers, bool decode) {
+        vector<pid_t> children;
+        vector<int> results, pipes;
+        for (size_t c = 0; c < consumers; c++) {
+            int p[2];
+            if (pipe(p)) exit(1);
+            results.push_back(spawn(children, [&](int out) {
+                for (int fd : pipes) close(fd);
+                close(p[1]);
+                vector<uint8_t> chunk(1 << 16);
+                slip::stream_decoder<> dec;
+                tally t;
+                char ready = 1;
+                if (write(out, &ready, 1) != 1) return t;
+                ssize_t k;
+                while ((k = read(p[0], chunk.data(), chunk.size())) > 0) {
+                    if (decode) {
+                        t.bytes += dec.decode(chunk.data(), chunk.data(), k); // in place, in its own copy
+                        continue;
+                    }
+                    t.bytes += k;
+                    for (const uint8_t *q = chunk.data(), *e = q + k; (q = static_cast<const uint8_t*>(memchr(q, 0xC0, e - q))); q++)
+                        t.frames++;
+                }
+                if (decode) t.frames = dec.frames();
+                return t;
+            }));
+            close(p[0]);
+            pipes.push_back(p[1]);
+        }
+        auto start = chrono::steady_clock::now();
+        vector<uint8_t> batch(1 << 16);
+        size_t used = 0;
+        auto flush = [&] {
+            for (int fd : pipes)
+                for (size_t at = 0; at < used;) {
+                    ssize_t k = write(fd, batch.data() + at, used - at);
+                    if (k <= 0) exit(1);
+                    at += k;
+                }
+            used = 0;
+        };
+        for (size_t i = 0; i < nframes; i++) {
+            const vector<uint8_t>& p = payloads[i & 255];
+            if (batch.size() - used < 2 * p.size() + 1) flush();
+            used += slip::encoder::encode(batch.data() + used, batch.size() - used, p.data(), p.size());
+        }
+        flush();
+        for (int fd : pipes) close(fd);
+        tally total;
+        collect(children, results, total);
+        double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        report("pipe", decode, total, s, consumers, 0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t nframes   = (argc > 1) ? strtoull(argv[1], NULL, 0) : 2000000;
+    size_t payload   = (argc > 2) ? strtoull(argv[2], NULL, 0) : 256;
+    size_t consumers = (argc > 3) ? strtoull(argv[3], NULL, 0) : 2;
+    size_t batch     = (argc > 4) ? strtoull(argv[4], NULL, 0) : 256;
+    if (payload == 0) payload = 1;
+    if (consumers == 0) consumers = 1;
+    auto payloads = make_payloads(payload);
+
+    cout << "## " << nframes << " frames of " << payload << " bytes to " << consumers
+         << " consumer processes, per consumer" << endl
+         << endl;
+    cout << setw(10) << "transport" << setw(10) << "consumer" << setw(12) << "Mframes/s" << setw(12) << "MB/s" << setw(10) << "wakeups" << endl;
+    for (bool decode : {true, false}) {
+        run_shm(payloads, nframes, consumers, batch, decode);
+        run_pipe(payloads, nframes, consumers, decode);
+    }
+    return 0;
+}
@@ -0,0 +1,606 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+/**
+ * Encode or decode stdin to stdout.
+ *
+ * sipcat [-e|-d] [-n | -c codes] [-l | -s frame-bytes] [-b chunk-bytes] [-j] [-z] [-v]
+ *
+ *   -e      encode (default): all of stdin is one frame
+ *   -d      decode: frames are written back to back
+ *   -n      SLIP+NULL instead of standard SLIP
+ *   -c      custom codes END,ESCEND,ESC,ESCESC[,NULL,ESCNULL], in the order of
+ *           the codec template parameters. A single character stands for
+ *           itself, anything longer is a number (0xC0)
+ *   -l      encode each line as a frame, or write a newline after each frame
+ *   -s      encode frames of up to this many bytes
+ *   -b      read chunk size (default 1 MiB)
+ *   -j      read, transform and write on separate threads
+ *   -z      output to a pipe with vmsplice() instead of write()
+ *   -v      print throughput and frame counts to stderr
+ *
+ * Regular input files are mapped instead of read. With -z, the pipe takes
+ * references to the pages of the output buffers instead of copying them.
+ * Those references outlive the pipe when the reader splices them on, so a
+ * spliced buffer is gifted to the pipe, unmapped and never written again:
+ * each chunk costs a fresh buffer and its page faults, which pays off only
+ * for large chunks and readers that splice.
+ */
+
+#define SLIP_RUNTIME_DISPATCH 1
+
+#include <SlipInPlace.h>
+#include <SlipStream.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+struct options {
+    bool decode  = false;
+    bool lines   = false;
+    bool threads = false;
+    bool verbose = false;
+    bool splice  = false; // -z
+    size_t frame = 0;     // -s
+    size_t chunk = 1 << 20;
+};
+
+/**************************************************************************************
+ * Custom codes
+ **************************************************************************************/
+
+/** Codec with codes chosen at run time, table-driven since the kernels need them at compile time. */
+struct custom_codes {
+    using char_type = uint8_t;
+    enum { END, ESCEND, ESC, ESCESC, NUL, ESCNUL }; // template parameter order
+
+    static uint8_t codes[6];
+    static int num_specials;
+    static int16_t special[256]; // index of a special character or -1
+    static int16_t escaped[256]; // index of an escaped code or -1
+
+    static uint8_t end_code() noexcept { return codes[END]; }
+    static uint8_t esc_code() noexcept { return codes[ESC]; }
+
+    /** Parse END,ESCEND,ESC,ESCESC[,NULL,ESCNULL]. */
+    static bool parse(const char* arg) {
+        int n = 0;
+        for (const char* p = arg; *p && n < 6; n++) {
+            const char* comma = strchr(p, ',');
+            size_t len        = comma ? comma - p : strlen(p);
+            if (len == 1) {
+                codes[n] = static_cast<uint8_t>(*p);
+            } else {
+                string s(p, len);
+                char* end;
+                unsigned long v = strtoul(s.c_str(), &end, 0);
+                if (len == 0 || *end || v > 255) return false;
+                codes[n] = static_cast<uint8_t>(v);
+            }
+            p += len + (comma ? 1 : 0);
+        }
+        if (n != 4 && n != 6) return false;
+        num_specials = n / 2;
+        for (int c = 0; c < 256; c++) special[c] = escaped[c] = -1;
+        for (int i = 0; i < num_specials; i++) {
+            if (special[codes[2 * i]] >= 0 || escaped[codes[2 * i + 1]] >= 0) return false; // duplicates
+            special[codes[2 * i]]     = i;
+            escaped[codes[2 * i + 1]] = i;
+        }
+        // the escaped codes follow ESC inside a frame, so they cannot be END or ESC
+        return escaped[end_code()] < 0 && escaped[esc_code()] < 0;
+    }
+};
+
+uint8_t custom_codes::codes[6];
+int custom_codes::num_specials;
+int16_t custom_codes::special[256];
+int16_t custom_codes::escaped[256];
+
+struct custom_encoder : custom_codes {
+    static size_t encode(uint8_t* dest, size_t destsize, const uint8_t* src, size_t srcsize) noexcept {
+        uint8_t* dstart = dest;
+        uint8_t* dend   = dest + destsize;
+        for (const uint8_t* send = src + srcsize; src < send; src++) {
+            int isp = special[*src];
+            if (isp < 0) {
+                if (dest >= dend) return 0;
+                *(dest++) = *src;
+            } else {
+                if (dest + 1 >= dend) return 0;
+                *(dest++) = esc_code();
+                *(dest++) = codes[2 * isp + 1];
+            }
+        }
+        if (dest >= dend) return 0;
+        *(dest++) = end_code();
+        return dest - dstart;
+    }
+};
+
+struct custom_decoder : custom_codes {
+    static size_t decode(uint8_t* dest, size_t destsize, const uint8_t* src, size_t srcsize) noexcept {
+        uint8_t* dstart      = dest;
+        uint8_t* dend        = dest + destsize;
+        const uint8_t* send  = src + srcsize;
+        while (src < send) {
+            if (*src == end_code()) break;
+            if (dest >= dend) return 0;
+            if (*src != esc_code()) {
+                *(dest++) = *(src++);
+            } else {
+                if (++src >= send) return 0;
+                int isp = escaped[*(src++)];
+                if (isp < 0) return 0;
+                *(dest++) = codes[2 * isp];
+            }
+        }
+        return dest - dstart;
+    }
+};
+
+/**************************************************************************************
+ * Buffers
+ **************************************************************************************/
+
+static const size_t buffer_align = 2 << 20; // lets the kernel back buffers with huge pages
+
+/** Mapped rather than allocated, so that a buffer spliced to a pipe can be unmapped. */
+static uint8_t* alloc_buffer(size_t size) {
+    size    = (size + buffer_align - 1) & ~(buffer_align - 1);
+    void* m = mmap(nullptr, size + buffer_align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) return nullptr;
+    uint8_t* p = static_cast<uint8_t*>(m);
+    uint8_t* a = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(p) + buffer_align - 1) & ~(buffer_align - 1));
+    if (a > p) munmap(p, a - p);
+    munmap(a + size, p + buffer_align - a);
+    madvise(a, size, MADV_HUGEPAGE);
+    return a;
+}
+
+static void free_buffer(uint8_t* p, size_t size) {
+    if (p) munmap(p, (size + buffer_align - 1) & ~(buffer_align - 1));
+}
+
+/** Blocking queue between pipeline stages. */
+template <typename T>
+class channel {
+ public:
+    void push(T v) {
+        {
+            lock_guard<mutex> lock(_m);
+            _q.push_back(v);
+        }
+        _cv.notify_one();
+    }
+    T pop() {
+        unique_lock<mutex> lock(_m);
+        _cv.wait(lock, [this] { return !_q.empty(); });
+        T v = _q.front();
+        _q.pop_front();
+        return v;
+    }
+
+ private:
+    mutex _m;
+    condition_variable _cv;
+    deque<T> _q;
+};
+
+/**************************************************************************************
+ * Input
+ **************************************************************************************/
+
+/** stdin, mapped if it is a regular file, read otherwise. */
+class source {
+ public:
+    explicit source(int fd) : _fd(fd) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                _map  = static_cast<const uint8_t*>(p);
+                _size = st.st_size;
+                _pos  = lseek(fd, 0, SEEK_CUR);
+                if (_pos > _size) _pos = _size;
+                madvise(p, _size, MADV_SEQUENTIAL);
+            }
+        } else if (S_ISFIFO(st.st_mode)) {
+            fcntl(fd, F_SETPIPE_SZ, 1 << 20); // larger reads, if allowed
+        }
+    }
+    ~source() {
+        if (_map) munmap(const_cast<uint8_t*>(_map), _size);
+    }
+
+    bool mapped() const noexcept { return _map != nullptr; }
+
+    /**
+     * @brief Next chunk of at most n bytes: a window of the mapping, or read into buf.
+     * @return bytes, 0 at the end, -1 on errors
+     */
+    ssize_t next(uint8_t* buf, size_t n, const uint8_t*& data) {
+        if (_map) {
+            n    = min(n, _size - _pos);
+            data = _map + _pos;
+            _pos += n;
+            return n;
+        }
+        data = buf;
+        for (;;) {
+            ssize_t k = read(_fd, buf, n);
+            if (k >= 0 || errno != EINTR) return k;
+        }
+    }
+
+    /** Fault in a window ahead of the transform, on the reader thread. */
+    static void prefault(const uint8_t* data, size_t n) {
+        volatile uint8_t sink = 0;
+        for (size_t i = 0; i < n; i += 4096) sink = sink + data[i];
+    }
+
+    /** Done with a window of the mapping. */
+    void release(const uint8_t* data, size_t n) {
+        if (!_map || n == 0) return;
+        uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~uintptr_t(4095);
+        uintptr_t end   = (reinterpret_cast<uintptr_t>(data) + n) & ~uintptr_t(4095);
+        if (end > start) madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED);
+    }
+
+ private:
+    int _fd;
+    const uint8_t* _map = nullptr;
+    size_t _size        = 0;
+    size_t _pos         = 0;
+};
+
+/**************************************************************************************
+ * Output
+ **************************************************************************************/
+
+/**
+ * @brief stdout, through write(), or through vmsplice() when asked to and it is a pipe.
+ *
+ * A spliced buffer stays referenced by the pipe, and by wherever the reader
+ * splices it on, for an unknown time. It is never handed back: the sink
+ * unmaps it and hands back a fresh buffer of buffer_size bytes instead.
+ */
+class sink {
+ public:
+    sink(int fd, bool splice, size_t buffer_size) : _fd(fd), _buffer_size(buffer_size) {
+        struct stat st;
+        if (splice && fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+            fcntl(fd, F_SETPIPE_SZ, 1 << 20);
+            _splice = true;
+        }
+    }
+
+    bool splicing() const noexcept { return _splice; }
+
+    /**
+     * @brief Send n bytes of buf.
+     * @param done      called as done(b) with the buffer to use next in place of buf
+     * @return false on errors
+     */
+    template <typename _Fn>
+    bool push(uint8_t* buf, size_t n, _Fn done) {
+        if (!_splice) {
+            bool ok = write_all(buf, n);
+            done(buf);
+            return ok;
+        }
+        bool ok       = splice_all(buf, n);
+        uint8_t* next = alloc_buffer(_buffer_size);
+        if (!next) {
+            done(buf); // out of memory: the output is abandoned anyway
+            return false;
+        }
+        free_buffer(buf, _buffer_size); // the pipe holds its own references to the pages
+        done(next);
+        return ok;
+    }
+
+ private:
+    bool splice_all(uint8_t* buf, size_t n) {
+        struct iovec iov = {buf, n};
+        while (iov.iov_len) {
+            ssize_t k = vmsplice(_fd, &iov, 1, SPLICE_F_GIFT);
+            if (k < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EINVAL && errno != ENOSYS) return false;
+                _splice = false; // not allowed here: write the rest
+                return write_all(static_cast<uint8_t*>(iov.iov_base), iov.iov_len);
+            }
+            iov.iov_base = static_cast<uint8_t*>(iov.iov_base) + k;
+            iov.iov_len -= k;
+        }
+        return true;
+    }
+
+    bool write_all(const uint8_t* buf, size_t n) {
+        while (n) {
+            ssize_t k = write(_fd, buf, n);
+            if (k < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            buf += k;
+            n -= k;
+        }
+        return true;
+    }
+
+    int _fd;
+    size_t _buffer_size;
+    bool _splice = false;
+};
+
+/**************************************************************************************
+ * Transform
+ **************************************************************************************/
+
+template <class ENCODER, class DECODER>
+class transform {
+ public:
+    explicit transform(const options& opt) : _opt(opt) {}
+
+    /** Output room needed for an input chunk of n bytes. */
+    static size_t max_output(const options& opt, size_t n) noexcept {
+        if (opt.decode) return n + 1;
+        return slip::stream_encoder<ENCODER>::max_encoded_size(n) + (opt.frame ? n / opt.frame + 1 : 0) + 2;
+    }
+
+    size_t run(uint8_t* out, size_t room, const uint8_t* in, size_t n) {
+        if (_opt.decode) {
+            if (!_opt.lines) return _dec.decode(out, in, n);
+            return _dec.decode(out, in, n, [](uint8_t* at) {
+                *at = '\n';
+                return size_t(1);
+            });
+        }
+        uint8_t* o = out;
+        if (_opt.frame) {
+            while (n) {
+                size_t k = min(n, _opt.frame - _in_frame);
+                o += _enc.encode(o, out + room - o, in, k);
+                in += k;
+                n -= k;
+                if ((_in_frame += k) == _opt.frame) {
+                    o += _enc.end(o);
+                    _in_frame = 0;
+                }
+            }
+        } else if (_opt.lines) {
+            while (n) {
+                const uint8_t* nl = static_cast<const uint8_t*>(memchr(in, '\n', n));
+                size_t k          = nl ? nl - in : n;
+                o += _enc.encode(o, out + room - o, in, k);
+                if (!nl) break;
+                o += _enc.end(o);
+                in += k + 1;
+                n -= k + 1;
+            }
+        } else {
+            o += _enc.encode(o, room, in, n);
+        }
+        return o - out;
+    }
+
+    /** End of input. */
+    size_t finish(uint8_t* out) {
+        if (_opt.decode) {
+            if (!_opt.lines) return _dec.finish(out);
+            return _dec.finish(out, [](uint8_t* at) {
+                *at = '\n';
+                return size_t(1);
+            });
+        }
+        if (_opt.frame || _opt.lines) return _enc.in_frame() ? _enc.end(out) : 0;
+        return _enc.end(out);
+    }
+
+    uint64_t frames() const noexcept { return _opt.decode ? _dec.frames() : _enc.frames(); }
+    uint64_t errors() const noexcept { return _dec.errors(); }
+
+ private:
+    const options& _opt;
+    slip::stream_encoder<ENCODER> _enc;
+    slip::stream_decoder<DECODER> _dec;
+    size_t _in_frame = 0;
+};
+
+/**************************************************************************************
+ * Pipeline
+ **************************************************************************************/
+
+struct chunk {
+    uint8_t* buf;
+    const uint8_t* data;
+    ssize_t size; // 0 at the end, -1 on a read error
+};
+
+struct result {
+    uint64_t in = 0, out = 0, frames = 0, errors = 0;
+    bool read_error = false, write_error = false;
+};
+
+template <class ENCODER, class DECODER>
+static result run_single(const options& opt, source& in, sink& out) {
+    transform<ENCODER, DECODER> xf(opt);
+    size_t room    = xf.max_output(opt, opt.chunk);
+    uint8_t* o     = alloc_buffer(room);
+    uint8_t* inbuf = in.mapped() ? nullptr : alloc_buffer(opt.chunk);
+    auto done      = [&o](uint8_t* b) { o = b; };
+    result r;
+    for (;;) {
+        const uint8_t* data;
+        ssize_t n = in.next(inbuf, opt.chunk, data);
+        if (n < 0) r.read_error = true;
+        size_t m = (n > 0) ? xf.run(o, room, data, n) : xf.finish(o);
+        in.release(data, n > 0 ? n : 0);
+        r.in += n > 0 ? n : 0;
+        r.out += m;
+        if (m && !out.push(o, m, done)) {
+            r.write_error = true;
+            break;
+        }
+        if (n <= 0) break;
+    }
+    r.frames = xf.frames();
+    r.errors = xf.errors();
+    free_buffer(o, room);
+    free_buffer(inbuf, opt.chunk);
+    return r;
+}
+
+template <class ENCODER, class DECODER>
+static result run_threads(const options& opt, source& in, sink& out) {
+    transform<ENCODER, DECODER> xf(opt);
+    size_t room = xf.max_output(opt, opt.chunk);
+    channel<uint8_t*> in_free, out_free;
+    channel<chunk> in_full, out_full;
+    const int nbufs = 3; // one being filled, one queued, one being written
+    for (int i = 0; i < nbufs; i++) {
+        out_free.push(alloc_buffer(room));
+        in_free.push(in.mapped() ? nullptr : alloc_buffer(opt.chunk));
+    }
+    result r;
+
+    thread reader([&] {
+        for (;;) {
+            chunk c;
+            c.buf  = in_free.pop();
+            c.size = in.next(c.buf, opt.chunk, c.data);
+            if (in.mapped() && c.size > 0) source::prefault(c.data, c.size);
+            in_full.push(c);
+            if (c.size <= 0) break;
+        }
+    });
+
+    thread writer([&] {
+        auto done = [&out_free](uint8_t* b) { out_free.push(b); };
+        bool failed = false;
+        for (;;) {
+            chunk c = out_full.pop();
+            if (c.size <= 0) break;
+            if (failed || !out.push(c.buf, c.size, done)) {
+                failed = true; // keep draining so the transform does not block
+                done(c.buf);
+            }
+        }
+        r.write_error = failed;
+    });
+
+    for (;;) {
+        chunk c    = in_full.pop();
+        uint8_t* o = out_free.pop();
+        size_t m   = (c.size > 0) ? xf.run(o, room, c.data, c.size) : xf.finish(o);
+        in.release(c.data, c.size > 0 ? c.size : 0);
+        in_free.push(c.buf);
+        r.in += c.size > 0 ? c.size : 0;
+        r.out += m;
+        if (m) out_full.push({o, o, static_cast<ssize_t>(m)});
+        else out_free.push(o);
+        if (c.size <= 0) {
+            r.read_error = c.size < 0;
+            out_full.push({nullptr, nullptr, 0});
+            break;
+        }
+    }
+    reader.join();
+    writer.join();
+    r.frames = xf.frames();
+    r.errors = xf.errors();
+    for (int i = 0; i < nbufs; i++) { // every buffer is back, spliced ones replaced
+        free_buffer(out_free.pop(), room);
+        free_buffer(in_free.pop(), opt.chunk);
+    }
+    return r;
+}
+
+/**************************************************************************************
+ * Main
+ **************************************************************************************/
+
+static int usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [-e|-d] [-n | -c END,ESCEND,ESC,ESCESC[,NULL,ESCNULL]] [-l | -s frame-bytes] "
+            "[-b chunk-bytes] [-j] [-z] [-v]\n",
+            argv0);
+    return 2;
+}
+
+template <class ENCODER, class DECODER>
+static int run(const options& opt, const char* kernel) {
+    source in(STDIN_FILENO);
+    sink out(STDOUT_FILENO, opt.splice, transform<ENCODER, DECODER>::max_output(opt, opt.chunk));
+    auto start = chrono::steady_clock::now();
+    result r   = opt.threads ? run_threads<ENCODER, DECODER>(opt, in, out) : run_single<ENCODER, DECODER>(opt, in, out);
+    double s   = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (r.read_error) perror("sipcat: read");
+    if (r.write_error) perror("sipcat: write");
+    if (opt.verbose) {
+        fprintf(stderr, "sipcat: %s %llu -> %llu bytes, %llu frames in %.3f s, %.0f MB/s in (%s, %s%s%s)\n",
+                opt.decode ? "decoded" : "encoded", (unsigned long long)r.in, (unsigned long long)r.out,
+                (unsigned long long)r.frames, s, s > 0 ? r.in / s / 1e6 : 0.0, kernel, in.mapped() ? "mmap" : "read",
+                out.splicing() ? ", vmsplice" : ", write", opt.threads ? ", threads" : "");
+    }
+    if (r.errors) fprintf(stderr, "sipcat: dropped %llu frames with bad escapes\n", (unsigned long long)r.errors);
+    return (r.read_error || r.write_error || r.errors) ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    options opt;
+    int codes = 0; // standard, null, custom
+    int c;
+    while ((c = getopt(argc, argv, "ednc:ls:b:jzv")) != -1) {
+        switch (c) {
+            case 'e': opt.decode = false; break;
+            case 'd': opt.decode = true; break;
+            case 'n': codes = 1; break;
+            case 'c':
+                if (!custom_codes::parse(optarg)) {
+                    fprintf(stderr, "%s: bad codes '%s'\n", argv[0], optarg);
+                    return 2;
+                }
+                codes = 2;
+                break;
+            case 'l': opt.lines = true; break;
+            case 's': opt.frame = strtoull(optarg, NULL, 0); break;
+            case 'b': opt.chunk = strtoull(optarg, NULL, 0); break;
+            case 'j': opt.threads = true; break;
+            case 'z': opt.splice = true; break;
+            case 'v': opt.verbose = true; break;
+            default: return usage(argv[0]);
+        }
+    }
+    if (optind != argc || opt.chunk == 0 || (opt.lines && opt.frame)) return usage(argv[0]);
+    if (opt.decode && opt.frame) return usage(argv[0]);
+
+    switch (codes) {
+        case 0:
+            return run<slip::encoder, slip::decoder>(
+                opt, slip::kernel_name(opt.decode ? slip::decoder::active() : slip::encoder::active()));
+        case 1:
+            return run<slip::null_encoder, slip::null_decoder>(
+                opt, slip::kernel_name(opt.decode ? slip::null_decoder::active() : slip::null_encoder::active()));
+        default:
+            return run<custom_encoder, custom_decoder>(opt, "table");
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+/**
+ * Print a trace file written by slip::trace_logger, one frame per line.
+ *
+ * traceview file.trace
+ */
+
+#include <SlipTraceLog.h>
+#include <stdio.h>
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s file.trace\n", argv[0]);
+        return 2;
+    }
+    FILE* f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    slip::trace_reader in(f);
+    slip::trace_record r;
+    size_t n = 0;
+    while (in.next(r)) {
+        puts(slip::trace_reader::format(r).c_str());
+        n++;
+    }
+    fclose(f);
+    if (!in.good()) {
+        fprintf(stderr, "%s: not a trace file, or damaged after %zu records\n", argv[1], n);
+        return 1;
+    }
+    return 0;
+}
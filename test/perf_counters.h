@@ -0,0 +1,133 @@
+/** Hardware performance counters for the benchmarks, through Linux perf_event_open */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef __PERF_COUNTERS_H__
+    #define __PERF_COUNTERS_H__
+
+    #if defined(__linux__)
+        #include <errno.h>
+        #include <linux/perf_event.h>
+        #include <sys/ioctl.h>
+        #include <sys/syscall.h>
+        #include <unistd.h>
+        #define PERF_COUNTERS_LINUX 1
+    #else
+        #define PERF_COUNTERS_LINUX 0
+    #endif
+
+/**
+ * @brief User-space cycles, instructions, branch misses, L1D and LLC read
+ * misses of the calling thread, counted as one group.
+ *
+ * Events the kernel or CPU refuses are left out, and when none can be opened
+ * (containers, perf_event_paranoid, other OSes) available() is false and
+ * every count reads as 0. Counts are scaled when the group was multiplexed.
+ */
+class perf_counters {
+ public:
+    enum event { cycles, instructions, branch_misses, l1d_misses, llc_misses, num_events };
+
+    struct sample {
+        uint64_t count[num_events];
+        bool valid[num_events];
+    };
+
+    perf_counters() noexcept {
+        for (int i = 0; i < num_events; i++) fds_[i] = -1;
+    #if PERF_COUNTERS_LINUX
+        static const uint32_t types[num_events]  = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                    PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE};
+        static const uint64_t configs[num_events] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+            PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+        for (int i = 0; i < num_events; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = types[i];
+            attr.config         = configs[i];
+            attr.disabled       = leader_ < 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0));
+            if (fd < 0) {
+                if (leader_ < 0) error_ = errno;
+                continue;
+            }
+            fds_[i] = fd;
+            if (leader_ < 0) leader_ = fd;
+            ioctl(fd, PERF_EVENT_IOC_ID, &ids_[i]);
+        }
+    #endif
+    }
+
+    ~perf_counters() {
+    #if PERF_COUNTERS_LINUX
+        for (int i = 0; i < num_events; i++)
+            if (fds_[i] >= 0) close(fds_[i]);
+    #endif
+    }
+
+    perf_counters(const perf_counters&)            = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    bool available() const noexcept { return leader_ >= 0; }
+    bool available(event e) const noexcept { return fds_[e] >= 0; }
+
+    /** Why no counter could be opened, or nullptr. */
+    const char* unavailable_reason() const noexcept {
+        if (available()) return nullptr;
+    #if PERF_COUNTERS_LINUX
+        return error_ ? strerror(error_) : "no counters";
+    #else
+        return "not supported on this OS";
+    #endif
+    }
+
+    /** Counts of fn() alone. */
+    template <typename _Fn>
+    sample measure(_Fn fn) noexcept {
+        sample s;
+        memset(&s, 0, sizeof(s));
+    #if PERF_COUNTERS_LINUX
+        if (!available()) {
+            fn();
+            return s;
+        }
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        fn();
+        ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t buf[3 + 2 * num_events];
+        if (read(leader_, buf, sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return s;
+        uint64_t nr = buf[0], enabled = buf[1], running = buf[2];
+        if (running == 0) return s; // never scheduled
+        for (uint64_t j = 0; j < nr && j < num_events; j++) {
+            for (int i = 0; i < num_events; i++) {
+                if (fds_[i] >= 0 && ids_[i] == buf[4 + 2 * j]) {
+                    s.count[i] = static_cast<uint64_t>(static_cast<double>(buf[3 + 2 * j]) * enabled / running);
+                    s.valid[i] = true;
+                }
+            }
+        }
+    #else
+        fn();
+    #endif
+        return s;
+    }
+
+ private:
+    int fds_[num_events];
+    uint64_t ids_[num_events] = {};
+    int leader_               = -1;
+    int error_                = 0;
+};
+
+#endif // __PERF_COUNTERS_H__
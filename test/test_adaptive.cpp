@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipAdaptive.h>
+#include <SlipInPlace.h>
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    std::vector<uint8_t> payload_with_density(size_t size, size_t every) {
+        std::vector<uint8_t> payload(size);
+        for (size_t i = 0; i < size; i++)
+            payload[i] = (i % every == every - 1) ? stdcodes::SLIP_END : static_cast<uint8_t>('a' + i % 26);
+        return payload;
+    }
+
+    kernel_id best_of(std::initializer_list<kernel_id> ks) {
+        kernel_id best = kernel_id::scalar;
+        for (kernel_id k : ks) {
+            if (kernel_supported(k)) best = k;
+        }
+        return best;
+    }
+}
+
+TEST_CASE("adaptive encoder picks kernels by density", "[adaptive-01]") {
+    adaptive_encoder<encoder> enc;
+    adaptive_decoder<decoder> dec;
+    const kernel_id run_skip = best_of({kernel_id::sse2, kernel_id::avx2});
+    const kernel_id dense    = best_of({kernel_id::avx512vbmi2});
+
+    WHEN("sparse payload") {
+        auto payload = payload_with_density(4096, 1000);
+        std::vector<uint8_t> frame(encoder::encoded_size(payload.data(), payload.size())), buf(frame.size());
+        REQUIRE(frame.size() == enc.encode(buf.data(), buf.size(), payload.data(), payload.size()));
+        encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        REQUIRE(frame == buf);
+        REQUIRE(1 == enc.counters().chosen[static_cast<int>(run_skip)]);
+        REQUIRE(payload.size() == dec.decode(buf.data(), buf.size(), frame.data(), frame.size()));
+        REQUIRE(1 == dec.counters().chosen[static_cast<int>(run_skip)]);
+    }
+
+    WHEN("dense payload") {
+        auto payload = payload_with_density(4096, 4);
+        std::vector<uint8_t> frame(encoder::encoded_size(payload.data(), payload.size())), buf(frame.size());
+        REQUIRE(frame.size() == enc.encoded_size(payload.data(), payload.size()));
+        REQUIRE(frame.size() == enc.encode(buf.data(), buf.size(), payload.data(), payload.size()));
+        encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        REQUIRE(frame == buf);
+        REQUIRE(1 == enc.counters().chosen[static_cast<int>(dense)]);
+        REQUIRE(1 == enc.counters().frames);
+        REQUIRE(enc.counters().density == Approx(0.25).epsilon(0.05));
+        REQUIRE(payload.size() == dec.decode(buf.data(), buf.size(), buf.data(), buf.size()));
+        REQUIRE(std::equal(payload.begin(), payload.end(), buf.begin()));
+        REQUIRE(1 == dec.counters().chosen[static_cast<int>(dense)]);
+    }
+
+    WHEN("short frames") {
+        auto payload = payload_with_density(16, 4);
+        uint8_t buf[64];
+        REQUIRE(21 == enc.encode(buf, sizeof(buf), payload.data(), payload.size()));
+        REQUIRE(1 == enc.counters().chosen[static_cast<int>(kernel_id::scalar)]);
+        REQUIRE(16 == enc.counters().bytes);
+    }
+
+    WHEN("running estimate") {
+        auto sparse = payload_with_density(4096, 1000);
+        auto dense  = payload_with_density(4096, 2);
+        std::vector<uint8_t> buf(2 * 4096 + 1);
+        enc.encode(buf.data(), buf.size(), sparse.data(), sparse.size());
+        enc.encode(buf.data(), buf.size(), dense.data(), dense.size());
+        // one dense frame only moves the estimate part way
+        REQUIRE(enc.counters().density == Approx(0.25 * 0.5).epsilon(0.05));
+        enc.reset();
+        REQUIRE(0 == enc.counters().frames);
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipBipBuffer.h>
+#include <SlipInPlace.h>
+#include <deque>
+#include <random>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    using bytes = std::vector<uint8_t>;
+
+    bytes encoded(const bytes& payload) {
+        bytes frame(encoder::encoded_size(payload.data(), payload.size()));
+        encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        return frame;
+    }
+}
+
+TEST_CASE("bip receiver decodes frames in place", "[bip-01]") {
+    using receiver = bip_receiver<32>;
+    receiver rx;
+    receiver::frame f, g;
+    const bytes a = {'a', stdcodes::SLIP_END, 'b'}, b = {stdcodes::SLIP_ESC};
+    bytes stream  = {stdcodes::SLIP_END};
+    for (const bytes* p : {&a, &b}) {
+        bytes e = encoded(*p);
+        stream.insert(stream.end(), e.begin(), e.end());
+    }
+
+    size_t room;
+    uint8_t* at = rx.reserve(room);
+    REQUIRE(32 == room);
+    memcpy(at, stream.data(), 4);
+    rx.commit(4);
+    REQUIRE(!rx.next(f));
+    REQUIRE(stream.size() - 4 == rx.write(stream.data() + 4, stream.size() - 4));
+    REQUIRE(rx.next(f));
+    REQUIRE(bytes(f.data, f.data + f.size) == a);
+    REQUIRE(f.data == at + 1); // decoded where it was received
+    REQUIRE(rx.next(g));
+    REQUIRE(bytes(g.data, g.data + g.size) == b);
+    REQUIRE(!rx.next(g));
+    rx.release(f);
+    rx.release(g);
+    REQUIRE(32 == (rx.reserve(room), room));
+    REQUIRE(2 == rx.frames());
+    REQUIRE(0 == rx.moved());
+}
+
+TEST_CASE("bip receiver keeps frames contiguous across the wrap", "[bip-02]") {
+    using receiver = bip_receiver<256>;
+    receiver rx;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> byte(0, 255), length(1, 60), burst(1, 40), hold(0, 3);
+    std::deque<bytes> expected;
+    std::deque<std::pair<receiver::frame, bytes>> held;
+    bytes pending;
+    size_t sent = 0, received = 0, total = 0;
+    const size_t nframes = 5000;
+
+    while (received < nframes) {
+        if (pending.empty() && sent < nframes) {
+            bytes p(length(rng));
+            for (auto& c : p) c = static_cast<uint8_t>(byte(rng));
+            expected.push_back(p);
+            pending = encoded(p);
+            sent++;
+        }
+        size_t n = std::min<size_t>(burst(rng), pending.size());
+        n        = rx.write(pending.data(), n);
+        pending.erase(pending.begin(), pending.begin() + n);
+        total += n;
+
+        receiver::frame f;
+        while (rx.next(f)) {
+            REQUIRE(bytes(f.data, f.data + f.size) == expected.front());
+            held.emplace_back(f, expected.front());
+            expected.pop_front();
+            received++;
+        }
+        // hold a few frames for a while, as a consumer working on them would
+        while (!held.empty() && (held.size() > static_cast<size_t>(hold(rng)) || n == 0)) {
+            const receiver::frame& h = held.front().first;
+            REQUIRE(bytes(h.data, h.data + h.size) == held.front().second); // not overwritten meanwhile
+            rx.release(h);
+            held.pop_front();
+            n = 1;
+        }
+    }
+    REQUIRE(0 == rx.errors());
+    REQUIRE(rx.moved() > 0);
+    REQUIRE(rx.moved() < total / 4); // only partial frames at the wrap are copied
+}
+
+TEST_CASE("bip receiver drops bad and oversize frames", "[bip-03]") {
+    using receiver = bip_receiver<16>;
+    receiver rx;
+    receiver::frame f;
+    const bytes bad = {'a', stdcodes::SLIP_ESC, 'x', stdcodes::SLIP_END};
+    REQUIRE(bad.size() == rx.write(bad.data(), bad.size()));
+    REQUIRE(!rx.next(f));
+    REQUIRE(1 == rx.errors());
+
+    bytes huge(40, 'z');
+    REQUIRE(huge.size() == rx.write(huge.data(), huge.size()));
+    REQUIRE(!rx.next(f));
+    const bytes ok = {'o', 'k'};
+    bytes e        = encoded(ok);
+    e.insert(e.begin(), stdcodes::SLIP_END); // end of the oversize frame
+    rx.write(e.data(), e.size());
+    REQUIRE(rx.next(f));
+    REQUIRE(bytes(f.data, f.data + f.size) == ok);
+    REQUIRE(2 == rx.errors());
+
+    // held frames are never overwritten
+    size_t room;
+    rx.reserve(room);
+    REQUIRE(room > 0);
+    REQUIRE(room == rx.write(huge.data(), huge.size()));
+    receiver::frame g;
+    REQUIRE(!rx.next(g));
+    REQUIRE(0 == (rx.reserve(room), room));
+    REQUIRE(bytes(f.data, f.data + f.size) == ok);
+    rx.release(f);
+    REQUIRE(0 < (rx.reserve(room), room));
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipCapture.h>
+#include <SlipInPlace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    using bytes = std::vector<uint8_t>;
+
+    std::string temp_path() {
+        char path[] = "/tmp/slip_capture_XXXXXX";
+        int fd      = mkstemp(path);
+        REQUIRE(fd >= 0);
+        close(fd);
+        return path;
+    }
+
+    bytes payload(size_t i) {
+        bytes p(1 + i % 37);
+        for (size_t j = 0; j < p.size(); j++) p[j] = static_cast<uint8_t>(i * 31 + j * 7);
+        return p;
+    }
+}
+
+TEST_CASE("frame scanner finds the same starts in any pieces", "[capture-01]") {
+    const uint8_t E = stdcodes::SLIP_END, S = stdcodes::SLIP_ESC, X = stdcodes::SLIP_ESCEND;
+    const bytes stream = {E, 'a', 'b', E, E, S, X, E, 'c', E, 'd'};
+    std::vector<uint64_t> whole = capture_index::build(stream.data(), stream.size());
+    REQUIRE(std::vector<uint64_t>({1, 5, 8, 10}) == whole);
+    for (size_t cut = 0; cut <= stream.size(); cut++) {
+        frame_scanner<> scanner;
+        std::vector<uint64_t> starts;
+        auto add = [&starts](uint64_t at) { starts.push_back(at); };
+        scanner.scan(stream.data(), cut, add);
+        scanner.scan(stream.data() + cut, stream.size() - cut, add);
+        scanner.finish(add);
+        REQUIRE(whole == starts);
+    }
+}
+
+TEST_CASE("capture writer indexes while writing", "[capture-02]") {
+    std::string path = temp_path();
+    {
+        capture_writer<> cap(path);
+        REQUIRE(cap.is_open());
+        for (size_t i = 0; i < 500; i++) {
+            bytes p = payload(i);
+            if (i % 2) {
+                REQUIRE(cap.write_frame(p.data(), p.size()));
+            } else { // raw stream data, in two pieces
+                bytes e(2 * p.size() + 1);
+                size_t n = encoder::encode(e.data(), e.size(), p.data(), p.size());
+                REQUIRE(cap.write(e.data(), n / 2));
+                REQUIRE(cap.write(e.data() + n / 2, n - n / 2));
+            }
+        }
+        REQUIRE(500 == cap.frames());
+        REQUIRE(cap.close());
+    }
+    capture_reader<> cap(path);
+    REQUIRE(cap.is_open());
+    REQUIRE(cap.indexed());
+    REQUIRE(500 == cap.size());
+    uint8_t buf[64];
+    for (size_t i : {0, 1, 250, 499}) {
+        bytes p = payload(i);
+        REQUIRE(p.size() == cap.decode(i, buf, sizeof(buf)));
+        REQUIRE(p == bytes(buf, buf + p.size()));
+    }
+    REQUIRE(0 == cap.decode(500, buf, sizeof(buf)));
+    size_t seen = 0;
+    REQUIRE(10 == cap.decode_range(100, 110, [&](size_t i, const uint8_t* data, size_t size) {
+        if (payload(i) == bytes(data, data + size)) seen++;
+    }));
+    REQUIRE(10 == seen);
+    unlink(capture_index::path_for(path).c_str());
+    unlink(path.c_str());
+}
+
+TEST_CASE("index retrofitted onto a raw capture", "[capture-03]") {
+    std::string path = temp_path();
+    bytes stream;
+    for (size_t i = 0; i < 100; i++) {
+        bytes p = payload(i), e(2 * p.size() + 1);
+        e.resize(encoder::encode(e.data(), e.size(), p.data(), p.size()));
+        stream.insert(stream.end(), e.begin(), e.end());
+    }
+    stream.push_back('x'); // last frame without END
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(stream.data(), 1, stream.size(), f);
+    fclose(f);
+
+    uint8_t buf[64];
+    {
+        capture_reader<> cap(path); // no index: scanned on open
+        REQUIRE(!cap.indexed());
+        REQUIRE(101 == cap.size());
+        REQUIRE(1 == cap.decode(100, buf, sizeof(buf)));
+    }
+    REQUIRE(capture_index::write(capture_index::path_for(path), capture_index::build(stream.data(), stream.size()), stream.size()));
+    {
+        capture_reader<> cap(path);
+        REQUIRE(cap.indexed());
+        REQUIRE(101 == cap.size());
+        bytes p = payload(42);
+        REQUIRE(p.size() == cap.decode(42, buf, sizeof(buf)));
+        REQUIRE(p == bytes(buf, buf + p.size()));
+    }
+    f = fopen(path.c_str(), "ab"); // the capture grew: the index is stale
+    fputc('y', f);
+    fclose(f);
+    {
+        capture_reader<> cap(path);
+        REQUIRE(!cap.indexed());
+        REQUIRE(2 == cap.decode(100, buf, sizeof(buf)));
+    }
+    unlink(capture_index::path_for(path).c_str());
+    unlink(path.c_str());
+}
+
+TEST_CASE("damaged index does not reach outside the capture", "[capture-04]") {
+    std::string path = temp_path(), index = capture_index::path_for(path);
+    const uint8_t stream[] = {'a', 'b', 'c', 0xC0, 'd', 'e', 'f', 0xC0};
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(stream, 1, sizeof(stream), f);
+    fclose(f);
+
+    uint8_t buf[16];
+    size_t n;
+    REQUIRE(capture_index::write(index, {0, uint64_t(1) << 30}, sizeof(stream)));
+    {
+        capture_reader<> cap(path);
+        REQUIRE(cap.indexed());
+        REQUIRE(2 == cap.size());
+        REQUIRE(nullptr == cap.frame(0, n));
+        REQUIRE(0 == n);
+        REQUIRE(nullptr == cap.frame(1, n));
+        REQUIRE(0 == cap.decoded_size(0));
+        REQUIRE(0 == cap.decode(1, buf, sizeof(buf)));
+    }
+
+    // a frame count that wraps the size check
+    REQUIRE(capture_index::write(index, {0}, sizeof(stream)));
+    uint8_t count[8];
+    capture_index::put(count, (uint64_t(1) << 61) + 1);
+    f = fopen(index.c_str(), "r+b");
+    fseek(f, 16, SEEK_SET);
+    fwrite(count, 1, sizeof(count), f);
+    fclose(f);
+    {
+        capture_reader<> cap(path);
+        REQUIRE(!cap.indexed()); // scanned instead
+        REQUIRE(2 == cap.size());
+        REQUIRE(3 == cap.decode(1, buf, sizeof(buf)));
+    }
+    unlink(index.c_str());
+    unlink(path.c_str());
+}
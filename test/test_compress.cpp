@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipCompress.h>
+#include <SlipInPlace.h>
+#include <cstdio>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    using packet = std::vector<uint8_t>;
+
+    void put16(uint8_t* p, uint32_t v) {
+        p[0] = uint8_t(v >> 8);
+        p[1] = uint8_t(v);
+    }
+    void put32(uint8_t* p, uint32_t v) {
+        put16(p, v >> 16);
+        put16(p + 2, v);
+    }
+
+    /** Synthetic IPv4/TCP packet with a valid IP checksum. */
+    packet tcp_packet(uint8_t host, uint16_t port, uint16_t id, uint32_t seq, uint32_t ack, uint8_t flags,
+                      uint16_t win, size_t ndata, uint16_t urp = 0) {
+        packet p(40 + ndata);
+        uint8_t* ip = p.data();
+        ip[0]       = 0x45;
+        put16(ip + 2, uint32_t(p.size()));
+        put16(ip + 4, id);
+        ip[8] = 64;
+        ip[9] = 6;
+        put32(ip + 12, 0x0a000001);
+        put32(ip + 16, 0x0a000000u | host);
+        uint32_t sum = 0;
+        for (int i = 0; i < 20; i += 2) sum += (ip[i] << 8) | ip[i + 1];
+        while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+        put16(ip + 10, ~sum);
+        uint8_t* th = ip + 20;
+        put16(th, port);
+        put16(th + 2, 23);
+        put32(th + 4, seq);
+        put32(th + 8, ack);
+        th[12] = 0x50;
+        th[13] = flags;
+        put16(th + 14, win);
+        put16(th + 16, uint16_t(seq * 7 + id)); // arbitrary TCP checksum, passed through
+        put16(th + 18, urp);
+        for (size_t i = 0; i < ndata; i++) p[40 + i] = uint8_t(i * 13 + seq);
+        return p;
+    }
+
+    /** An interactive flow: keystrokes, echoes, acks, a bulk burst and some odd ones out. */
+    std::vector<packet> flow(uint8_t host, uint16_t port) {
+        const uint8_t ACK = 0x10, PSH = 0x08, SYN = 0x02, URG = 0x20;
+        std::vector<packet> v;
+        uint32_t seq = 1000, ack = 5000;
+        uint16_t id = 1;
+        v.push_back(tcp_packet(host, port, id++, seq, 0, SYN, 8192, 0));
+        for (int i = 0; i < 6; i++) {
+            v.push_back(tcp_packet(host, port, id++, seq, ack, ACK | PSH, 8192, 1)); // keystroke
+            seq += 1;
+            ack += 1;
+            v.push_back(tcp_packet(host, port, id++, seq, ack, ACK, 8192, 0)); // ack of echo
+        }
+        for (int i = 0; i < 5; i++) { // bulk
+            v.push_back(tcp_packet(host, port, id++, seq, ack, ACK, 8192, 512));
+            seq += 512;
+        }
+        v.push_back(tcp_packet(host, port, id++, seq, ack + 700, ACK, 6000, 0));             // window and ack move
+        v.push_back(tcp_packet(host, port, id += 9, seq, ack + 700, ACK | URG, 6000, 3, 2)); // id jump, urgent
+        v.push_back(tcp_packet(host, port, id++, seq - 512, ack + 700, ACK, 6000, 512));     // retransmission
+        return v;
+    }
+}
+
+TEST_CASE("cslip round trip through a recorded SLIP stream", "[cslip-01]") {
+    std::vector<packet> packets;
+    for (uint8_t c = 1; c <= 3; c++) {
+        std::vector<packet> f = flow(c, uint16_t(1024 + c));
+        packets.insert(packets.end(), f.begin(), f.end());
+    }
+
+    // compress, encode and record to a file
+    cslip_compressor<> tx;
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file);
+    size_t raw = 0, wire = 0, ncompressed = 0;
+    std::vector<uint8_t> buf(2048);
+    for (const packet& p : packets) {
+        packet_buffer<> pkt(buf.data(), buf.size());
+        memcpy(pkt.put(p.size()), p.data(), p.size());
+        uint8_t type = tx.compress(pkt);
+        if (type == cslip::TYPE_COMPRESSED_TCP) {
+            ncompressed++;
+            REQUIRE(pkt.size() - (p.size() - 40) <= 16);
+        }
+        REQUIRE(pkt.template encode<encoder>());
+        fwrite(pkt.data(), 1, pkt.size(), file);
+        raw += p.size();
+        wire += pkt.size();
+    }
+    REQUIRE(ncompressed > packets.size() / 2);
+    REQUIRE(wire < raw);
+
+    // read back, split, decode and decompress without moving payloads
+    std::vector<uint8_t> stream(size_t(std::ftell(file)));
+    std::rewind(file);
+    REQUIRE(stream.size() == fread(stream.data(), 1, stream.size(), file));
+    std::fclose(file);
+    cslip_decompressor<> rx;
+    size_t start = 0, n = 0;
+    for (size_t i = 0; i < stream.size(); i++) {
+        if (stream[i] != 0xC0) continue;
+        packet_buffer<> pkt(buf.data(), buf.size(), cslip::MAX_HEADER);
+        memcpy(pkt.put(i + 1 - start), stream.data() + start, i + 1 - start);
+        uint8_t* payload = pkt.data() + pkt.size();
+        REQUIRE(rx.template decode<decoder>(pkt));
+        REQUIRE(pkt.data() + pkt.size() <= payload);
+        REQUIRE(packets[n].size() == pkt.size());
+        REQUIRE(std::equal(pkt.data(), pkt.data() + pkt.size(), packets[n].begin()));
+        start = i + 1;
+        n++;
+    }
+    REQUIRE(packets.size() == n);
+    REQUIRE(0 == rx.tossed());
+}
+
+TEST_CASE("cslip special cases and error recovery", "[cslip-02]") {
+    std::vector<packet> packets = flow(7, 2000);
+    cslip_compressor<4> tx;
+    cslip_decompressor<4> rx;
+    std::vector<uint8_t> buf(2048);
+
+    auto send = [&](const packet& p, packet_buffer<>& pkt) {
+        memcpy(pkt.put(p.size()), p.data(), p.size());
+        return tx.compress(pkt);
+    };
+
+    // SYN passes through untouched, first ACK sets up the slot
+    packet_buffer<> syn(buf.data(), buf.size());
+    REQUIRE(cslip::TYPE_IP == send(packets[0], syn));
+    REQUIRE(std::equal(syn.data(), syn.data() + syn.size(), packets[0].begin()));
+    REQUIRE(packets[0].size() == rx.decompress(syn));
+    packet_buffer<> first(buf.data(), buf.size(), 64);
+    REQUIRE(cslip::TYPE_UNCOMPRESSED_TCP == send(packets[1], first));
+    REQUIRE(0x75 == first.data()[0]);
+    REQUIRE(packets[1].size() == rx.decompress(first));
+
+    // ack of echo after keystroke: SPECIAL_I in 3 characters (changes, checksum)
+    packet_buffer<> ackp(buf.data(), buf.size(), 64);
+    REQUIRE(cslip::TYPE_COMPRESSED_TCP == send(packets[2], ackp));
+    REQUIRE(3 == ackp.size());
+    REQUIRE(packets[2].size() == rx.decompress(ackp));
+    REQUIRE(std::equal(ackp.data(), ackp.data() + ackp.size(), packets[2].begin()));
+
+    // lose a frame: later compressed packets are tossed until the sender resyncs
+    packet_buffer<> lost(buf.data(), buf.size(), 64);
+    REQUIRE(cslip::TYPE_COMPRESSED_TCP == send(packets[3], lost));
+    rx.error();
+    packet_buffer<> next(buf.data(), buf.size(), 64);
+    REQUIRE(cslip::TYPE_COMPRESSED_TCP == send(packets[4], next));
+    REQUIRE(0 == rx.decompress(next));
+    REQUIRE(1 == rx.tossed());
+    packet_buffer<> retx(buf.data(), buf.size(), 64); // TCP retransmits the lost segment
+    REQUIRE(cslip::TYPE_UNCOMPRESSED_TCP == send(packets[3], retx));
+    REQUIRE(packets[3].size() == rx.decompress(retx));
+    packet_buffer<> again(buf.data(), buf.size(), 64);
+    REQUIRE(cslip::TYPE_COMPRESSED_TCP == send(packets[4], again));
+    REQUIRE(packets[4].size() == rx.decompress(again));
+    REQUIRE(std::equal(again.data(), again.data() + again.size(), packets[4].begin()));
+
+    // no headroom: the payload moves back into the tailroom
+    packet_buffer<> tight(buf.data(), buf.size(), 0);
+    REQUIRE(cslip::TYPE_COMPRESSED_TCP == send(packets[5], tight));
+    REQUIRE(packets[5].size() == rx.decompress(tight));
+    REQUIRE(std::equal(tight.data(), tight.data() + tight.size(), packets[5].begin()));
+
+    // more connections than slots reuse the oldest slot
+    for (uint8_t c = 10; c < 16; c++) {
+        packet p = tcp_packet(c, 3000, 1, 1, 1, 0x10, 100, 4);
+        packet_buffer<> pkt(buf.data(), buf.size(), 64);
+        REQUIRE(cslip::TYPE_UNCOMPRESSED_TCP == send(p, pkt));
+        REQUIRE(p.size() == rx.decompress(pkt));
+    }
+
+    // damaged packets
+    uint8_t bad_slot[] = {cslip::TYPE_COMPRESSED_TCP | cslip::NEW_C, 9, 0, 0};
+    packet_buffer<> bad(bad_slot, sizeof(bad_slot), 0);
+    bad.put(sizeof(bad_slot));
+    REQUIRE(0 == rx.decompress(bad));
+    uint8_t truncated[] = {cslip::TYPE_COMPRESSED_TCP | cslip::NEW_C | cslip::NEW_S, 0, 0, 0, 0};
+    packet_buffer<> trunc(truncated, sizeof(truncated), 0);
+    trunc.put(sizeof(truncated));
+    REQUIRE(0 == rx.decompress(trunc));
+}
+
+TEST_CASE("cslip sends zero IP ID deltas and urgent pointers", "[cslip-03]") {
+    const uint8_t ACK = 0x10, PSH = 0x08, URG = 0x20;
+    std::vector<packet> packets;
+    uint32_t seq = 1000;
+    for (int i = 0; i < 4; i++, seq += 10) packets.push_back(tcp_packet(5, 4000, 0, seq, 5000, ACK | PSH, 8192, 10)); // IP ID stays 0
+    packets.push_back(tcp_packet(5, 4000, 0, seq, 5000, ACK | URG, 8192, 10, 0)); // URG with an urgent pointer of 0
+    packets.push_back(tcp_packet(5, 4000, 1, seq + 10, 5000, ACK | URG, 8192, 10, 0));
+
+    cslip_compressor<> tx;
+    cslip_decompressor<> rx;
+    std::vector<uint8_t> buf(2048);
+    for (size_t i = 0; i < packets.size(); i++) {
+        const packet& p = packets[i];
+        packet_buffer<> pkt(buf.data(), buf.size(), 64);
+        memcpy(pkt.put(p.size()), p.data(), p.size());
+        uint8_t type = tx.compress(pkt);
+        if (i > 0) REQUIRE(cslip::TYPE_COMPRESSED_TCP == type);
+        REQUIRE(p.size() == rx.decompress(pkt));
+        REQUIRE(std::equal(pkt.data(), pkt.data() + pkt.size(), p.begin()));
+    }
+    REQUIRE(0 == rx.tossed());
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipParallel.h>
+#include <random>
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    template <class DECODER>
+    void require_same_as_scalar(const std::vector<uint8_t>& src, unsigned nthreads, size_t min_chunk) {
+        std::vector<uint8_t> sbuf(src.size() + 8, '!'), pbuf(src.size() + 8, '!');
+        size_t ssize = DECODER::decode(sbuf.data(), sbuf.size(), src.data(), src.size());
+        size_t psize = parallel_decoder<DECODER>::decode(pbuf.data(), pbuf.size(), src.data(), src.size(), nthreads, min_chunk);
+        REQUIRE(psize == ssize);
+        REQUIRE(std::equal(sbuf.begin(), sbuf.begin() + ssize, pbuf.begin()));
+        // in-place
+        std::vector<uint8_t> ibuf(src);
+        size_t isize = parallel_decoder<DECODER>::decode(ibuf.data(), ibuf.size(), ibuf.data(), ibuf.size(), nthreads, min_chunk);
+        REQUIRE(isize == ssize);
+        REQUIRE(std::equal(sbuf.begin(), sbuf.begin() + ssize, ibuf.begin()));
+    }
+
+    std::vector<uint8_t> random_payload(std::mt19937& rng, size_t size, const uint8_t* specials, int nspecials, double density) {
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::uniform_real_distribution<double> unit(0, 1);
+        std::vector<uint8_t> payload(size);
+        for (auto& c : payload)
+            c = (unit(rng) < density) ? specials[byte(rng) % nspecials] : static_cast<uint8_t>(byte(rng));
+        return payload;
+    }
+}
+
+TEST_CASE("parallel decoder matches scalar decoder", "[decoder_parallel-01]") {
+    std::mt19937 rng(1234);
+    unsigned nthreads = GENERATE(2u, 3u, 8u);
+    double density    = GENERATE(0.0, 0.01, 0.5, 1.0);
+
+    WHEN("valid slip frames") {
+        for (size_t size : {1u, 17u, 255u, 4096u}) {
+            std::vector<uint8_t> payload = random_payload(rng, size, encoder::special_codes(), encoder::num_specials, density);
+            std::vector<uint8_t> frame(encoder::encoded_size(payload.data(), payload.size()));
+            REQUIRE(frame.size() == encoder::encode(frame.data(), frame.size(), payload.data(), payload.size()));
+            require_same_as_scalar<decoder>(frame, nthreads, 4);
+            std::vector<uint8_t> dbuf(payload.size());
+            REQUIRE(payload.size() == parallel_decoder<decoder>::decode(dbuf.data(), dbuf.size(), frame.data(), frame.size(), nthreads, 4));
+            REQUIRE(payload == dbuf);
+        }
+    }
+
+    WHEN("valid slip+null frames") {
+        for (size_t size : {1u, 17u, 255u, 4096u}) {
+            std::vector<uint8_t> payload = random_payload(rng, size, null_encoder::special_codes(), null_encoder::num_specials, density);
+            std::vector<uint8_t> frame(null_encoder::encoded_size(payload.data(), payload.size()));
+            REQUIRE(frame.size() == null_encoder::encode(frame.data(), frame.size(), payload.data(), payload.size()));
+            require_same_as_scalar<null_decoder>(frame, nthreads, 4);
+        }
+    }
+
+    WHEN("corrupted streams") {
+        // ESC ESC pairs, bad escape codes, dangling ESC and early END in random spots
+        const uint8_t nasty[] = {stdcodes::SLIP_ESC, stdcodes::SLIP_ESC, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, 'x'};
+        for (int trial = 0; trial < 50; trial++) {
+            std::vector<uint8_t> frame = random_payload(rng, 64 + trial, nasty, sizeof(nasty), density / 4);
+            require_same_as_scalar<decoder>(frame, nthreads, 2);
+        }
+    }
+}
+
+TEST_CASE("parallel decoder escape on a split point", "[decoder_parallel-02]") {
+    // 4 chunks of 4: ESC lands right before every naive split point
+    std::string srcstr = recode<decoder_hr, decoder>("abc^Defg^[ijk^Dmnop#");
+    std::vector<uint8_t> frame(srcstr.begin(), srcstr.end());
+    std::vector<uint8_t> dbuf(frame.size());
+    size_t dsize = parallel_decoder<decoder>::decode(dbuf.data(), dbuf.size(), frame.data(), frame.size(), 4, 4);
+    REQUIRE(16 == dsize);
+    REQUIRE("abc#efg^ijk#mnop" == recode<decoder, decoder_hr>(reinterpret_cast<char*>(dbuf.data()), dsize));
+
+    WHEN("buffer overrun") {
+        REQUIRE(0 == parallel_decoder<decoder>::decode(dbuf.data(), 15, frame.data(), frame.size(), 4, 4));
+    }
+    WHEN("bad inputs") {
+        REQUIRE(0 == parallel_decoder<decoder>::decode((uint8_t*)NULL, dbuf.size(), frame.data(), frame.size(), 4, 4));
+        REQUIRE(0 == parallel_decoder<decoder>::decode(dbuf.data(), 0, frame.data(), frame.size(), 4, 4));
+        REQUIRE(0 == parallel_decoder<decoder>::decode(dbuf.data(), dbuf.size(), (const uint8_t*)NULL, frame.size(), 4, 4));
+    }
+}
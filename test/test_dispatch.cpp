@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipDispatch.h>
+#include <SlipInPlace.h>
+#include <random>
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    using bytes = std::vector<uint8_t>;
+
+    bytes random_bytes(std::mt19937& rng, size_t size, const uint8_t* specials, int nspecials, double density) {
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::uniform_real_distribution<double> unit(0, 1);
+        bytes buf(size);
+        for (auto& c : buf)
+            c = (unit(rng) < density) ? specials[byte(rng) % nspecials] : static_cast<uint8_t>(byte(rng));
+        return buf;
+    }
+
+    /** Compare kernel k against the scalar codec for every dest size around the exact size */
+    template <class CODEC>
+    void require_same_encode(kernel_id k, const bytes& src) {
+        using fn = typename kernels<CODEC>::code_fn;
+        fn encode = kernels<CODEC>::encode(k);
+        REQUIRE(encode);
+        size_t esize = CODEC::encoded_size(src.data(), src.size());
+        REQUIRE(esize == kernels<CODEC>::encoded_size(k)(src.data(), src.size()));
+        for (size_t bsize = (esize > 3 ? esize - 3 : 0); bsize <= esize + 1; bsize++) {
+            bytes sbuf(bsize + 1, '!'), kbuf(bsize + 1, '!');
+            size_t ssize = CODEC::encode(sbuf.data(), bsize, src.data(), src.size());
+            size_t ksize = encode(kbuf.data(), bsize, src.data(), src.size());
+            REQUIRE(ssize == ksize);
+            REQUIRE(sbuf == kbuf); // same partial writes, nothing past bsize
+            // in-place
+            bytes ibuf(bsize + 1, '!'), jbuf(bsize + 1, '!');
+            if (src.size() <= bsize) {
+                std::copy(src.begin(), src.end(), ibuf.begin());
+                std::copy(src.begin(), src.end(), jbuf.begin());
+                ssize = CODEC::encode(ibuf.data(), bsize, ibuf.data(), src.size());
+                ksize = encode(jbuf.data(), bsize, jbuf.data(), src.size());
+                REQUIRE(ssize == ksize);
+                REQUIRE(std::equal(ibuf.begin(), ibuf.begin() + ssize, jbuf.begin()));
+                REQUIRE('!' == jbuf[bsize]);
+            }
+        }
+    }
+
+    template <class CODEC>
+    void require_same_decode(kernel_id k, const bytes& src) {
+        using fn = typename kernels<CODEC>::code_fn;
+        fn decode = kernels<CODEC>::decode(k);
+        REQUIRE(decode);
+        REQUIRE(CODEC::decoded_size(src.data(), src.size()) == kernels<CODEC>::decoded_size(k)(src.data(), src.size()));
+        size_t dsize = CODEC::decoded_size(src.data(), src.size());
+        for (size_t bsize = (dsize > 3 ? dsize - 3 : 0); bsize <= dsize + 1; bsize++) {
+            bytes sbuf(bsize + 1, '!'), kbuf(bsize + 1, '!');
+            size_t ssize = CODEC::decode(sbuf.data(), bsize, src.data(), src.size());
+            size_t ksize = decode(kbuf.data(), bsize, src.data(), src.size());
+            REQUIRE(ssize == ksize);
+            REQUIRE(sbuf == kbuf);
+        }
+        bytes ibuf(src), jbuf(src);
+        size_t ssize = CODEC::decode(ibuf.data(), ibuf.size(), ibuf.data(), ibuf.size());
+        size_t ksize = decode(jbuf.data(), jbuf.size(), jbuf.data(), jbuf.size());
+        REQUIRE(ssize == ksize);
+        REQUIRE(ibuf == jbuf);
+    }
+
+    std::vector<kernel_id> supported_kernels() {
+        std::vector<kernel_id> ks;
+        for (int k = 1; k < static_cast<int>(kernel_id::num_kernels); k++) {
+            if (kernel_supported(static_cast<kernel_id>(k)) && kernels<encoder>::encode(static_cast<kernel_id>(k)))
+                ks.push_back(static_cast<kernel_id>(k));
+        }
+        return ks;
+    }
+}
+
+TEST_CASE("kernels match scalar encoders", "[kernels-01]") {
+    std::mt19937 rng(42);
+    double density = GENERATE(0.0, 0.005, 0.05, 0.5, 1.0);
+    for (kernel_id k : supported_kernels()) {
+        INFO("kernel " << kernel_name(k));
+        for (size_t size : {0u, 1u, 15u, 16u, 17u, 31u, 33u, 64u, 100u, 257u, 1000u}) {
+            require_same_encode<encoder>(k, random_bytes(rng, size, encoder::special_codes(), encoder::num_specials, density));
+            require_same_encode<null_encoder>(k, random_bytes(rng, size, null_encoder::special_codes(), null_encoder::num_specials, density));
+        }
+    }
+}
+
+TEST_CASE("kernels match scalar decoders", "[kernels-02]") {
+    std::mt19937 rng(7);
+    double density = GENERATE(0.0, 0.005, 0.05, 0.5, 1.0);
+    // valid frames and garbage containing ESC pairs, bad escapes and early END
+    const uint8_t nasty[] = {stdcodes::SLIP_ESC, stdcodes::SLIP_END, stdcodes::SLIP_ESCEND, stdcodes::SLIP_ESCESC, stdcodes::SLIPX_ESCNULL, 'x'};
+    for (kernel_id k : supported_kernels()) {
+        INFO("kernel " << kernel_name(k));
+        for (size_t size : {1u, 15u, 16u, 17u, 31u, 33u, 64u, 65u, 100u, 257u, 1000u}) {
+            bytes payload = random_bytes(rng, size, null_encoder::special_codes(), null_encoder::num_specials, density);
+            bytes frame(null_encoder::encoded_size(payload.data(), payload.size()));
+            null_encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+            require_same_decode<null_decoder>(k, frame);
+            require_same_decode<decoder>(k, frame);
+            require_same_decode<decoder>(k, random_bytes(rng, size, nasty, sizeof(nasty), density));
+            require_same_decode<null_decoder>(k, random_bytes(rng, size, nasty, sizeof(nasty), density));
+        }
+    }
+}
+
+TEST_CASE("kernels handle char codecs", "[kernels-03]") {
+    std::string src = "Lorus^##ipsum dolor sit amet, consectetur^ adipiscing 0 elit";
+    for (kernel_id k : supported_kernels()) {
+        char ebuf[128], dbuf[128];
+        size_t esize = kernels<encoder_hrnull>::encode(k)(ebuf, sizeof(ebuf), src.c_str(), src.length());
+        REQUIRE(esize == encoder_hrnull::encode(dbuf, sizeof(dbuf), src.c_str(), src.length()));
+        REQUIRE(std::string(ebuf, esize) == std::string(dbuf, esize));
+        size_t dsize = kernels<decoder_hrnull>::decode(k)(dbuf, sizeof(dbuf), ebuf, esize);
+        REQUIRE(src == std::string(dbuf, dsize));
+    }
+}
+
+TEST_CASE("dispatched codecs", "[dispatch-01]") {
+    using test_encoder = dispatched_encoder<slip_encoder_base<uint8_t>>;
+    using test_decoder = dispatched_decoder<slip_decoder_base<uint8_t>>;
+
+    kernel_id k = GENERATE(kernel_id::scalar, kernel_id::sse2, kernel_id::avx2, kernel_id::avx512vbmi2);
+    bool ok     = test_encoder::use(k);
+    REQUIRE(ok == kernel_supported(k));
+    REQUIRE(ok == test_decoder::use(k));
+    if (ok) {
+        REQUIRE(k == test_encoder::active());
+        REQUIRE(k == test_decoder::active());
+    }
+
+    char buf[32];
+    const char* src = "Lo\300rus";
+    size_t esize    = test_encoder::encode(buf, sizeof(buf), src, strlen(src));
+    REQUIRE(8 == esize);
+    REQUIRE("Lo\333\334rus\300" == std::string(buf, esize));
+    REQUIRE(8 == test_encoder::encoded_size(src, strlen(src)));
+    REQUIRE(6 == test_decoder::decoded_size(buf, esize));
+    size_t dsize = test_decoder::decode(buf, sizeof(buf), buf, esize);
+    REQUIRE("Lo\300rus" == std::string(buf, dsize));
+
+    // back to automatic selection
+    test_encoder::use(selected_kernel());
+    test_decoder::use(selected_kernel());
+    REQUIRE(selected_kernel() == test_encoder::active());
+}
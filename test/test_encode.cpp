@@ -249,3 +249,42 @@ TEST_CASE("encode_hr bad inputs", "[encoder_hr-04]") {
         REQUIRE(0 == (ec_size = test_encoder::encode(buf, bsize, NULL, srcstr.length())));
     }
 }
+
+TEST_CASE("encode_hr in place with headroom and tailroom", "[encoder_hr-05]") {
+    const size_t bsize = 24;
+    const std::string payload = "Lo^#rus";   // 2 escapes: encodes to 10
+    const std::string encoded = "Lo^[^Drus#";
+
+    // every payload position and room, against the plain encoder
+    for (size_t offset = 0; offset + payload.length() <= bsize; offset++) {
+        for (size_t head = 0; head <= 6; head++) {
+            for (size_t tail = 0; tail <= 6; tail++) {
+                INFO("offset " << offset << " headroom " << head << " tailroom " << tail);
+                char buf[bsize];
+                memset(buf, '!', bsize);
+                memcpy(buf + offset, payload.c_str(), payload.length());
+                size_t at = offset;
+                size_t ec_size = encoder_hr::encode_with_room(buf, bsize, at, payload.length(), head, tail);
+                REQUIRE(10 == ec_size);
+                REQUIRE(encoded == std::string(buf + at, ec_size));
+                REQUIRE(at >= head);
+                REQUIRE(at + ec_size <= bsize - tail);
+                if (offset >= head && offset + ec_size <= bsize - tail) REQUIRE(offset == at); // stays put
+                // reserved room untouched
+                for (size_t i = 0; i < head; i++) REQUIRE(('!' == buf[i] || i >= offset));
+                for (size_t i = bsize - tail; i < bsize; i++) REQUIRE(('!' == buf[i] || i < offset + payload.length()));
+            }
+        }
+    }
+
+    WHEN("no room") {
+        char buf[bsize];
+        memcpy(buf, payload.c_str(), payload.length());
+        size_t at = 0;
+        REQUIRE(0 == encoder_hr::encode_with_room(buf, 10, at, 7, 1, 0));
+        REQUIRE(0 == encoder_hr::encode_with_room(buf, 10, at, 7, 0, 1));
+        REQUIRE(0 == encoder_hr::encode_with_room(buf, 10, at, 11));
+        REQUIRE(0 == encoder_hr::encode_with_room(NULL, 10, at, 7));
+        REQUIRE(0 == at);
+    }
+}
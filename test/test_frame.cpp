@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipFrame.h>
+#include <SlipInPlace.h>
+#include <string>
+#include <utility>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+TEST_CASE("frame inline and spilled storage", "[frame-01]") {
+    frame<8, char> f("Lorus", 5);
+    REQUIRE(f.is_inline());
+    REQUIRE(std::string("Lorus") == std::string(f.begin(), f.end()));
+
+    frame<8, char> g(f);
+    g.resize(20); // spills, keeping the contents
+    REQUIRE(!g.is_inline());
+    REQUIRE(20 == g.capacity());
+    REQUIRE(std::string("Lorus") == std::string(g.data(), 5));
+
+    const char* heap = g.data();
+    frame<8, char> h(std::move(g)); // steals the heap block
+    REQUIRE(heap == h.data());
+    REQUIRE(g.empty());
+    REQUIRE(g.is_inline());
+
+    frame<8, char> i(std::move(f)); // copies the inline contents
+    REQUIRE(i.is_inline());
+    REQUIRE(std::string("Lorus") == std::string(i.begin(), i.end()));
+
+    i = h;
+    REQUIRE(20 == i.size());
+    h.shrink();
+    REQUIRE(h.is_inline());
+    REQUIRE(0 == h.size());
+}
+
+TEST_CASE("frame encode and decode", "[frame-02]") {
+    const char* src = "Lo\300rus\333";
+    frame<16, char> e;
+    REQUIRE(10 == e.encode_into(src, strlen(src)));
+    REQUIRE(e.is_inline());
+    REQUIRE("Lo\333\334rus\333\335\300" == std::string(e.begin(), e.end()));
+
+    frame<4, char> d;
+    REQUIRE(7 == d.decode_from(e.data(), e.size()));
+    REQUIRE(!d.is_inline());
+    REQUIRE(7 == d.capacity()); // sized exactly once
+    REQUIRE(src == std::string(d.begin(), d.end()));
+
+    // in place, both ways
+    REQUIRE(10 == d.encode_into(d.data(), d.size()));
+    REQUIRE(e.size() == d.size());
+    REQUIRE(std::equal(e.begin(), e.end(), d.begin()));
+    REQUIRE(7 == d.decode_from(d.data(), d.size()));
+    REQUIRE(src == std::string(d.begin(), d.end()));
+
+    // other codecs and errors
+    frame<32, char> hr;
+    REQUIRE(hr.encode_into<encoder_hrnull>("a#b", 3));
+    REQUIRE("a^Db#" == std::string(hr.begin(), hr.end()));
+    REQUIRE(0 == hr.decode_from<decoder_hrnull>("a^xb#", 5));
+    REQUIRE(hr.empty());
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipKiss.h>
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+TEST_CASE("kiss encode and decode", "[kiss-01]") {
+    using kenc = kiss_encoder<encoder>;
+    using kdec = kiss_decoder<decoder>;
+    const char* src = "Lo\300rus\333";
+    uint8_t type    = 0;
+    std::string buf(32, ' ');
+
+    // port 3 data
+    REQUIRE(12 == kenc::encoded_size(src, strlen(src), kiss::type(3, kiss::DATA)));
+    REQUIRE(12 == kenc::encode(&buf[0], buf.size(), src, strlen(src), 3));
+    REQUIRE("\300\060Lo\333\334rus\333\335\300" == buf.substr(0, 12));
+    REQUIRE(7 == kdec::decoded_size(buf.data(), 12));
+    std::string out(16, ' ');
+    REQUIRE(7 == kdec::decode(&out[0], out.size(), buf.data(), 12, type));
+    REQUIRE(3 == kiss::port(type));
+    REQUIRE(kiss::DATA == kiss::command(type));
+    REQUIRE(src == out.substr(0, 7));
+
+    // port 12 data has type character FEND, which is escaped
+    REQUIRE(13 == kenc::encode(&buf[0], buf.size(), src, strlen(src), 12));
+    REQUIRE("\300\333\334Lo" == buf.substr(0, 5));
+    REQUIRE(7 == kdec::decode(&out[0], out.size(), buf.data(), 13, type));
+    REQUIRE(12 == kiss::port(type));
+
+    // in place both ways
+    std::string io = std::string(src) + std::string(6, ' ');
+    REQUIRE(13 == kenc::encode(&io[0], io.size(), io.data(), 7, 12));
+    REQUIRE(buf.substr(0, 13) == io);
+    REQUIRE(7 == kdec::decode(&io[0], io.size(), io.data(), 13, type));
+    REQUIRE(src == io.substr(0, 7));
+
+    // commands and errors
+    REQUIRE(4 == kenc::encode_command(&buf[0], buf.size(), 1, kiss::TXDELAY, 30));
+    REQUIRE("\300\021\036\300" == buf.substr(0, 4));
+    REQUIRE(1 == kdec::decode(&out[0], out.size(), buf.data(), 4, type));
+    REQUIRE(kiss::type(1, kiss::TXDELAY) == type);
+    REQUIRE(0 == kenc::encode(&buf[0], 10, src, strlen(src), 3));
+    REQUIRE(0 == kdec::decode(&out[0], out.size(), "\300\333x", 3, type));
+}
+
+namespace {
+    struct received {
+        std::vector<std::pair<int, std::string>> frames;
+        std::vector<int> commands;
+    };
+    void on_frame(void* ctx, uint8_t port, const uint8_t* data, size_t size) {
+        static_cast<received*>(ctx)->frames.push_back({port, std::string(data, data + size)});
+    }
+    void on_command(void* ctx, uint8_t port, uint8_t command, const uint8_t*, size_t) {
+        static_cast<received*>(ctx)->commands.push_back(port * 16 + command);
+    }
+}
+
+TEST_CASE("kiss demultiplexing", "[kiss-02]") {
+    using kenc = kiss_encoder<encoder>;
+    std::vector<std::pair<int, std::string>> sent;
+    std::vector<uint8_t> stream;
+    uint8_t buf[64];
+    for (int i = 0; i < 24; i++) {
+        int port        = i % 8;
+        std::string msg = "frame " + std::to_string(i) + (i % 3 ? "" : " \300\333");
+        size_t n        = kenc::encode(buf, sizeof(buf), reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), uint8_t(port));
+        stream.insert(stream.end(), buf, buf + n);
+        if (port != 7) sent.push_back({port, msg}); // no sink for port 7
+        if (i == 10) {
+            n = kenc::encode_command(buf, sizeof(buf), 2, kiss::PERSIST, 200);
+            stream.insert(stream.end(), buf, buf + n);
+            n = kenc::encode_command(buf, sizeof(buf), 5, kiss::SETHARDWARE, 1);
+            stream.insert(stream.end(), buf, buf + n);
+            uint8_t bad[] = {0xC0, 0x00, 'x', 0xDB, 'x', 0xC0};
+            stream.insert(stream.end(), bad, bad + sizeof(bad));
+        }
+    }
+
+    for (size_t chunk : {size_t(1), size_t(7), stream.size()}) {
+        kiss_demux<64> demux;
+        received got;
+        for (uint8_t port = 0; port < 7; port++) demux.set_sink(port, on_frame, &got);
+        demux.set_command_sink(on_command, &got);
+        size_t dispatched = 0;
+        for (size_t at = 0; at < stream.size(); at += chunk) {
+            dispatched += demux.write(stream.data() + at, std::min(chunk, stream.size() - at));
+        }
+        REQUIRE(26 == dispatched);
+        REQUIRE(sent == got.frames);
+        REQUIRE(24 == demux.frames());
+        REQUIRE(3 == demux.unrouted());
+        REQUIRE(2 == demux.commands());
+        REQUIRE(1 == demux.errors());
+        REQUIRE(200 == demux.params(2).persist);
+        REQUIRE(63 == demux.params(1).persist);
+        REQUIRE(std::vector<int>{5 * 16 + kiss::SETHARDWARE} == got.commands);
+    }
+
+    // a frame longer than the buffer is dropped
+    kiss_demux<8> small;
+    size_t n = kenc::encode(buf, sizeof(buf), reinterpret_cast<const uint8_t*>("0123456789"), 10, 0);
+    REQUIRE(0 == small.write(buf, 4));
+    REQUIRE(0 == small.write(buf + 4, n - 4));
+    REQUIRE(1 == small.errors());
+}
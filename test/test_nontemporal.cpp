@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipNonTemporal.h>
+#include <random>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+TEST_CASE("non-temporal codecs match scalar codecs", "[nontemporal-01]") {
+    using test_encoder = nontemporal_encoder<slip_encoder_base<uint8_t>>;
+    using test_decoder = nontemporal_decoder<slip_decoder_base<uint8_t>>;
+    size_t saved = nontemporal::threshold();
+    nontemporal::set_threshold(0); // every out-of-place call goes the non-temporal way
+
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<int> byte(0, 255);
+    size_t size = GENERATE(1u, 100u, 8191u, 8192u, 8193u, 50000u);
+    size_t skew = GENERATE(0u, 5u); // dest not on a cache line boundary
+    nontemporal::set_prefetch_distance(skew ? 2 * nontemporal::piece_size : 0);
+    std::vector<uint8_t> payload(size);
+    for (auto& c : payload) c = static_cast<uint8_t>(byte(rng));
+
+    size_t esize = encoder::encoded_size(payload.data(), payload.size());
+    std::vector<uint8_t> frame(esize), nt_frame(skew + esize + 1, '!');
+    REQUIRE(esize == encoder::encode(frame.data(), frame.size(), payload.data(), payload.size()));
+    REQUIRE(esize == test_encoder::encode(nt_frame.data() + skew, esize, payload.data(), payload.size()));
+    REQUIRE(std::equal(frame.begin(), frame.end(), nt_frame.begin() + skew));
+    REQUIRE('!' == nt_frame[skew + esize]);
+    if (skew) REQUIRE('!' == nt_frame[skew - 1]);
+    REQUIRE(0 == test_encoder::encode(nt_frame.data() + skew, esize - 1, payload.data(), payload.size()));
+
+    std::vector<uint8_t> nt_payload(skew + size + 1, '!');
+    REQUIRE(size == test_decoder::decode(nt_payload.data() + skew, size, frame.data(), frame.size()));
+    REQUIRE(std::equal(payload.begin(), payload.end(), nt_payload.begin() + skew));
+    REQUIRE('!' == nt_payload[skew + size]);
+    if (skew) REQUIRE('!' == nt_payload[skew - 1]);
+    if (size > 1) REQUIRE(0 == test_decoder::decode(nt_payload.data() + skew, size - 1, frame.data(), frame.size()));
+
+    WHEN("frame followed by trailing bytes") {
+        frame.insert(frame.end(), payload.begin(), payload.end());
+        REQUIRE(size == test_decoder::decode(nt_payload.data() + skew, size, frame.data(), frame.size()));
+    }
+    WHEN("escape pair split by a piece boundary") {
+        std::vector<uint8_t> src(nontemporal::piece_size - 1, 'a');
+        src.push_back(stdcodes::SLIP_ESC);
+        src.push_back(stdcodes::SLIP_ESCEND);
+        src.push_back(stdcodes::SLIP_END);
+        std::vector<uint8_t> dbuf(src.size());
+        REQUIRE(nontemporal::piece_size == test_decoder::decode(dbuf.data(), dbuf.size(), src.data(), src.size()));
+        REQUIRE(stdcodes::SLIP_END == dbuf[nontemporal::piece_size - 1]);
+        src[src.size() - 2] = 'x'; // invalid escape
+        REQUIRE(0 == test_decoder::decode(dbuf.data(), dbuf.size(), src.data(), src.size()));
+    }
+    WHEN("in-place falls back to the dispatched codec") {
+        std::vector<uint8_t> buf(frame);
+        REQUIRE(size == test_decoder::decode(buf.data(), buf.size(), buf.data(), buf.size()));
+        REQUIRE(std::equal(payload.begin(), payload.end(), buf.begin()));
+    }
+    nontemporal::set_threshold(saved);
+    nontemporal::set_prefetch_distance(0);
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipPacket.h>
+#include <string>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+TEST_CASE("packet buffer layering", "[packet-01]") {
+    char buf[32];
+    memset(buf, '!', sizeof(buf));
+    packet_buffer<char> pkt(buf, sizeof(buf), 4);
+    REQUIRE(4 == pkt.headroom());
+    REQUIRE(28 == pkt.tailroom());
+
+    memcpy(pkt.put(7), "Lo^#rus", 7);
+    char* payload = pkt.data();
+    REQUIRE(10 == pkt.encode<encoder_hr>(2, 3));
+    REQUIRE(payload == pkt.data()); // encoded where the payload was
+    REQUIRE("Lo^[^Drus#" == std::string(pkt.data(), pkt.size()));
+    REQUIRE(4 == pkt.headroom());
+    REQUIRE(18 == pkt.tailroom());
+
+    memcpy(pkt.push(2), "H:", 2);
+    memcpy(pkt.put(3), "CRC", 3);
+    REQUIRE("H:Lo^[^Drus#CRC" == std::string(pkt.data(), pkt.size()));
+    REQUIRE('!' == buf[1]);
+    REQUIRE(!pkt.push(3));
+    REQUIRE(!pkt.put(16));
+
+    // receive side
+    REQUIRE(pkt.pull(2));
+    pkt.trim(pkt.size() - 3);
+    REQUIRE(7 == pkt.decode<decoder_hr>());
+    REQUIRE("Lo^#rus" == std::string(pkt.data(), pkt.size()));
+}
+
+TEST_CASE("packet buffer without enough tailroom", "[packet-02]") {
+    char buf[16];
+    packet_buffer<char> pkt(buf, sizeof(buf), 4);
+    memcpy(pkt.put(10), "Lo^#rus^^^", 10);
+    REQUIRE(0 == pkt.encode<encoder_hr>(0, 4)); // 16 encoded + 4 tailroom > 16
+    REQUIRE(10 == pkt.size());
+    REQUIRE(0 == pkt.encode<encoder_hr>(0, 0) - 16);
+    REQUIRE(0 == pkt.headroom()); // moved forward into the headroom
+    REQUIRE("Lo^[^Drus^[^[^[#" == std::string(pkt.data(), pkt.size()));
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipPool.h>
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+TEST_CASE("frame arena", "[pool-01]") {
+    uint8_t storage[16];
+    frame_arena<> arena(storage, sizeof(storage));
+    const uint8_t a[] = {'a', stdcodes::SLIP_ESC, stdcodes::SLIP_ESCEND, 'b', stdcodes::SLIP_END};
+    const uint8_t bad[] = {'a', stdcodes::SLIP_ESC, 'x', stdcodes::SLIP_END};
+
+    frame_span<uint8_t> f = arena.decode<decoder>(a, sizeof(a));
+    REQUIRE(f);
+    REQUIRE(storage == f.data);
+    REQUIRE(3 == f.size);
+    REQUIRE(std::string("a\300b") == std::string(f.data, f.data + f.size));
+    REQUIRE(!arena.decode<decoder>(bad, sizeof(bad)));
+    REQUIRE(3 == arena.used()); // nothing kept on error
+
+    for (int i = 0; i < 4; i++) REQUIRE(arena.decode<decoder>(a, sizeof(a)));
+    REQUIRE(!arena.decode<decoder>(a, sizeof(a))); // full
+    REQUIRE(5 == arena.frames());
+    arena.reset();
+    REQUIRE(0 == arena.used());
+    REQUIRE(storage == arena.decode<decoder>(a, sizeof(a)).data);
+
+    frame_arena<char> owned(64);
+    REQUIRE(64 == owned.capacity());
+    char* p = owned.allocate(1);
+    char* q = owned.allocate(8, 8);
+    REQUIRE(p);
+    REQUIRE(0 == reinterpret_cast<uintptr_t>(q) % 8);
+    REQUIRE(!owned.allocate(65));
+}
+
+#if SLIP_HAS_PMR
+TEST_CASE("arena memory resource", "[pool-02]") {
+    frame_arena<> arena(1024);
+    arena_resource resource(arena);
+    {
+        std::pmr::vector<uint8_t> v(&resource);
+        v.assign(100, 'x');
+        REQUIRE(arena.owns(v.data()));
+        std::pmr::vector<uint32_t> w(10, 7, &resource);
+        REQUIRE(0 == reinterpret_cast<uintptr_t>(w.data()) % alignof(uint32_t));
+    }
+    REQUIRE(arena.used() >= 140);
+    std::pmr::vector<uint8_t> big(&resource);
+    REQUIRE_THROWS(big.resize(2048)); // null upstream
+    arena.reset();
+}
+#endif
+
+TEST_CASE("frame pool", "[pool-03]") {
+    using pool_type = frame_pool<8, 3>;
+    pool_type pool;
+    const uint8_t a[]   = {'h', 'i', stdcodes::SLIP_END};
+    const uint8_t big[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', stdcodes::SLIP_END};
+
+    pool_type::handle h = pool.decode<decoder>(a, sizeof(a));
+    REQUIRE(h);
+    REQUIRE(2 == h.size());
+    REQUIRE(std::string("hi") == std::string(h.data(), h.data() + h.size()));
+    REQUIRE(2 == pool.available());
+    REQUIRE(!pool.decode<decoder>(big, sizeof(big))); // larger than a block
+    REQUIRE(2 == pool.available());
+
+    {
+        pool_type::handle copy = h;
+        REQUIRE(2 == h.use_count());
+        pool_type::handle moved = std::move(copy);
+        REQUIRE(2 == h.use_count());
+        REQUIRE(!copy);
+    }
+    REQUIRE(1 == h.use_count());
+
+    pool_type::handle b = pool.acquire(), c = pool.acquire();
+    REQUIRE(8 == b.size());
+    REQUIRE(0 == pool.available());
+    REQUIRE(!pool.acquire());
+    h.reset();
+    REQUIRE(1 == pool.available());
+    b = c; // b's block returns, c's is shared
+    REQUIRE(2 == pool.available());
+    REQUIRE(2 == c.use_count());
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipReactor.h>
+#include <array>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    struct socket_pairs {
+        explicit socket_pairs(size_t n) : fds(n) {
+            for (auto& p : fds) REQUIRE(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, p.data()));
+        }
+        ~socket_pairs() {
+            for (auto& p : fds) {
+                if (p[0] >= 0) close(p[0]);
+                close(p[1]);
+            }
+        }
+        std::vector<std::array<int, 2>> fds; // [0] for the reactor, [1] for the test
+    };
+
+    std::string frame_of(const std::string& payload) {
+        std::string out(2 * payload.size() + 1, '\0');
+        out.resize(encoder::encode(&out[0], out.size(), payload.data(), payload.size()));
+        return out;
+    }
+
+    std::string read_some(int fd) {
+        char buf[4096];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        return n > 0 ? std::string(buf, n) : std::string();
+    }
+}
+
+TEST_CASE("reactor dispatches frames and echoes them with writev", "[reactor-01]") {
+    for (reactor_backend backend : {reactor_backend::epoll, reactor_backend::poll}) {
+        const size_t nch = 4;
+        socket_pairs sp(nch);
+        reactor<> r(32, backend);
+        std::vector<std::vector<std::string>> got(nch);
+        for (size_t i = 0; i < nch; i++) {
+            int ch = r.add(sp.fds[i][0], [&r, &got](size_t ch, const uint8_t* frame, size_t size) {
+                got[ch].push_back(std::string(reinterpret_cast<const char*>(frame), size));
+                r.send(ch, frame, size);
+                r.send(ch, frame, size); // two frames, one writev
+            });
+            REQUIRE(int(i) == ch);
+        }
+        std::string expected_echo[nch];
+        for (int round = 0; round < 10; round++) {
+            for (size_t i = 0; i < nch; i++) {
+                std::string payload = std::to_string(i) + "/" + std::to_string(round) + "\xC0\xDB";
+                std::string f       = frame_of(payload);
+                size_t cut          = (round + i) % f.size();
+                REQUIRE(ssize_t(cut) == write(sp.fds[i][1], f.data(), cut));
+                r.run_once(0);
+                REQUIRE(ssize_t(f.size() - cut) == write(sp.fds[i][1], f.data() + cut, f.size() - cut));
+                expected_echo[i] += f + f;
+            }
+            while (r.run_once(100)) {}
+        }
+        for (size_t i = 0; i < nch; i++) {
+            REQUIRE(10 == got[i].size());
+            REQUIRE(10 == r.frames(i));
+            REQUIRE("2/9\xC0\xDB" == got[2].back());
+            std::string echo;
+            while (echo.size() < expected_echo[i].size()) echo += read_some(sp.fds[i][1]);
+            REQUIRE(expected_echo[i] == echo);
+            REQUIRE(0 == r.pending(i));
+        }
+    }
+}
+
+TEST_CASE("reactor closes channels at end of file", "[reactor-02]") {
+    socket_pairs sp(2);
+    reactor<> r;
+    std::vector<std::string> got;
+    auto keep = [&got](size_t, const uint8_t* frame, size_t size) {
+        got.push_back(std::string(reinterpret_cast<const char*>(frame), size));
+    };
+    r.add(sp.fds[0][0], keep);
+    r.add(sp.fds[1][0], keep);
+    std::string data = frame_of("one") + "two";
+    REQUIRE(ssize_t(data.size()) == write(sp.fds[0][1], data.data(), data.size()));
+    shutdown(sp.fds[0][1], SHUT_WR);
+    while (r.is_open(0) && r.run_once(1000)) {}
+    REQUIRE(!r.is_open(0));
+    REQUIRE(0 == r.error(0));
+    REQUIRE(1 == r.open_channels());
+    REQUIRE((std::vector<std::string>{"one", "two"}) == got); // the last frame has no END
+    REQUIRE(!r.send(0, "x", 1));
+    r.remove(1);
+    REQUIRE(0 == r.open_channels());
+    REQUIRE(0 == r.run_once(-1)); // nothing to wait for
+}
+
+TEST_CASE("reactor queues frames while the fd is full", "[reactor-03]") {
+    socket_pairs sp(1);
+    reactor<> r;
+    r.add(sp.fds[0][0], [](size_t, const uint8_t*, size_t) {});
+    r.set_max_pending(1 << 22);
+    std::string payload(1000, 'p');
+    size_t sent = 0;
+    while (r.pending(0) == 0 || sent < 4000) { // more than the socket buffer takes
+        REQUIRE(r.send(0, payload.data(), payload.size()));
+        sent++;
+        r.flush();
+    }
+    REQUIRE(r.pending(0) > 0);
+    r.set_max_pending(r.pending(0));
+    REQUIRE(!r.send(0, payload.data(), payload.size()));
+    size_t received = 0;
+    while (received < sent * 1001) {
+        received += read_some(sp.fds[0][1]).size();
+        r.run_once(0);
+    }
+    REQUIRE(sent * 1001 == received);
+    REQUIRE(0 == r.pending(0));
+}
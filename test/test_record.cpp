@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipRecord.h>
+#include <cstddef>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    struct sample {
+        uint32_t t;
+        uint8_t channel; // followed by a padding character
+        int16_t x;
+        uint16_t flags;
+    };
+    using sample_wire = layout<byte_order::big, field<offsetof(sample, t), 4>, field<offsetof(sample, channel), 1>,
+                               field<offsetof(sample, x), 2>, field<offsetof(sample, flags), 2>>;
+}
+
+TEST_CASE("record big-endian layout", "[record-01]") {
+    using enc = record_encoder<sample, sample_wire>;
+    using dec = record_decoder<sample, sample_wire>;
+    REQUIRE(9 == enc::wire_size);
+    REQUIRE(19 == enc::max_encoded_size);
+
+    sample s{0x11C0DB22, 0xC0, -2, 0x0102};
+    uint8_t buf[enc::max_encoded_size];
+    size_t n = enc::encode(buf, sizeof(buf), s);
+    REQUIRE(enc::encoded_size(s) == n);
+    std::vector<uint8_t> expect{0x11, 0xDB, 0xDC, 0xDB, 0xDD, 0x22, 0xDB, 0xDC, 0xFF, 0xFE, 0x01, 0x02, 0xC0};
+    REQUIRE(expect == std::vector<uint8_t>(buf, buf + n));
+
+    // nine characters on the wire: no padding
+    uint8_t plain[16];
+    REQUIRE(9 == decoder::decode(plain, sizeof(plain), buf, n));
+
+    sample d{};
+    REQUIRE(dec::decode(d, buf, n));
+    REQUIRE(s.t == d.t);
+    REQUIRE(s.channel == d.channel);
+    REQUIRE(s.x == d.x);
+    REQUIRE(s.flags == d.flags);
+
+    // wrong length, bad escape, no room
+    REQUIRE(!dec::decode(d, buf, n - 3));
+    std::vector<uint8_t> longer(buf, buf + n - 1);
+    longer.push_back(0x55);
+    longer.push_back(0xC0);
+    REQUIRE(!dec::decode(d, longer.data(), longer.size()));
+    uint8_t bad[] = {0x11, 0xDB, 0x00, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0xC0};
+    REQUIRE(!dec::decode(d, bad, sizeof(bad)));
+    REQUIRE(0 == enc::encode(buf, n - 1, s));
+}
+
+TEST_CASE("record raw layout", "[record-02]") {
+    struct point {
+        float x, y;
+    };
+    using enc = record_encoder<point>;
+    using dec = record_decoder<point>;
+    point p{1.5f, -0.25f};
+    uint8_t buf[enc::max_encoded_size];
+    size_t n = enc::encode(buf, sizeof(buf), p);
+    REQUIRE(encoder::encoded_size(reinterpret_cast<const uint8_t*>(&p), sizeof(p)) == n);
+    point q{};
+    REQUIRE(dec::decode(q, buf, n));
+    REQUIRE(p.x == q.x);
+    REQUIRE(p.y == q.y);
+    REQUIRE(!dec::decode(q, buf, n - 2));
+
+    // host order layout with per-field entries matches the raw one
+    using fields = layout<host_order, field<0, 4>, field<4, 4>>;
+    uint8_t buf2[enc::max_encoded_size];
+    REQUIRE(n == record_encoder<point, fields>::encode(buf2, sizeof(buf2), p));
+    REQUIRE(std::equal(buf, buf + n, buf2));
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipRing.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    using bytes = std::vector<uint8_t>;
+
+    bytes encoded(const bytes& payload) {
+        bytes frame(encoder::encoded_size(payload.data(), payload.size()));
+        encoder::encode(frame.data(), frame.size(), payload.data(), payload.size());
+        return frame;
+    }
+
+    template <class RING>
+    bytes contents(const typename RING::frame& f) {
+        bytes out(f.size());
+        REQUIRE(f.size() == f.copy(out.data(), out.size()));
+        return out;
+    }
+}
+
+TEST_CASE("ring decodes frames in place", "[ring-01]") {
+    using ring_type = spsc_ring<64>;
+    ring_type ring;
+    ring_type::frame f;
+    const bytes a = {'h', 'i', stdcodes::SLIP_END, 'x'}, b = {stdcodes::SLIP_ESC, 'y'};
+    bytes stream  = {stdcodes::SLIP_END}; // leading END: empty frame is skipped
+    for (const bytes* p : {&a, &b}) {
+        bytes e = encoded(*p);
+        stream.insert(stream.end(), e.begin(), e.end());
+    }
+
+    REQUIRE(!ring.next(f));
+    REQUIRE(3 == ring.write(stream.data(), 3));
+    REQUIRE(!ring.next(f)); // partial frame
+    REQUIRE(stream.size() - 3 == ring.write(stream.data() + 3, stream.size() - 3));
+    REQUIRE(ring.next(f));
+    REQUIRE(a == contents<ring_type>(f));
+    REQUIRE(0 == f.second_size);
+    ring_type::frame g;
+    REQUIRE(ring.next(g)); // two frames held at once
+    REQUIRE(b == contents<ring_type>(g));
+    REQUIRE(!ring.next(g));
+    REQUIRE(stream.size() - 1 == ring.size()); // skipped END already released
+    ring.release(f);
+    ring.release(g);
+    REQUIRE(0 == ring.size());
+    REQUIRE(2 == ring.frames());
+    REQUIRE(0 == ring.errors());
+}
+
+TEST_CASE("ring frames wrap around", "[ring-02]") {
+    using ring_type = spsc_ring<16>;
+    ring_type ring;
+    ring_type::frame f;
+    int wrapped = 0;
+    // every offset, so frames and escape pairs straddle the end of the storage
+    for (int i = 0; i < 40; i++) {
+        bytes payload = {uint8_t('a' + i % 26), stdcodes::SLIP_END, 'b', stdcodes::SLIP_ESC, 'c'};
+        payload.resize(1 + i % 5);
+        bytes e = encoded(payload);
+        for (uint8_t c : e) REQUIRE(ring.push(c));
+        REQUIRE(ring.next(f));
+        REQUIRE(payload == contents<ring_type>(f));
+        if (f.second_size) wrapped++;
+        ring.release(f);
+        REQUIRE(0 == ring.size());
+    }
+    REQUIRE(wrapped > 0);
+}
+
+TEST_CASE("ring drops bad and oversize frames", "[ring-03]") {
+    using ring_type = spsc_ring<16>;
+    ring_type ring;
+    ring_type::frame f;
+    const bytes bad = {'a', stdcodes::SLIP_ESC, 'x', 'b', stdcodes::SLIP_END};
+    ring.write(bad.data(), bad.size());
+    REQUIRE(!ring.next(f));
+    REQUIRE(1 == ring.errors());
+    REQUIRE(0 == ring.size());
+
+    // longer than the ring: producer drops the overflow, consumer drops the frame
+    bytes huge(40, 'z');
+    for (size_t i = 0; i < huge.size(); i += 8) {
+        ring.write(huge.data() + i, 8);
+        REQUIRE(!ring.next(f));
+    }
+    REQUIRE(0 == ring.dropped());
+    ring.push(stdcodes::SLIP_END);
+    REQUIRE(!ring.next(f));
+    REQUIRE(2 == ring.errors());
+
+    const bytes ok = {'o', 'k'};
+    bytes e        = encoded(ok);
+    ring.write(e.data(), e.size());
+    REQUIRE(ring.next(f));
+    REQUIRE(ok == contents<ring_type>(f));
+    ring.release(f);
+
+    // full ring: the producer drops the rest
+    REQUIRE(16 == ring.write(huge.data(), 20));
+    REQUIRE(4 == ring.dropped());
+    REQUIRE(!ring.push('z'));
+    REQUIRE(5 == ring.dropped());
+}
+
+TEST_CASE("ring hands frames between threads", "[ring-04]") {
+    using ring_type = spsc_ring<256>;
+    ring_type ring;
+    const size_t nframes = 20000;
+    std::vector<bytes> payloads;
+    std::mt19937 rng(31);
+    std::uniform_int_distribution<int> byte(0, 255), length(1, 100);
+    for (size_t i = 0; i < nframes; i++) {
+        bytes p(length(rng));
+        for (auto& c : p) c = static_cast<uint8_t>(byte(rng));
+        payloads.push_back(p);
+    }
+
+    // stands in for the RX interrupt: bursts of 1..16 bytes, retried while full
+    std::thread producer([&] {
+        std::mt19937 prng(5);
+        std::uniform_int_distribution<int> burst(1, 16);
+        for (const bytes& p : payloads) {
+            bytes e = encoded(p);
+            for (size_t i = 0; i < e.size();) {
+                size_t n = std::min<size_t>(burst(prng), e.size() - i);
+                i += ring.write(e.data() + i, n);
+                if (i < e.size()) std::this_thread::yield();
+            }
+        }
+    });
+
+    size_t received = 0, mismatches = 0;
+    ring_type::frame f;
+    while (received < nframes) {
+        if (!ring.next(f)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (contents<ring_type>(f) != payloads[received]) mismatches++;
+        ring.release(f);
+        received++;
+    }
+    producer.join();
+    REQUIRE(0 == mismatches);
+    REQUIRE(0 == ring.errors());
+    REQUIRE(nframes == ring.frames());
+}
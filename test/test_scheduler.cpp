@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipScheduler.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    struct socket_pairs {
+        explicit socket_pairs(size_t n) : fds(n) {
+            for (auto& p : fds) REQUIRE(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, p.data()));
+        }
+        ~socket_pairs() {
+            for (auto& p : fds) {
+                close(p[0]);
+                if (p[1] >= 0) close(p[1]);
+            }
+        }
+        std::vector<std::array<int, 2>> fds; // [0] for the scheduler, [1] for the test
+    };
+
+    std::string frame_of(const std::string& payload) {
+        std::string out(2 * payload.size() + 1, '\0');
+        out.resize(encoder::encode(&out[0], out.size(), payload.data(), payload.size()));
+        return out;
+    }
+
+    // wait up to 10 s for done() to hold
+    template <typename _Fn>
+    bool eventually(_Fn done) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!done()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // decode frames read from fd until count frames arrived
+    std::vector<std::string> read_frames(int fd, size_t count) {
+        std::vector<std::string> frames;
+        std::string cur;
+        char buf[4096];
+        while (frames.size() < count) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) break;
+            for (ssize_t i = 0; i < n; i++) {
+                if (buf[i] != char(0xC0)) {
+                    cur += buf[i];
+                } else if (!cur.empty()) {
+                    std::string f(cur.size(), '\0');
+                    f.resize(decoder::decode(&f[0], f.size(), cur.data(), cur.size()));
+                    frames.push_back(f);
+                    cur.clear();
+                }
+            }
+        }
+        return frames;
+    }
+}
+
+TEST_CASE("work_deque hands out every item once", "[scheduler-01]") {
+    const size_t items = 200000;
+    work_deque<size_t> q(64);
+    std::atomic<bool> done{false};
+    std::vector<std::vector<size_t>> taken(4);
+    std::vector<std::thread> thieves;
+    for (size_t t = 1; t < taken.size(); t++) {
+        thieves.emplace_back([&, t] {
+            size_t x;
+            while (!done.load()) {
+                if (q.steal(x)) taken[t].push_back(x);
+            }
+            while (q.steal(x)) taken[t].push_back(x);
+        });
+    }
+    size_t x;
+    for (size_t i = 0; i < items; i++) {
+        while (!q.push(i)) {
+            if (q.pop(x)) taken[0].push_back(x);
+        }
+        if (i % 3 == 0 && q.pop(x)) taken[0].push_back(x);
+    }
+    while (q.pop(x)) taken[0].push_back(x);
+    done = true;
+    for (auto& t : thieves) t.join();
+
+    std::vector<char> seen(items, 0);
+    size_t total = 0;
+    for (size_t t = 0; t < taken.size(); t++) {
+        for (size_t v : taken[t]) {
+            REQUIRE(v < items);
+            REQUIRE(seen[v] == 0);
+            seen[v] = 1;
+        }
+        total += taken[t].size();
+    }
+    REQUIRE(items == total);
+    REQUIRE(0 == q.size());
+    REQUIRE(!q.pop(x));
+    REQUIRE(!q.steal(x));
+}
+
+TEST_CASE("scheduler handles frames in order and echoes them", "[scheduler-02]") {
+    const size_t nch = 12, rounds = 50;
+    socket_pairs sp(nch);
+    scheduler<> s(nch, 3, 64);
+    REQUIRE(s.ok());
+    std::vector<std::vector<std::string>> got(nch); // each written by one task at a time
+    std::atomic<size_t> handled{0}, off_worker{0}; // Catch is not thread safe: no REQUIRE in handlers
+    for (size_t i = 0; i < nch; i++) {
+        int ch = s.add(sp.fds[i][0], [&](size_t ch, const uint8_t* frame, size_t size) {
+            got[ch].push_back(std::string(reinterpret_cast<const char*>(frame), size));
+            if (s.current_worker() < 0) off_worker++;
+            s.send(ch, frame, size);
+            handled++;
+        });
+        REQUIRE(int(i) == ch);
+        REQUIRE(i % 3 == s.shard(i));
+    }
+    REQUIRE(s.start());
+    REQUIRE(-1 == s.add(sp.fds[0][1], nullptr)); // not while running
+    REQUIRE(-1 == s.current_worker());
+
+    std::vector<std::vector<std::string>> sent(nch);
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < nch; i++) {
+            std::string payload = std::to_string(i) + "/" + std::to_string(r) + std::string(r % 4, char(0xC0)) + "\xDB";
+            std::string f       = frame_of(payload);
+            size_t cut          = (r + i) % f.size();
+            REQUIRE(cut == size_t(write(sp.fds[i][1], f.data(), cut)));
+            REQUIRE(f.size() - cut == size_t(write(sp.fds[i][1], f.data() + cut, f.size() - cut)));
+            sent[i].push_back(payload);
+        }
+    }
+    for (size_t i = 0; i < nch; i++) REQUIRE(sent[i] == read_frames(sp.fds[i][1], rounds));
+    REQUIRE(handled == nch * rounds);
+    REQUIRE(0 == off_worker);
+
+    REQUIRE(s.send(5, "from outside", 12)); // a thread that is not a worker
+    REQUIRE((std::vector<std::string>{"from outside"}) == read_frames(sp.fds[5][1], 1));
+    s.stop();
+    uint64_t tasks = 0;
+    for (size_t w = 0; w < s.workers(); w++) tasks += s.tasks(w);
+    REQUIRE(tasks > 0);
+    for (size_t i = 0; i < nch; i++) {
+        REQUIRE(sent[i] == got[i]);
+        REQUIRE(rounds == s.frames(i));
+        REQUIRE(0 == s.pending(i));
+    }
+}
+
+TEST_CASE("idle workers steal ready channels from a busy shard", "[scheduler-03]") {
+    const size_t nch = 8, per_channel = 5;
+    socket_pairs sp(nch);
+    scheduler<> s(nch, 4, 64);
+    std::mutex lock;
+    std::set<int> workers_seen;
+    std::vector<std::vector<int>> got(nch);
+    std::atomic<size_t> handled{0};
+    for (size_t i = 0; i < nch; i++) {
+        s.add(sp.fds[i][0],
+              [&](size_t ch, const uint8_t* frame, size_t size) {
+                  got[ch].push_back(std::stoi(std::string(reinterpret_cast<const char*>(frame), size)));
+                  {
+                      std::lock_guard<std::mutex> g(lock);
+                      workers_seen.insert(s.current_worker());
+                  }
+                  std::this_thread::sleep_for(std::chrono::milliseconds(2)); // a slow handler
+                  handled++;
+              },
+              0); // every channel on worker 0
+    }
+    REQUIRE(s.start(false));
+    for (size_t k = 0; k < per_channel; k++) {
+        for (size_t i = 0; i < nch; i++) {
+            std::string f = frame_of(std::to_string(k));
+            REQUIRE(f.size() == size_t(write(sp.fds[i][1], f.data(), f.size())));
+        }
+    }
+    REQUIRE(eventually([&] { return handled.load() == nch * per_channel; }));
+    s.stop();
+    uint64_t steals = 0;
+    for (size_t w = 0; w < s.workers(); w++) steals += s.steals(w);
+    REQUIRE(steals > 0);
+    REQUIRE(workers_seen.size() > 1);
+    for (size_t i = 0; i < nch; i++) REQUIRE((std::vector<int>{0, 1, 2, 3, 4}) == got[i]);
+}
+
+TEST_CASE("scheduler closes channels at end of file and on remove", "[scheduler-04]") {
+    socket_pairs sp(3);
+    scheduler<> s(3, 2, 64);
+    std::vector<std::vector<std::string>> got(3);
+    for (size_t i = 0; i < 3; i++) {
+        s.add(sp.fds[i][0], [&](size_t ch, const uint8_t* frame, size_t size) {
+            got[ch].push_back(std::string(reinterpret_cast<const char*>(frame), size));
+        });
+    }
+    REQUIRE(3 == s.open_channels());
+    s.start();
+    std::string data = frame_of("one") + "two";
+    REQUIRE(data.size() == size_t(write(sp.fds[0][1], data.data(), data.size())));
+    close(sp.fds[0][1]);
+    sp.fds[0][1] = -1;
+    REQUIRE(eventually([&] { return !s.is_open(0); }));
+    REQUIRE(0 == s.error(0));
+    REQUIRE(!s.send(0, "x", 1));
+
+    s.remove(1);
+    REQUIRE(eventually([&] { return !s.is_open(1); }));
+    REQUIRE(1 == s.open_channels());
+    REQUIRE(s.is_open(2));
+    s.stop();
+    REQUIRE((std::vector<std::string>{"one", "two"}) == got[0]); // the last frame has no END
+}
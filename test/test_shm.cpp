@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipShm.h>
+#include <chrono>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    std::string payload_of(size_t i) {
+        std::string p = "frame " + std::to_string(i);
+        p += std::string(i % 7, char(0xC0)) + std::string(i % 5, char(0xDB)) + std::string(i % 13, 'x');
+        return p;
+    }
+
+    std::string decode_frame(const shm_frame<>& f) {
+        std::string out(f.size, '\0');
+        out.resize(f.decode(reinterpret_cast<uint8_t*>(&out[0]), out.size()));
+        return out;
+    }
+
+    // FNV-1a over the decoded frames, the same in the parent and in the children
+    uint64_t mix(uint64_t h, const std::string& s) {
+        for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+        return (h ^ s.size()) * 1099511628211ull;
+    }
+}
+
+TEST_CASE("shm ring hands frames to a consumer in place and wraps", "[shm-01]") {
+    shm_producer<> tx(nullptr, 256, 2);
+    REQUIRE(tx.ok());
+    REQUIRE(256 == tx.capacity());
+    shm_consumer<> rx(tx.fd());
+    REQUIRE(rx.ok());
+    REQUIRE(1 == tx.consumers());
+
+    shm_consumer<>::frame f;
+    REQUIRE(!rx.next(f));
+    REQUIRE(!rx.wait(0));
+    REQUIRE(!tx.publish("", 0));
+
+    // many times round the small ring, in batches, so frames wrap and pad
+    size_t sent = 0, got = 0;
+    for (int round = 0; round < 200; round++) {
+        size_t batch = 1 + round % 4;
+        for (size_t k = 0; k < batch; k++, sent++) {
+            std::string p = payload_of(sent);
+            REQUIRE(tx.publish(p.data(), p.size()));
+        }
+        while (rx.next(f)) {
+            REQUIRE(f.valid());
+            REQUIRE(f.data[f.size - 1] == encoder::end_code());
+            REQUIRE(payload_of(got).size() == f.decoded_size());
+            REQUIRE(payload_of(got) == decode_frame(f));
+            got++;
+        }
+        rx.release(f);
+    }
+    REQUIRE(sent == got);
+    REQUIRE(got == rx.frames());
+    REQUIRE(0 == tx.dropped());
+
+    tx.close();
+    REQUIRE(rx.closed());
+    REQUIRE(!rx.wait(-1));
+}
+
+TEST_CASE("shm ring keeps unreleased frames and drops what does not fit", "[shm-02]") {
+    shm_producer<> tx("/slip-test-shm-02", 128, 1);
+    REQUIRE(tx.ok());
+    std::string big(40, 'b');
+    REQUIRE(tx.publish(big.data(), big.size())); // no consumer: nobody holds room
+    {
+        shm_consumer<> rx("/slip-test-shm-02");
+        REQUIRE(rx.ok());
+        shm_consumer<> second("/slip-test-shm-02");
+        REQUIRE(!second.ok()); // one slot only
+
+        shm_consumer<>::frame f, first;
+        REQUIRE(!rx.next(f)); // attached after that frame
+        size_t n = 0;
+        while (tx.publish(big.data(), big.size())) n++;
+        REQUIRE(3 == n); // the third wraps over the frame published before rx attached
+        REQUIRE(1 == tx.dropped());
+        REQUIRE(!tx.publish_wait(big.data(), big.size(), 20)); // times out
+        REQUIRE(!tx.publish(std::string(200, 'x').data(), 200));
+        REQUIRE(3 == tx.dropped());
+
+        REQUIRE(rx.next(first));
+        REQUIRE(big == decode_frame(first));
+        REQUIRE(!tx.publish(big.data(), big.size())); // next() alone frees nothing
+        rx.release(first);
+        REQUIRE(tx.publish(big.data(), big.size()));
+        for (int i = 0; i < 3; i++) {
+            REQUIRE(rx.next(f));
+            REQUIRE(big == decode_frame(f));
+        }
+        REQUIRE(!rx.next(f));
+    }
+    REQUIRE(0 == tx.consumers()); // detached
+    REQUIRE(tx.publish(big.data(), big.size()));
+
+    // a frame with a bad escape does not validate
+    const uint8_t bad[] = {'a', 0xDB, 'z', 0xC0};
+    shm_frame<> b;
+    b.data = bad;
+    b.size = sizeof(bad);
+    REQUIRE(!b.valid());
+}
+
+TEST_CASE("shm ring delivers to consumer processes with futex wakeups", "[shm-03]") {
+    const size_t nframes = 20000, nconsumers = 3;
+    shm_producer<> tx(nullptr, 4096, nconsumers);
+    REQUIRE(tx.ok());
+    tx.set_notify_batch(8);
+
+    std::vector<pid_t> children;
+    std::vector<int> results;
+    for (size_t c = 0; c < nconsumers; c++) {
+        int p[2];
+        REQUIRE(0 == pipe(p));
+        pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) { // consumer: no Catch in here
+            close(p[0]);
+            shm_consumer<> rx(tx.fd());
+            uint64_t got[2] = {0, 14695981039346656037ull};
+            write(p[1], got, 1); // attached
+            shm_consumer<>::frame f;
+            while (rx.wait(5000)) {
+                bool any = false;
+                while (rx.next(f)) {
+                    got[1] = mix(got[1], decode_frame(f));
+                    got[0]++;
+                    any = true;
+                }
+                if (any) rx.release(f);
+            }
+            write(p[1], got, sizeof(got));
+            _exit(rx.closed() ? 0 : 1);
+        }
+        close(p[1]);
+        char ready;
+        REQUIRE(1 == read(p[0], &ready, 1));
+        children.push_back(pid);
+        results.push_back(p[0]);
+    }
+    REQUIRE(nconsumers == tx.consumers());
+
+    uint64_t expect = 14695981039346656037ull;
+    for (size_t i = 0; i < nframes; i++) {
+        std::string p = payload_of(i);
+        REQUIRE(tx.publish_wait(p.data(), p.size(), 5000)); // the ring is much smaller than the frames
+        expect = mix(expect, p);
+        if (i % 1000 == 999) std::this_thread::sleep_for(std::chrono::milliseconds(2)); // let consumers sleep
+    }
+    tx.notify();
+    tx.close();
+
+    for (size_t c = 0; c < nconsumers; c++) {
+        uint64_t got[2] = {0, 0};
+        REQUIRE(sizeof(got) == size_t(read(results[c], got, sizeof(got))));
+        close(results[c]);
+        int status;
+        REQUIRE(children[c] == waitpid(children[c], &status, 0));
+        REQUIRE(WIFEXITED(status));
+        REQUIRE(0 == WEXITSTATUS(status));
+        REQUIRE(nframes == got[0]);
+        REQUIRE(expect == got[1]);
+    }
+    REQUIRE(nframes == tx.frames());
+    REQUIRE(0 == tx.dropped());
+    REQUIRE(tx.wakeups() > 0);
+    REQUIRE(nconsumers == tx.reap()); // the children _exit()ed without detaching
+    REQUIRE(0 == tx.consumers());
+}
@@ -29,3 +29,47 @@ TEST_CASE("escaped", "[slip_utils-01]") {
     res = escaped(src.c_str(), src.length(), NULL);
     REQUIRE("\\'\\\"\\?\\\\\\a\\b\\f\\n\\r\\t\\vABCabc\\300\\301" == res);
 }
+
+TEST_CASE("escaped into caller buffers", "[slip_utils-02]") {
+    using namespace slip;
+    using namespace std;
+    string src("Lo\300rus\n\0", 8);
+    REQUIRE(15 == escaped_size(src.data(), src.size(), "[]"));
+    char buf[15];
+    REQUIRE(0 == escaped_to(buf, sizeof(buf) - 1, src.data(), src.size(), "[]"));
+    REQUIRE(15 == escaped_to(buf, sizeof(buf), src.data(), src.size(), "[]"));
+    REQUIRE("[Lo\\300rus\\n\\0]" == string(buf, 15));
+    char big[64];
+    memset(big, '~', sizeof(big));
+    REQUIRE(1 == escaped_to(big, sizeof(big), "A", 1, NULL));
+    REQUIRE(string(sizeof(big) - 1, '~') == string(big + 1, sizeof(big) - 1)); // the rest untouched
+    memset(big, '~', sizeof(big));
+    REQUIRE(15 == escaped_to(big, sizeof(big), src.data(), src.size(), "[]"));
+    REQUIRE("[Lo\\300rus\\n\\0]" == string(big, 15));
+    REQUIRE(string(sizeof(big) - 15, '~') == string(big + 15, sizeof(big) - 15));
+    string out("src: ");
+    out.reserve(64);
+    const char* data = out.data();
+    escaped_append(out, src.data(), src.size(), "");
+    REQUIRE("src: Lo\\300rus\\n\\0" == out);
+    REQUIRE(data == out.data()); // no allocation
+    for (int c = 0; c < 256; c++) {
+        char ch = char(c);
+        REQUIRE(escaped_size(&ch, 1, NULL) == escaped(&ch, 1, NULL).size());
+    }
+}
+
+TEST_CASE("hexdump", "[slip_utils-03]") {
+    using namespace slip;
+    using namespace std;
+    const unsigned char src[] = {0xc0, 0xdb, 0x01, 0x7f};
+    REQUIRE("c0 db 01 7f" == hexdump(src, sizeof(src)));
+    REQUIRE("c0db017f" == hexdump(src, sizeof(src), 0));
+    REQUIRE("" == hexdump(src, 0));
+    char buf[11];
+    REQUIRE(0 == hexdump_to(buf, 10, src, sizeof(src)));
+    REQUIRE(11 == hexdump_to(buf, 11, src, sizeof(src), ':'));
+    REQUIRE("c0:db:01:7f" == string(buf, 11));
+    string out("> ");
+    REQUIRE("> c0 db" == hexdump_append(out, src, 2));
+}
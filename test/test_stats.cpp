@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipKernels.h>
+#include <SlipStats.h>
+#include <string>
+#include <thread>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    struct hr_link;
+    struct hrnull_link;
+    struct std_link;
+    struct kernel_link;
+    struct thread_link;
+
+    using hr_stats     = counting_stats<hr_link>;
+    using encoder_hr_s = encoder_base<char, '#', 'D', '^', '[', 0, 0, hr_stats>;
+    using decoder_hr_s = decoder_base<char, '#', 'D', '^', '[', 0, 0, hr_stats>;
+
+    using hrnull_stats     = counting_stats<hrnull_link>;
+    using encoder_hrnull_s = encoder_base<char, '#', 'D', '^', '[', '0', '@', hrnull_stats>;
+    using decoder_hrnull_s = decoder_base<char, '#', 'D', '^', '[', '0', '@', hrnull_stats>;
+}
+
+TEST_CASE("no_stats is the default", "[stats-01]") {
+    REQUIRE(!encoder_hr::stats::enabled);
+    REQUIRE(!decoder::stats::enabled);
+    REQUIRE(encoder_hr_s::stats::enabled);
+}
+
+TEST_CASE("counting encode and decode", "[stats-02]") {
+    hr_stats::reset();
+    char buf[64];
+    const std::string src = "ab#cd^^e";
+    size_t esize          = encoder_hr_s::encode(buf, sizeof(buf), src.c_str(), src.length());
+    REQUIRE(std::string("ab^Dcd^[^[e#") == std::string(buf, esize));
+    esize = encoder_hr_s::encode(buf, sizeof(buf), "plain", 5);
+    REQUIRE(6 == esize);
+    REQUIRE(0 == encoder_hr_s::encode(buf, 4, "plain", 5));
+    REQUIRE(0 == encoder_hr_s::encode(buf, 3, "a#", 2)); // room without the escape, not with it
+
+    codec_counters c = hr_stats::snapshot();
+    REQUIRE(2 == c.encoded_frames);
+    REQUIRE(13 == c.encoded_bytes);
+    REQUIRE(1 == c.encoded_escapes[0]);
+    REQUIRE(2 == c.encoded_escapes[1]);
+    REQUIRE(0 == c.encoded_escapes[2]);
+    REQUIRE(2 == c.encode_overflows);
+
+    char out[64];
+    REQUIRE(8 == decoder_hr_s::decode(out, sizeof(out), "ab^Dcd^[^[e#", 12));
+    REQUIRE(3 == decoder_hr_s::decode(out, sizeof(out), "xyz", 3));       // no END
+    REQUIRE(0 == decoder_hr_s::decode(out, sizeof(out), "ab^Xc#", 6));    // bad escape
+    REQUIRE(0 == decoder_hr_s::decode(out, sizeof(out), "ab^", 3));       // truncated escape
+    REQUIRE(0 == decoder_hr_s::decode(out, 2, "abc#", 4));                // overflow
+    REQUIRE(0 == decoder_hr_s::decode(out, 1, "a^D#", 4));                // overflow at an escape
+    c = hr_stats::snapshot();
+    REQUIRE(2 == c.decoded_frames);
+    REQUIRE(11 == c.decoded_bytes);
+    REQUIRE(1 == c.decoded_escapes[0]);
+    REQUIRE(2 == c.decoded_escapes[1]);
+    REQUIRE(1 == c.unterminated);
+    REQUIRE(1 == c.errors(decode_error::bad_escape));
+    REQUIRE(1 == c.errors(decode_error::truncated_escape));
+    REQUIRE(2 == c.errors(decode_error::overflow));
+
+    hr_stats::reset();
+    c = hr_stats::snapshot();
+    REQUIRE(0 == c.encoded_frames);
+    REQUIRE(0 == c.decoded_frames);
+    REQUIRE(0 == c.errors(decode_error::overflow));
+}
+
+TEST_CASE("counting in place and with room", "[stats-03]") {
+    hr_stats::reset();
+    char buf[32] = "#a^b";
+    size_t esize = encoder_hr_s::encode(buf, sizeof(buf), buf, 4);
+    REQUIRE(std::string("^Da^[b#") == std::string(buf, esize));
+    REQUIRE(4 == decoder_hr_s::decode(buf, sizeof(buf), buf, esize));
+    REQUIRE(std::string("#a^b") == std::string(buf, 4));
+
+    char room[6]  = {'.', '.', '#', '.', '.', '.'};
+    size_t offset = 2;
+    REQUIRE(0 == encoder_hr_s::encode_with_room(room, sizeof(room), offset, 1, 2, 2));
+    esize = encoder_hr_s::encode_with_room(room, sizeof(room), offset, 1, 2, 0);
+    REQUIRE(3 == esize);
+
+    codec_counters c = hr_stats::snapshot();
+    REQUIRE(2 == c.encoded_frames);
+    REQUIRE(5 == c.encoded_bytes);
+    REQUIRE(2 == c.encoded_escapes[0]);
+    REQUIRE(1 == c.encoded_escapes[1]);
+    REQUIRE(1 == c.encode_overflows);
+    REQUIRE(1 == c.decoded_frames);
+    REQUIRE(1 == c.decoded_escapes[0]);
+}
+
+TEST_CASE("counting NULL escapes", "[stats-04]") {
+    hrnull_stats::reset();
+    char buf[32];
+    size_t esize = encoder_hrnull_s::encode(buf, sizeof(buf), "0a0#", 4);
+    REQUIRE(std::string("^@a^@^D#") == std::string(buf, esize));
+    char out[32];
+    REQUIRE(4 == decoder_hrnull_s::decode(out, sizeof(out), buf, esize));
+    codec_counters c = hrnull_stats::snapshot();
+    REQUIRE(2 == c.encoded_escapes[2]);
+    REQUIRE(1 == c.encoded_escapes[0]);
+    REQUIRE(2 == c.decoded_escapes[2]);
+    REQUIRE(1 == c.decoded_escapes[0]);
+}
+
+TEST_CASE("counting standard SLIP and kernels", "[stats-05]") {
+    using enc = slip_encoder_base<uint8_t, counting_stats<std_link>>;
+    using dec = slip_decoder_base<uint8_t, counting_stats<std_link>>;
+    counting_stats<std_link>::reset();
+    uint8_t src[100];
+    for (size_t i = 0; i < sizeof(src); i++) src[i] = static_cast<uint8_t>(i * 41);
+    size_t nspecial = 0;
+    for (uint8_t ch : src) nspecial += (ch == stdcodes::SLIP_END || ch == stdcodes::SLIP_ESC) ? 1 : 0;
+    uint8_t ebuf[256], dbuf[256];
+    size_t esize = enc::encode(ebuf, sizeof(ebuf), src, sizeof(src));
+    REQUIRE(sizeof(src) == dec::decode(dbuf, sizeof(dbuf), ebuf, esize));
+    codec_counters scalar = counting_stats<std_link>::snapshot();
+    REQUIRE(1 == scalar.encoded_frames);
+    REQUIRE(nspecial == scalar.encoded_escapes[0] + scalar.encoded_escapes[1]);
+
+    using kstats = counting_stats<kernel_link>;
+    using kenc   = slip_encoder_base<uint8_t, kstats>;
+    using kdec   = slip_decoder_base<uint8_t, kstats>;
+    for (int k = 0; k < static_cast<int>(kernel_id::num_kernels); k++) {
+        kernel_id kid = static_cast<kernel_id>(k);
+        auto encode   = kernels<kenc>::encode(kid);
+        auto decode   = kernels<kdec>::decode(kid);
+        if (!kernel_supported(kid) || !encode || !decode) continue;
+        kstats::reset();
+        REQUIRE(esize == encode(ebuf, sizeof(ebuf), src, sizeof(src)));
+        REQUIRE(sizeof(src) == decode(dbuf, sizeof(dbuf), ebuf, esize));
+        REQUIRE(0 == decode(dbuf, 10, ebuf, esize));
+        codec_counters c = kstats::snapshot();
+        REQUIRE(scalar.encoded_frames == c.encoded_frames);
+        REQUIRE(scalar.encoded_bytes == c.encoded_bytes);
+        REQUIRE(scalar.encoded_escapes[0] == c.encoded_escapes[0]);
+        REQUIRE(scalar.encoded_escapes[1] == c.encoded_escapes[1]);
+        REQUIRE(scalar.decoded_escapes[1] == c.decoded_escapes[1]);
+        REQUIRE(1 == c.errors(decode_error::overflow));
+    }
+}
+
+TEST_CASE("thread_stats keeps counters per thread", "[stats-06]") {
+    using tstats = thread_stats<thread_link>;
+    using enc    = slip_encoder_base<uint8_t, tstats>;
+    tstats::reset();
+    const uint8_t abcdef[] = {'a', 'b', 'c', 'd', 'e', 'f'};
+    uint8_t buf[16];
+    enc::encode(buf, sizeof(buf), abcdef, 3);
+    codec_counters other;
+    std::thread t([&other, &abcdef] {
+        uint8_t tbuf[16];
+        enc::encode(tbuf, sizeof(tbuf), abcdef + 3, 2);
+        enc::encode(tbuf, sizeof(tbuf), abcdef + 5, 1);
+        other = tstats::snapshot();
+    });
+    t.join();
+    codec_counters mine = tstats::snapshot();
+    REQUIRE(1 == mine.encoded_frames);
+    REQUIRE(2 == other.encoded_frames);
+    mine += other;
+    REQUIRE(3 == mine.encoded_frames);
+    REQUIRE(6 == mine.encoded_bytes);
+}
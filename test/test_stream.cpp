@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include "hrslip.h"
+#include <SlipStream.h>
+#include <algorithm>
+#include <string>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    // decode stream in chunks of the given sizes, in place, with '|' after each frame
+    std::string decode_chunks(stream_decoder<decoder_hr>& dec, std::string stream, size_t first, size_t rest) {
+        std::string out;
+        auto mark = [](char* at) {
+            *at = '|';
+            return size_t(1);
+        };
+        for (size_t at = 0, n = first; at < stream.size(); at += n, n = rest) {
+            n        = std::min(n, stream.size() - at);
+            size_t d = dec.decode(&stream[at], &stream[at], n, mark);
+            REQUIRE(d <= n);
+            out.append(&stream[at], d);
+        }
+        char last;
+        out.append(&last, dec.finish(&last, mark));
+        return out;
+    }
+}
+
+TEST_CASE("stream decoder gives the same frames at every chunk boundary", "[stream-01]") {
+    const std::string stream = "#ab^Dc#^[#d^[^De##xyz";
+    for (size_t first = 1; first <= stream.size(); first++) {
+        for (size_t rest = 1; rest <= 4; rest++) {
+            stream_decoder<decoder_hr> dec;
+            REQUIRE("ab#c|^|d^#e|xyz|" == decode_chunks(dec, stream, first, rest));
+            REQUIRE(4 == dec.frames());
+            REQUIRE(0 == dec.errors());
+        }
+    }
+}
+
+TEST_CASE("stream decoder drops frames with bad escapes", "[stream-02]") {
+    for (size_t first = 1; first <= 8; first++) {
+        stream_decoder<decoder_hr> dec;
+        std::string out = decode_chunks(dec, "ab^x#cd^#ef#gh^", first, 3);
+        // bad escape, truncated escape, escape at the end. Pieces of a bad frame decoded
+        // in an earlier chunk are kept, but the frame is not closed.
+        REQUIRE(out.find("ef|") != std::string::npos);
+        REQUIRE(1 == std::count(out.begin(), out.end(), '|'));
+        REQUIRE(1 == dec.frames());
+        REQUIRE(3 == dec.errors());
+    }
+}
+
+TEST_CASE("stream encoder splits frames across pieces", "[stream-03]") {
+    stream_encoder<encoder_hr> enc;
+    const std::string payload = "a#b^c";
+    char out[32];
+    size_t n = 0;
+    for (size_t at = 0; at < payload.size(); at += 2)
+        n += enc.encode(out + n, sizeof(out) - n, payload.data() + at, std::min<size_t>(2, payload.size() - at));
+    REQUIRE(enc.in_frame());
+    n += enc.end(out + n);
+    REQUIRE(!enc.in_frame());
+    REQUIRE(1 == enc.frames());
+    REQUIRE("a^Db^[c#" == std::string(out, n));
+    REQUIRE(0 == enc.encode(out, sizeof(out), payload.data(), 0));
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipRing.h>
+#include <SlipTrace.h>
+#include <sstream>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    struct trace_link;
+    using tracer = frame_tracer<trace_link>;
+}
+
+TEST_CASE("ring records arrival, END and delivery", "[trace-01]") {
+    tracer::clear();
+    spsc_ring<64, decoder, tracer> ring;
+    spsc_ring<64, decoder, tracer>::frame f;
+    const uint8_t lead[]  = {'z'}; // the report does not trust the first arrival of a ring
+    const uint8_t first[] = {'a', 'b', stdcodes::SLIP_END, 'c'};
+    const uint8_t rest[]  = {'d', stdcodes::SLIP_END};
+    ring.write(lead, sizeof(lead));
+    ring.write(first, sizeof(first));
+    REQUIRE(ring.next(f));
+    ring.release(f);
+    REQUIRE(!ring.next(f));
+    ring.write(rest, sizeof(rest));
+    REQUIRE(ring.next(f));
+    ring.release(f);
+
+    std::vector<trace_event> events = tracer::events();
+    REQUIRE(7 == events.size());
+    size_t kinds[3] = {};
+    for (const trace_event& e : events) {
+        REQUIRE(&ring == e.source);
+        kinds[static_cast<int>(e.kind)]++;
+    }
+    REQUIRE(3 == kinds[static_cast<int>(trace_kind::arrived)]);
+    REQUIRE(2 == kinds[static_cast<int>(trace_kind::end_found)]);
+    REQUIRE(2 == kinds[static_cast<int>(trace_kind::delivered)]);
+
+    latency_report r = tracer::report();
+    REQUIRE(2 == r.arrival_to_delivery.count);
+    REQUIRE(r.arrival_to_delivery.min <= r.arrival_to_delivery.max);
+    std::ostringstream os;
+    r.print(os);
+    REQUIRE(os.str().find("arrival -> delivery: 2 frames") != std::string::npos);
+
+    tracer::clear();
+    REQUIRE(tracer::events().empty());
+}
+
+TEST_CASE("latency report matches frames to arrivals", "[trace-02]") {
+    int ring_a = 0, ring_b = 0;
+    std::vector<trace_event> events = {
+        {90, 2, &ring_a, trace_kind::arrived},     // seen before the arrivals that count
+        {100, 10, &ring_a, trace_kind::arrived},   // brings the END at 6
+        {110, 7, &ring_a, trace_kind::end_found},
+        {115, 7, &ring_a, trace_kind::delivered},
+        {150, 20, &ring_a, trace_kind::arrived},   // brings the END at 10
+        {155, 11, &ring_a, trace_kind::end_found},
+        {160, 11, &ring_a, trace_kind::delivered},
+        {450, 1, &ring_b, trace_kind::arrived},
+        {500, 4, &ring_b, trace_kind::arrived},
+        {900, 4, &ring_b, trace_kind::end_found},
+        {1000, 4, &ring_b, trace_kind::delivered},
+        {2000, 50, &ring_b, trace_kind::delivered}, // arrival overwritten
+    };
+    latency_report r(events, 1.0);
+    REQUIRE(3 == r.arrival_to_delivery.count);
+    REQUIRE(10 == r.arrival_to_delivery.min);
+    REQUIRE(15 == r.arrival_to_delivery.p50);
+    REQUIRE(500 == r.arrival_to_delivery.max);
+    REQUIRE(5 == r.arrival_to_end.min);
+    REQUIRE(400 == r.arrival_to_end.max);
+    REQUIRE(100 == r.end_to_delivery.max);
+    REQUIRE(2 == r.arrival_to_delivery.histogram[3]); // 10 and 15 in [8, 16)
+    REQUIRE(1 == r.arrival_to_delivery.histogram[8]); // 500 in [256, 512)
+}
+
+TEST_CASE("latency report leaves out frames whose arrival was overwritten", "[trace-03]") {
+    struct wrap_link;
+    using wrap_tracer = frame_tracer<wrap_link>;
+    wrap_tracer::clear();
+    spsc_ring<64, decoder, wrap_tracer> ring;
+    spsc_ring<64, decoder, wrap_tracer>::frame f;
+    const uint8_t head[] = {'a', 'b'};
+    const uint8_t tail[] = {'c', stdcodes::SLIP_END, 'd', stdcodes::SLIP_END};
+    const size_t rounds  = trace_buffer::capacity; // 6 events per round: the buffer wraps several times
+    for (size_t i = 0; i < rounds; i++) {
+        ring.write(head, sizeof(head));
+        ring.write(tail, sizeof(tail));
+        while (ring.next(f)) ring.release(f);
+    }
+
+    std::vector<trace_event> events = wrap_tracer::events();
+    REQUIRE(events.size() < trace_buffer::capacity);
+    latency_report r(events);
+    REQUIRE(r.arrival_to_delivery.count > 0);
+    REQUIRE(r.arrival_to_delivery.count < 2 * rounds);
+    REQUIRE(r.arrival_to_end.min > 0); // no frame matched to an arrival after its END
+    REQUIRE(r.arrival_to_delivery.min > 0);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipTraceLog.h>
+#include <atomic>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    std::vector<trace_record> read_all(FILE* f) {
+        rewind(f);
+        trace_reader in(f);
+        REQUIRE(in.good());
+        std::vector<trace_record> out;
+        trace_record r;
+        while (in.next(r)) out.push_back(r);
+        REQUIRE(in.good());
+        return out;
+    }
+}
+
+TEST_CASE("trace logger writes frames from several threads", "[tracelog-01]") {
+    FILE* f = tmpfile();
+    REQUIRE(f);
+    {
+        trace_logger log(f, 64, 16, trace_overflow::wait);
+        log.start();
+        std::vector<std::thread> producers;
+        std::atomic<int> refused{0};
+        for (uint16_t link = 0; link < 4; link++) {
+            producers.emplace_back([&log, &refused, link] {
+                for (uint8_t i = 0; i < 100; i++) {
+                    uint8_t frame[3] = {static_cast<uint8_t>(link), i, stdcodes::SLIP_END};
+                    if (!log.log(trace_direction::tx, link, frame, sizeof(frame))) refused++;
+                }
+            });
+        }
+        for (auto& t : producers) t.join();
+        log.stop();
+        REQUIRE(0 == refused);
+        REQUIRE(400 == log.written());
+        REQUIRE(0 == log.dropped());
+    }
+    std::vector<trace_record> records = read_all(f);
+    REQUIRE(400 == records.size());
+    uint8_t next[4] = {};
+    for (const trace_record& r : records) {
+        REQUIRE(r.link < 4);
+        REQUIRE(trace_direction::tx == r.direction);
+        REQUIRE(3 == r.data.size());
+        REQUIRE(r.link == static_cast<uint8_t>(r.data[0]));
+        REQUIRE(next[r.link]++ == static_cast<uint8_t>(r.data[1])); // in order per producer
+    }
+    fclose(f);
+}
+
+TEST_CASE("trace logger drops when full and truncates long frames", "[tracelog-02]") {
+    FILE* f = tmpfile();
+    REQUIRE(f);
+    trace_logger log(f, 4, 8);
+    const char frame[] = "0123456789";
+    for (int i = 0; i < 6; i++) log.log(trace_direction::rx, 7, frame, i < 4 ? 10 : 3);
+    REQUIRE(2 == log.dropped());
+    log.start();
+    log.stop();
+    REQUIRE(4 == log.written());
+    std::vector<trace_record> records = read_all(f);
+    REQUIRE(4 == records.size());
+    REQUIRE(10 == records[0].size);
+    REQUIRE(records[0].truncated());
+    REQUIRE("01234567" == records[0].data);
+    std::string line = trace_reader::format(records[0]);
+    REQUIRE(line.find("Z link 7 rx 10 \"01234567\"...") != std::string::npos);
+    fclose(f);
+}
+
+TEST_CASE("logged codecs log what they encode and decode", "[tracelog-03]") {
+    struct tag;
+    using enc = logged_encoder<encoder, tag>;
+    using dec = logged_decoder<decoder, tag>;
+    FILE* f = tmpfile();
+    REQUIRE(f);
+    trace_logger log(f);
+    const uint8_t payload[] = {'a', stdcodes::SLIP_END, 'b'};
+    uint8_t frame[8], out[8];
+    REQUIRE(5 == enc::encode(frame, sizeof(frame), payload, sizeof(payload))); // not attached yet
+    enc::attach(&log, 3);
+    dec::attach(&log, 3);
+    size_t esize = enc::encode(frame, sizeof(frame), payload, sizeof(payload));
+    REQUIRE(3 == dec::decode(out, sizeof(out), frame, esize));
+    REQUIRE(0 == enc::encode(frame, 2, payload, sizeof(payload))); // failed encodes are not logged
+    enc::attach(nullptr);
+    dec::attach(nullptr);
+    log.start();
+    log.stop();
+    std::vector<trace_record> records = read_all(f);
+    REQUIRE(2 == records.size());
+    REQUIRE(trace_direction::tx == records[0].direction);
+    REQUIRE(trace_direction::rx == records[1].direction);
+    REQUIRE(3 == records[1].link);
+    REQUIRE(std::string(reinterpret_cast<char*>(frame), esize) == records[0].data);
+    REQUIRE(records[0].data == records[1].data);
+    fclose(f);
+}
+
+TEST_CASE("trace reader rejects other files", "[tracelog-04]") {
+    FILE* f = tmpfile();
+    REQUIRE(f);
+    fputs("not a trace file", f);
+    rewind(f);
+    trace_reader in(f);
+    trace_record r;
+    REQUIRE(!in.good());
+    REQUIRE(!in.next(r));
+    fclose(f);
+}
+
+TEST_CASE("logger detaches itself from logged codecs", "[tracelog-05]") {
+    struct tag;
+    using enc = logged_encoder<encoder, tag>;
+    const uint8_t payload[] = {'x', 'y', stdcodes::SLIP_ESC};
+    std::atomic<bool> done{false};
+    std::atomic<size_t> encoded{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; t++) {
+        threads.emplace_back([&] {
+            uint8_t frame[16];
+            while (!done.load()) {
+                if (enc::encode(frame, sizeof(frame), payload, sizeof(payload))) encoded++;
+            }
+        });
+    }
+    size_t logged = 0;
+    for (int round = 0; round < 50; round++) {
+        FILE* f = tmpfile();
+        REQUIRE(f);
+        {
+            trace_logger log(f, 64);
+            log.start();
+            enc::attach(&log, uint16_t(round));
+            size_t at = encoded.load();
+            while (encoded.load() < at + 10) std::this_thread::yield();
+        } // destroyed while attached and in use
+        logged += read_all(f).size();
+        fclose(f);
+    }
+    size_t before = encoded.load();
+    while (encoded.load() < before + 100) std::this_thread::yield(); // still encoding, with no logger
+    done = true;
+    for (auto& t : threads) t.join();
+    REQUIRE(logged > 0);
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipUring.h>
+#include <array>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+namespace {
+    struct pipes {
+        explicit pipes(size_t n) : fds(n) {
+            for (auto& p : fds) REQUIRE(0 == pipe(p.data()));
+        }
+        ~pipes() {
+            for (auto& p : fds) {
+                close(p[0]);
+                if (p[1] >= 0) close(p[1]);
+            }
+        }
+        void write_all(size_t i, const std::string& s) { REQUIRE(s.size() == size_t(write(fds[i][1], s.data(), s.size()))); }
+        void close_writer(size_t i) {
+            close(fds[i][1]);
+            fds[i][1] = -1;
+        }
+        std::vector<std::array<int, 2>> fds;
+    };
+
+    std::string frame_of(const std::string& payload) {
+        std::string out(2 * payload.size() + 1, '\0');
+        out.resize(encoder::encode(&out[0], out.size(), payload.data(), payload.size()));
+        return out;
+    }
+
+    // collect frames per channel until every channel has expected frames or nothing arrives
+    template <class READER>
+    void collect(READER& rx, std::vector<std::vector<std::string>>& got, size_t expected) {
+        size_t total = 0;
+        for (auto& g : got) total += g.size();
+        while (total < expected && rx.wait(1000)) {
+            typename READER::frame f;
+            while (rx.next(f)) {
+                got[f.channel].push_back(std::string(reinterpret_cast<const char*>(f.data), f.size));
+                total++;
+            }
+        }
+    }
+}
+
+TEST_CASE("uring reader decodes frames from many pipes", "[uring-01]") {
+    const size_t nch = 8;
+    uring_reader<> rx(nch, 64);
+    if (!rx.ok()) {
+        WARN("io_uring is not available");
+        return;
+    }
+    pipes p(nch);
+    for (size_t i = 0; i < nch; i++) REQUIRE(int(i) == rx.add(p.fds[i][0]));
+    REQUIRE(-1 == rx.add(p.fds[0][0]));
+
+    std::vector<std::vector<std::string>> sent(nch), got(nch);
+    for (int round = 0; round < 20; round++) {
+        for (size_t i = 0; i < nch; i++) {
+            // payloads with special characters, written in two pieces split at varying points
+            std::string payload = std::to_string(i) + ":" + std::to_string(round) + std::string(1, char(0xC0)) + "x" +
+                                  std::string(round % 5, char(0xDB));
+            std::string f = frame_of(payload);
+            size_t cut    = (round + i) % f.size();
+            p.write_all(i, f.substr(0, cut));
+            p.write_all(i, f.substr(cut));
+            sent[i].push_back(payload);
+        }
+        if (round % 4 == 3) collect(rx, got, (round + 1) * nch);
+    }
+    collect(rx, got, 20 * nch);
+    for (size_t i = 0; i < nch; i++) {
+        REQUIRE(sent[i] == got[i]);
+        REQUIRE(20 == rx.frames(i));
+        REQUIRE(rx.is_open(i));
+    }
+}
+
+TEST_CASE("uring reader closes channels at end of file", "[uring-02]") {
+    uring_reader<> rx(2, 64);
+    if (!rx.ok()) {
+        WARN("io_uring is not available");
+        return;
+    }
+    pipes p(2);
+    rx.add(p.fds[0][0]);
+    rx.add(p.fds[1][0]);
+    p.write_all(0, frame_of("one") + "tw");
+    p.write_all(1, frame_of("a"));
+    std::vector<std::vector<std::string>> got(2);
+    collect(rx, got, 2);
+    p.write_all(0, "o");
+    p.close_writer(0);
+    while (rx.is_open(0) && rx.wait(1000)) {
+        decltype(rx)::frame f;
+        while (rx.next(f)) got[f.channel].push_back(std::string(reinterpret_cast<const char*>(f.data), f.size));
+    }
+    REQUIRE(!rx.is_open(0));
+    REQUIRE(0 == rx.error(0));
+    REQUIRE(rx.is_open(1));
+    REQUIRE(1 == rx.open_channels());
+    REQUIRE((std::vector<std::string>{"one", "two"}) == got[0]); // the last frame has no END
+    REQUIRE((std::vector<std::string>{"a"}) == got[1]);
+}
+
+TEST_CASE("uring reader drops oversized and badly escaped frames", "[uring-03]") {
+    uring_reader<> rx(1, 16);
+    if (!rx.ok()) {
+        WARN("io_uring is not available");
+        return;
+    }
+    pipes p(1);
+    rx.add(p.fds[0][0]);
+    std::vector<std::vector<std::string>> got(1);
+    p.write_all(0, frame_of(std::string(40, 'z')));
+    p.write_all(0, std::string("ab\xDB\x01") + char(0xC0));
+    p.write_all(0, frame_of("ok"));
+    collect(rx, got, 1);
+    REQUIRE((std::vector<std::string>{"ok"}) == got[0]);
+    REQUIRE(1 == rx.oversized(0));
+    REQUIRE(1 == rx.errors(0));
+}
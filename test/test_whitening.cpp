@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022 MIT.  All rights reserved.
+ */
+
+#include "hrslip.h"
+#include <catch.hpp>
+#include <SlipInPlace.h>
+#include <SlipWhitening.h>
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+ * INCLUDE/MAIN
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+using namespace slip;
+
+TEST_CASE("whitening key choice and round trip", "[whiten-01]") {
+    using wenc = whitening_encoder<encoder>;
+    using wdec = whitening_decoder<decoder>;
+
+    // no specials: key 0, one extra character
+    const char* plain = "Lorus";
+    REQUIRE(0 == wenc::choose_key(plain, 5));
+    REQUIRE(7 == wenc::encoded_size(plain, 5));
+
+    // samples crowded on END and ESC: whitened frame is shorter than plain SLIP
+    std::vector<uint8_t> src;
+    for (int i = 0; i < 200; i++) src.push_back(i % 3 ? 0xC0 : 0xDB);
+    size_t esize = wenc::encoded_size(src.data(), src.size());
+    REQUIRE(esize == 1 + src.size() + 1);
+    REQUIRE(esize < encoder::encoded_size(src.data(), src.size()));
+    uint8_t key = wenc::choose_key(src.data(), src.size());
+    REQUIRE((0xC0 ^ key) != 0xC0);
+    REQUIRE((0xC0 ^ key) != 0xDB);
+
+    std::vector<uint8_t> enc(esize);
+    REQUIRE(esize == wenc::encode(enc.data(), enc.size(), src.data(), src.size()));
+    REQUIRE(0xC0 == enc.back());
+    REQUIRE(src.size() == wdec::decoded_size(enc.data(), enc.size()));
+    std::vector<uint8_t> dec(src.size());
+    REQUIRE(src.size() == wdec::decode(dec.data(), dec.size(), enc.data(), enc.size()));
+    REQUIRE(src == dec);
+
+    // in place both ways
+    std::vector<uint8_t> buf(src);
+    buf.resize(esize);
+    REQUIRE(esize == wenc::encode(buf.data(), buf.size(), buf.data(), src.size()));
+    REQUIRE(enc == buf);
+    REQUIRE(src.size() == wdec::decode(buf.data(), buf.size(), buf.data(), buf.size()));
+    buf.resize(src.size());
+    REQUIRE(src == buf);
+
+    // too small
+    REQUIRE(0 == wenc::encode(enc.data(), esize - 1, src.data(), src.size()));
+    REQUIRE(0 == wdec::decode(dec.data(), dec.size() - 1, enc.data(), enc.size()));
+}
+
+TEST_CASE("whitening with escaped key and null codec", "[whiten-02]") {
+    using wenc = whitening_encoder<encoder_hrnull>;
+    using wdec = whitening_decoder<decoder_hrnull>;
+
+    // every byte but one is special under key 0
+    std::string src = "###^^^000a";
+    size_t esize = wenc::encoded_size(src.data(), src.size());
+    REQUIRE(esize < encoder_hrnull::encoded_size(src.data(), src.size()));
+
+    std::string enc(esize, ' ');
+    REQUIRE(esize == wenc::encode(&enc[0], enc.size(), src.data(), src.size()));
+    REQUIRE('#' == enc.back());
+    REQUIRE(std::string::npos == enc.substr(0, esize - 1).find('#'));
+    REQUIRE(std::string::npos == enc.find('0'));
+
+    std::string dec(src.size(), ' ');
+    REQUIRE(src.size() == wdec::decode(&dec[0], dec.size(), enc.data(), enc.size()));
+    REQUIRE(src == dec);
+
+    // a key that is itself special goes out escaped
+    std::string keyed = "^D#";
+    REQUIRE(0 == wdec::decode(&dec[0], dec.size(), keyed.data(), keyed.size())); // key only, empty payload
+    REQUIRE(0 == wdec::decode(&dec[0], dec.size(), "^x#", 3));                   // bad escape
+}